@@ -0,0 +1,49 @@
+/**
+ * @authors Jiwoong "Alex" Choi
+ * @date 2024.12.11
+ * @file allocation_counter.cpp
+ * @brief global operator new/delete that count every heap allocation, see allocation_count() in ocean.hpp
+ */
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/// @brief number of heap allocations since program start
+std::atomic<std::size_t> allocation_counter{0};
+
+/**
+ * @brief number of heap allocations made so far by the whole program
+ * @return allocation count, take the difference of two calls to count the allocations in between
+ */
+std::size_t allocation_count() {
+    return allocation_counter.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) {
+    allocation_counter.fetch_add(1, std::memory_order_relaxed);
+    // malloc(0) may return nullptr, but operator new must return a unique pointer:
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
@@ -1,685 +1,693 @@
 /**
  * @authors Jiwoong "Alex" Choi
  * @date 2024.12.11
+ * @file ocean.cpp
+ * @brief command line front end of the ocean simulation, see ocean.hpp
  */
-#include <iostream>
-using std::cout, std::cin;
-
-// for 2d grid representation
-#include <vector>
-using std::vector;
-
-/// for visualization of ocean - cursor control in terminal window
-#include <cstdio> 
-
-/// for random number generation
-#include <random>
-
-// For seeding with time & sleep
-#include <chrono>
-
-//  for sleep to simulate grid update
-#include <thread> 
-
-#include <variant>
-using std::variant, std::monostate;
-
-#include <tuple>
-using std::tuple;
-
-#include <optional>
-using std::optional, std::nullopt;
-
-#include <map>
-using std::map;
-
-#include <algorithm>
-
+#include "ocean.hpp"
 
 /**
- * ***********************************************************************************************************************************************************************
- * SECTION - Random Number Generators
- * @section RandomNumberGenerators Random Number Generators
- * This section contains functions for generating random integers and floats.
- * ***********************************************************************************************************************************************************************
+ * @brief command line options of the ocean executable
  */
-/**
- * @brief random integer generator within defined range
- * @param min the lowest value that random number can be, default 0
- * @param max the highest value that random number can be, default 1
- * @return int a random integer between min and max, inclusive [min, max]
- * @details this function seeds with random_device and then uses static RNG to ensure randomness
- */
-int random_int(int min = 0, int max = 1) {
-    // seed the generator using random device (static reduces computation time and overhead)
-    static std::random_device random_device;
-    /// @brief create the STATIC engine that's shared by all function invocations
-    /// @details the engine has to be static for all function calls, otherwise the generator gets recreated every time, leading to a sequence of identical seed numbers
-    static std::default_random_engine static_engine( random_device() );
-    // apply distribution to the generator
-    std::uniform_int_distribution<int> distribution(min, max);
-    // finally return the random int
-    return distribution(static_engine);
+struct Options {
+    bool headless{false}; ///< skip rendering and sleeping, report throughput instead
+    int rows{70}; ///< number of rows in the grid
+    int cols{70}; ///< number of columns in the grid
+    int turtles{40}; ///< turtle population
+    int trash{40}; ///< trash population
+    int ships{14}; ///< ship population
+    int steps{100}; ///< number of steps to simulate
+    int step_ms{500}; ///< wall-clock milliseconds per step of the interactive run
+    int fps{30}; ///< most frames per second drawn by the interactive run
+    int threads{1}; ///< number of threads that update the grid
+    int tile{64}; ///< edge length of the square tiles the grid is split into
+    Ocean::Engine engine{Ocean::Engine::Tiled}; ///< engine that updates the grid
+    GridLayout layout{GridLayout::Byte}; ///< memory layout of the grid
+    SimdLevel simd{supported_simd_level()}; ///< vector kernel of the tiled engine, lowered to what the CPU runs
+    optional<Ocean::Boundary> boundary{nullopt}; ///< boundary policy, reflecting or the checkpoint's if not given
+    optional<std::uint64_t> seed{nullopt}; ///< seed for the setup and step random numbers, random_device if not given
+    std::string load_checkpoint; ///< checkpoint to start from instead of a random grid, empty for none
+    std::string save_checkpoint; ///< checkpoint file to write, empty for none
+    int checkpoint_every{0}; ///< write save_checkpoint every this many steps, 0 only at the end of the run
+    std::string trajectory; ///< trajectory file to record every step to, empty for none
+    int keyframe_every{100}; ///< key frame interval of the trajectory
+    bool compress{false}; ///< PackBits-compress trajectory frames
+    int ensemble{0}; ///< number of replicas of an ensemble run, 0 for a single run
+    std::string metrics; ///< file to export step metrics to, .json/.jsonl for JSON Lines, CSV otherwise
+    int metrics_every{1}; ///< steps summed into one exported metrics row
+    std::string analytics; ///< file to write the per-step trash cluster and turtle distance summaries to, empty for none
+    bool sweep{false}; ///< run a parameter sweep over the value lists below
+    int replicas{10}; ///< runs per sweep point
+    int steady_window{100}; ///< sweep runs stop after this many steps without population change, 0 never
+    std::vector<float> turtle_idle; ///< turtle idle chances, one value for a single run, a list for a sweep
+    std::vector<float> trash_idle; ///< trash idle chances
+    std::vector<float> ship_idle; ///< ship idle chances
+    std::vector<double> turtle_density; ///< initial turtle densities
+    std::vector<double> trash_density; ///< initial trash densities
+    std::vector<double> ship_density; ///< initial ship densities
+    int patches{0}; ///< patch centers of the species in patch_species, 0 spreads every species uniformly
+    double patch_radius{8.}; ///< standard deviation of the distance from a patch center, in cells
+    std::array<bool, 3> patch_species{false, true, false}; ///< species placed in patches, indexed by Ocean::Occupy
+    int mean_field{0}; ///< block size of the mean-field engine, 0 runs the agents
+    bool validate{false}; ///< with mean_field or processes, also run the agents in this process from the same grid and compare
+    int processes{0}; ///< processes of a decomposed run, one strip of rows each, 0 runs in this process only
 };
 
 /**
- * @brief random float generator within defined range
- * @param min the lowest value that random number can be, default 0.0
- * @param max the highest value that random number can be, default 1.0
- * @return float a random float between min (inclusive) and max(exclusive), [min, max)
- * @details this function seeds with random_device and then uses static RNG to ensure randomness
+ * @brief parses a comma separated list of numbers, e.g. "0.1,0.2,0.5"
+ * @throws std::invalid_argument if an entry isn't a number
  */
-float random_float(float min = 0.f, float max = 1.f) {
-    // seed the generator using random device (static reduces computation time and overhead)
-    static std::random_device random_device;
-    /// @brief create the STATIC engine that's shared by all function invocations
-    /// @details the engine has to be static for all function calls, otherwise the generator gets recreated every time, leading to a sequence of identical seed numbers
-    static std::default_random_engine static_engine( random_device() );
-    // apply distribution to the generator
-    std::uniform_real_distribution<float> distribution(min, max);
-    // finally return the random float
-    return distribution(static_engine);
-};
+template <class T>
+std::vector<T> parse_list(const std::string& value) {
+    std::vector<T> list;
+    std::size_t begin = 0;
+    while (begin <= value.size()) {
+        std::size_t end = value.find(',', begin);
+        if (end == std::string::npos) {
+            end = value.size();
+        }
+        list.push_back(static_cast<T>(std::stod(value.substr(begin, end - begin))));
+        begin = end + 1;
+    }
+    return list;
+}
 
 /**
- * ***********************************************************************************************************************************************************************
- * SECTION - class Ocean
- * @section OceanClass class Ocean
- * This section contains memebrs for Ocean class
- * ***********************************************************************************************************************************************************************
+ * @brief parses a comma separated list of species names, e.g. "turtle,trash"
+ * @return a flag per species, indexed by Ocean::Occupy
+ * @throws std::invalid_argument if a name isn't turtle, trash or ship
  */
+std::array<bool, 3> parse_species(const std::string& value) {
+    std::array<bool, 3> species{false, false, false};
+    std::size_t begin = 0;
+    while (begin <= value.size()) {
+        std::size_t end = value.find(',', begin);
+        if (end == std::string::npos) {
+            end = value.size();
+        }
+        const std::string name = value.substr(begin, end - begin);
+        if (name == "turtle") species[static_cast<int>(Ocean::Occupy::Turtle)] = true;
+        else if (name == "trash") species[static_cast<int>(Ocean::Occupy::Trash)] = true;
+        else if (name == "ship") species[static_cast<int>(Ocean::Occupy::Ship)] = true;
+        else throw std::invalid_argument("unknown species " + name);
+        begin = end + 1;
+    }
+    return species;
+}
+
 /**
- * @class Ocean
- * @brief 2d cellular representation of ocean with objects
+ * @brief the initial placement asked for on the command line
  */
-class Ocean {
-    public: // @todo later change to private/protected
-        /// @var int num_turtles
-        /// @brief Population of turtles in the simulation.
-        int num_turtle{0};
-        
-        /// @var int num_trashes
-        /// @brief Amount of trash present in the simulation.
-        int num_trash{0};
-        
-        /// @var int num_ships
-        /// @brief Number of ships involved in the simulation.
-        int num_ship{0};
-
-    
-    public:
-        /// @enum Occupy
-        /// @brief textual description of what's in the cell instead of "magic numbers"
-        enum class Occupy {
-            Empty = -1, ///< Represents an invalid state.
-            Turtle = 0, ///< Represents a turtle.
-            Trash = 1, ///< Represents a trash.
-            Ship = 2 ///< Represents a ship.
-        };
+Ocean::Placement placement_of(const Options& options) {
+    Ocean::Placement placement;
+    for (int species = 0; species < 3; ++species) {
+        if (options.patches > 0 and options.patch_species[species]) {
+            placement.distributions[species] = Ocean::Distribution::Patches;
+        }
+    }
+    placement.patches = std::max(options.patches, 1);
+    placement.patch_radius = options.patch_radius;
+    return placement;
+}
 
-        /// @var vector<int> grid
-        /// @brief Represents the 2D grid used in the simulation.
-        /// @details this stores pointers to objects in the ocean
-        std::vector<int> grid;
-        
-        /// @var int num_rows
-        /// @brief Total number of rows in the 2D grid.
-        int num_rows{0};
-        
-        /// @var int num_cols
-        /// @brief Total number of columns in the 2D grid.
-        int num_cols{0};
-        
-        /// @var int num_cells
-        /// @brief Total number of cells in the 2D grid, calculated as num_rows * num_cols.
-        int num_cells{0};
+/**
+ * @brief prints the command line usage of the ocean executable
+ * @param program name of the executable, argv[0]
+ */
+void print_usage(const char* program) {
+    std::cerr << "usage: " << program << " [--headless] [--rows R] [--cols C] [--turtles N] [--trash N] [--ships N] [--steps N] [--seed S] [--threads N] [--tile N] [--engine tiled|sparse|kinetic] [--layout int|byte|bitboard|chunked]"
+              << " [--simd auto|scalar|avx2|avx512]"
+              << " [--boundary reflecting|periodic|absorbing]"
+              << " [--load-checkpoint FILE] [--save-checkpoint FILE] [--checkpoint-every N]"
+              << " [--trajectory FILE] [--keyframe-every N] [--compress] [--step-ms N] [--fps N] [--ensemble N] [--metrics FILE] [--metrics-every N] [--analytics FILE]"
+              << " [--turtle-idle P] [--trash-idle P] [--ship-idle P] [--turtle-density P] [--trash-density P] [--ship-density P]"
+              << " [--patches N] [--patch-radius R] [--patch-species turtle,trash,ship]"
+              << " [--sweep [--replicas N] [--steady-window N]] [--mean-field B [--validate]] [--processes N [--validate]]\n"
+              << "with --sweep, the idle and density options take comma separated lists of values\n";
+}
 
-        /**
-        * @brief Constructor for Ocean grid object
-        * @param m row size
-        * @param n column size
-        * @param _turtles turtle population
-        * @param _trash trash population
-        * @param _ships ship population
-        * @return creates an ocean object with above parameters
-        */
-        Ocean(int rows, int cols, int _turtles, int _trash, int _ships) : num_rows(rows), num_cols(cols), num_turtle(_turtles), num_trash(_trash), num_ship(_ships) {
-            /// update number of cells
-            this->num_cells = num_rows * num_cols;
-            /// consequenlty, update the grid vector size:
-            this->grid.resize(num_cells);
-        };
-        /**
-        * @brief Copy Constructor of Ocean Object
-        * @param m row size
-        * @param n column size
-        * @param _turtles turtle population
-        * @param _trash trash population
-        * @param _ships ship population
-        * @return creates a copied ocean object with above parameters
-        */
-        
-        /**
-        * @brief setter for a specific cell
-        * @param ocean the current object Ocean that this method is acting upon
-        * @param i index of row, starting at 0
-        * @param j index of column, starting at 0
-        * @param value value to update that cell
-        */
-        void set_cell(int i, int j, Ocean::Occupy value) {
-            this->grid.at(i * num_cols + j) = static_cast<int>(value);
+/**
+ * @brief parses the command line into Options
+ * @param argc argument count from main
+ * @param argv argument values from main
+ * @return parsed Options, or nullopt if an argument is unknown or malformed
+ */
+optional<Options> parse_options(int argc, char* argv[]) {
+    Options options;
+    for (int a = 1; a < argc; ++a) {
+        std::string arg = argv[a];
+        if (arg == "--headless") {
+            options.headless = true;
+            continue;
         }
-        /**
-        * @brief getter for a specific cell
-        * @param ocean the current object Ocean that this method is acting upon
-        * @param i index of row, starting at 0
-        * @param j index of column, starting at 0
-        * @return cell state in Occupy enum;
-        */
-        Ocean::Occupy get_cell(int i, int j) {
-            return static_cast<Ocean::Occupy>(this->grid.at(i * num_cols + j));
+        if (arg == "--compress") {
+            options.compress = true;
+            continue;
         }
-
-        /**
-        * @brief creates corresponding ASCII character for each occupied state of the cell
-        * @param cell cell's occupied state - empty, turtle, ship, or trash:
-        * @return an ASCII character
-        */
-        char get_ascii(Occupy cell) {
-            // use switch-case to identify corresponding ascii char:
-            switch (cell) {
-                /// empty cell
-                case Occupy::Empty: return ' ';
-                /// turtle cell
-                case Occupy::Turtle: return 'o';
-                /// trash cell
-                case Occupy::Trash: return 'x';
-                /// ship cell
-                case Occupy::Ship: return '|';
-                default:
-                    return '?'; // place holder for possible unknown state
-            };
+        if (arg == "--sweep") {
+            options.sweep = true;
+            continue;
+        }
+        if (arg == "--validate") {
+            options.validate = true;
+            continue;
+        }
+        // every other option takes exactly one value:
+        if (a + 1 >= argc) {
+            return nullopt;
+        }
+        std::string value = argv[++a];
+        try {
+            if (arg == "--rows") options.rows = std::stoi(value);
+            else if (arg == "--cols") options.cols = std::stoi(value);
+            else if (arg == "--turtles") options.turtles = std::stoi(value);
+            else if (arg == "--trash") options.trash = std::stoi(value);
+            else if (arg == "--ships") options.ships = std::stoi(value);
+            else if (arg == "--steps") options.steps = std::stoi(value);
+            else if (arg == "--seed") options.seed = std::stoull(value);
+            else if (arg == "--threads") options.threads = std::stoi(value);
+            else if (arg == "--tile") options.tile = std::stoi(value);
+            else if (arg == "--engine" and value == "tiled") options.engine = Ocean::Engine::Tiled;
+            else if (arg == "--engine" and value == "sparse") options.engine = Ocean::Engine::Sparse;
+            else if (arg == "--engine" and value == "kinetic") options.engine = Ocean::Engine::Kinetic;
+            else if (arg == "--layout" and value == "int") options.layout = GridLayout::Int;
+            else if (arg == "--layout" and value == "byte") options.layout = GridLayout::Byte;
+            else if (arg == "--layout" and value == "bitboard") options.layout = GridLayout::Bitboard;
+            else if (arg == "--layout" and value == "chunked") options.layout = GridLayout::Chunked;
+            else if (arg == "--simd" and value == "auto") options.simd = supported_simd_level();
+            else if (arg == "--simd" and value == "scalar") options.simd = SimdLevel::Scalar;
+            else if (arg == "--simd" and value == "avx2") options.simd = SimdLevel::Avx2;
+            else if (arg == "--simd" and value == "avx512") options.simd = SimdLevel::Avx512;
+            else if (arg == "--boundary" and value == "reflecting") options.boundary = Ocean::Boundary::Reflecting;
+            else if (arg == "--boundary" and value == "periodic") options.boundary = Ocean::Boundary::Periodic;
+            else if (arg == "--boundary" and value == "absorbing") options.boundary = Ocean::Boundary::Absorbing;
+            else if (arg == "--load-checkpoint") options.load_checkpoint = value;
+            else if (arg == "--save-checkpoint") options.save_checkpoint = value;
+            else if (arg == "--checkpoint-every") options.checkpoint_every = std::stoi(value);
+            else if (arg == "--trajectory") options.trajectory = value;
+            else if (arg == "--step-ms") options.step_ms = std::stoi(value);
+            else if (arg == "--ensemble") options.ensemble = std::stoi(value);
+            else if (arg == "--replicas") options.replicas = std::stoi(value);
+            else if (arg == "--metrics") options.metrics = value;
+            else if (arg == "--metrics-every") options.metrics_every = std::stoi(value);
+            else if (arg == "--analytics") options.analytics = value;
+            else if (arg == "--steady-window") options.steady_window = std::stoi(value);
+            else if (arg == "--turtle-idle") options.turtle_idle = parse_list<float>(value);
+            else if (arg == "--trash-idle") options.trash_idle = parse_list<float>(value);
+            else if (arg == "--ship-idle") options.ship_idle = parse_list<float>(value);
+            else if (arg == "--turtle-density") options.turtle_density = parse_list<double>(value);
+            else if (arg == "--trash-density") options.trash_density = parse_list<double>(value);
+            else if (arg == "--ship-density") options.ship_density = parse_list<double>(value);
+            else if (arg == "--fps") options.fps = std::stoi(value);
+            else if (arg == "--keyframe-every") options.keyframe_every = std::stoi(value);
+            else if (arg == "--patches") options.patches = std::stoi(value);
+            else if (arg == "--patch-radius") options.patch_radius = std::stod(value);
+            else if (arg == "--patch-species") options.patch_species = parse_species(value);
+            else if (arg == "--mean-field") options.mean_field = std::stoi(value);
+            else if (arg == "--processes") options.processes = std::stoi(value);
+            else return nullopt;
+        } catch (const std::exception&) {
+            return nullopt;
+        }
+    }
+    // reject sizes that can't make a grid:
+    if (options.rows <= 0 or options.cols <= 0 or options.steps < 0 or options.threads <= 0 or options.tile <= 0 or options.checkpoint_every < 0 or options.keyframe_every <= 0
+        or options.step_ms < 0 or options.fps <= 0 or options.ensemble < 0 or options.replicas <= 0 or options.steady_window < 0
+        or options.metrics_every <= 0 or options.patches < 0 or options.patch_radius < 0. or options.mean_field < 0 or options.processes < 0
+        or (options.validate and options.mean_field == 0 and options.processes == 0)) {
+        return nullopt;
+    }
+    // the dense layouts index cells with ints, so only a chunked agent grid can have more than INT_MAX cells. the mean-field engine alone never builds one.
+    // checkpoints, trajectories, analytics, ensembles, sweeps, decomposed runs and the terminal hold or index every cell, so they stay within INT_MAX cells too:
+    const bool agent_grid = options.mean_field == 0 or options.validate or not options.load_checkpoint.empty();
+    const long long grid_cells = static_cast<long long>(options.rows) * options.cols;
+    if (agent_grid and grid_cells > INT_MAX
+        and (options.layout != GridLayout::Chunked or not options.headless or not options.load_checkpoint.empty() or not options.save_checkpoint.empty()
+             or not options.trajectory.empty() or not options.analytics.empty() or options.ensemble > 0 or options.sweep or options.processes > 0 or options.mean_field > 0
+             or static_cast<std::uint64_t>(grid_cells) >= CounterRng::cell_limit)) {
+        return nullopt;
+    }
+    // probabilities have to be probabilities, and only a sweep takes more than one value:
+    for (const auto* list : {&options.turtle_idle, &options.trash_idle, &options.ship_idle}) {
+        if ((list->size() > 1 and not options.sweep) or std::any_of(list->begin(), list->end(), [](float p) { return p < 0.f or p > 1.f; })) {
+            return nullopt;
+        }
+    }
+    for (const auto* list : {&options.turtle_density, &options.trash_density, &options.ship_density}) {
+        if ((list->size() > 1 and not options.sweep) or std::any_of(list->begin(), list->end(), [](double p) { return p < 0. or p > 1.; })) {
+            return nullopt;
+        }
+    }
+    // the grid is placed with exactly the requested agents, so they have to fit, at every point of a sweep. a checkpoint brings its own:
+    if (options.turtles < 0 or options.trash < 0 or options.ships < 0) {
+        return nullopt;
+    }
+    if (options.load_checkpoint.empty()) {
+        const long long cells = static_cast<long long>(options.rows) * options.cols;
+        // a density overrides the population, rounded like Ocean::cells_for_density():
+        const auto requested = [cells](int population, const std::vector<double>& densities) {
+            return densities.empty() ? population : std::llround(*std::max_element(densities.begin(), densities.end()) * static_cast<double>(cells));
+        };
+        const long long counts[3] = {requested(options.turtles, options.turtle_density), requested(options.trash, options.trash_density),
+                                     requested(options.ships, options.ship_density)};
+        // populations are ints, even on a grid with more cells:
+        if (counts[0] + counts[1] + counts[2] > cells or std::max({counts[0], counts[1], counts[2]}) > INT_MAX) {
+            return nullopt;
         }
+    }
+    return options;
+}
 
-        /**
-         * ***********************************************************************************************************************************************************************
-         * SUB_SECTION - Movement Logics
-         * @subsection ObjectMovement movement logics/definitions
-         * This section contains functions, enum classes that define movement & collision logic for objects
-         * ***********************************************************************************************************************************************************************
-         */
-        public:
-        //protected:
-            /**
-             * @brief class that defines possible directions of an object in a cell
-             * @details numbers for eaiser code writing
-             */
-            enum class Direction {
-                Idle = 0,    // No movement
-                East = 1,      // E
-                North = 2,     // N
-                West = 3,      // W
-                South = 4,     // S
-                NorthEast = 5, // NE
-                NorthWest = 6, // NW
-                SouthEast = 7, // SE
-                SouthWest = 8  // SW
-            };
-            
-            /**
-             * @brief class that defins possible optoins of collision outcome between two objects
-             * @details all of these are written interms of a current object that is moving into a new cell space:
-             */
-            enum class CollisionResult {
-                Move = 1, // moving object successfully moves into new space because there's nothing in new space
-                Die = 2, // movign object dies from collision (e.g. turtle dies after colliding with trash)
-                Block = 0, // moving object encounters same type of object (trash vs trash) or non-threatening object (ship vs turtle) and stays idle
-            };
+/**
+ * @brief runs an ensemble and prints a table of the aggregated populations of every step
+ * @param options command line options, --ensemble replicas of --steps steps
+ * @return exit code
+ * @details the table has one row per step with mean, standard deviation and 95% confidence half width of every population,
+ *          and the fraction of replicas that still have turtles. summary lines start with '#'.
+ */
+int run_ensemble_mode(const Options& options) {
+    EnsembleConfig config;
+    config.rows = options.rows;
+    config.cols = options.cols;
+    config.turtles = options.turtles;
+    config.trash = options.trash;
+    config.ships = options.ships;
+    if (not options.turtle_idle.empty()) config.turtle_idle_chance = options.turtle_idle.front();
+    if (not options.trash_idle.empty()) config.trash_idle_chance = options.trash_idle.front();
+    if (not options.ship_idle.empty()) config.ship_idle_chance = options.ship_idle.front();
+    if (not options.turtle_density.empty()) config.turtle_density = options.turtle_density.front();
+    if (not options.trash_density.empty()) config.trash_density = options.trash_density.front();
+    if (not options.ship_density.empty()) config.ship_density = options.ship_density.front();
+    config.steps = options.steps;
+    config.replicas = options.ensemble;
+    config.seed = options.seed ? *options.seed : random_engine()();
+    config.engine = options.engine;
+    config.boundary = options.boundary.value_or(Ocean::Boundary::Reflecting);
+    config.placement = placement_of(options);
+    config.layout = options.layout;
+
+    ThreadPool pool(options.threads);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<EnsembleStep> steps = run_ensemble(config, pool);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double replica_steps = static_cast<double>(config.replicas) * config.steps;
+
+    std::cout << "# ensemble: " << config.replicas << " replicas of " << config.rows << " x " << config.cols << ", " << config.steps << " steps, seed "
+              << config.seed << ", threads: " << pool.size() << '\n';
+    std::cout << "# elapsed [s]: " << seconds << ", replica-steps/sec: " << replica_steps / seconds
+              << ", cell-updates/sec: " << replica_steps * config.rows * config.cols / seconds << '\n';
+    std::cout << "step turtles_mean turtles_sd turtles_ci95 trash_mean trash_sd trash_ci95 ships_mean ships_sd ships_ci95 turtle_survival\n";
+    for (std::size_t t = 0; t < steps.size(); ++t) {
+        std::cout << t;
+        for (const OnlineStats* stats : {&steps[t].turtles, &steps[t].trash, &steps[t].ships}) {
+            std::cout << ' ' << stats->mean << ' ' << std::sqrt(stats->variance()) << ' ' << stats->ci95();
+        }
+        std::cout << ' ' << steps[t].turtle_survival.mean << '\n';
+    }
+    return EXIT_SUCCESS;
+}
 
-            /**
-             * @brief logic/outcome matrix for collision between two objects.
-             * @details Key: {Moving Object, Existing Object} and Value: Action for Moving Object
-             */
-            std::map<std::pair<Ocean::Occupy, Ocean::Occupy>, Ocean::CollisionResult> collision_logics = {
-                // Turtle encounters an empty space -> It can move.
-                { {Ocean::Occupy::Turtle, Ocean::Occupy::Empty},   Ocean::CollisionResult::Move },
-                // Turtle encounters trash -> It dies.
-                { {Ocean::Occupy::Turtle, Ocean::Occupy::Trash},   Ocean::CollisionResult::Die },
-                // Turtle encounters a ship -> Movement is blocked.
-                { {Ocean::Occupy::Turtle, Ocean::Occupy::Ship},    Ocean::CollisionResult::Die },
-                // Turtle encounters another turtle -> Movement is blocked.
-                { {Ocean::Occupy::Turtle, Ocean::Occupy::Turtle},  Ocean::CollisionResult::Block },
+/**
+ * @brief runs a parameter sweep and prints one row per sweep point
+ * @param options command line options, --steps is the most steps of a run
+ * @return exit code
+ */
+int run_sweep_mode(const Options& options) {
+    SweepConfig config;
+    config.rows = options.rows;
+    config.cols = options.cols;
+    config.steps = options.steps;
+    config.replicas = options.replicas;
+    config.steady_window = options.steady_window;
+    config.seed = options.seed ? *options.seed : random_engine()();
+    config.engine = options.engine;
+    config.boundary = options.boundary.value_or(Ocean::Boundary::Reflecting);
+    config.placement = placement_of(options);
+    config.layout = options.layout;
+    config.turtle_idle_chances = options.turtle_idle;
+    config.trash_idle_chances = options.trash_idle;
+    config.ship_idle_chances = options.ship_idle;
+    config.turtle_densities = options.turtle_density;
+    config.trash_densities = options.trash_density;
+    config.ship_densities = options.ship_density;
+
+    ThreadPool pool(options.threads);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SweepResult> results = run_sweep(config, pool);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double steps_run = 0.;
+    for (const SweepResult& result : results) {
+        steps_run += result.steps.mean * result.replicas;
+    }
+    const double steps_max = static_cast<double>(results.size()) * config.replicas * config.steps;
+    std::cout << "# sweep: " << results.size() << " points x " << config.replicas << " replicas of " << config.rows << " x " << config.cols
+              << ", up to " << config.steps << " steps, seed " << config.seed << ", threads: " << pool.size() << '\n';
+    std::cout << "# elapsed [s]: " << seconds << ", steps simulated: " << steps_run << " of " << steps_max << " (" << 100. * steps_run / std::max(steps_max, 1.) << "%)\n";
+    std::cout << "turtle_idle trash_idle ship_idle turtle_density trash_density ship_density replicas extinct safe steady steps_mean extinction_step_mean turtle_survival_mean\n";
+    for (const SweepResult& result : results) {
+        const SweepPoint& point = result.point;
+        std::cout << point.turtle_idle_chance << ' ' << point.trash_idle_chance << ' ' << point.ship_idle_chance << ' '
+                  << point.turtle_density << ' ' << point.trash_density << ' ' << point.ship_density << ' '
+                  << result.replicas << ' ' << result.extinct << ' ' << result.safe << ' ' << result.steady << ' '
+                  << result.steps.mean << ' ' << result.extinction_step.mean << ' ' << result.turtle_survival.mean << '\n';
+    }
+    return EXIT_SUCCESS;
+}
 
-                // Trash encounters an empty space -> It can move.
-                { {Ocean::Occupy::Trash,  Ocean::Occupy::Empty},   Ocean::CollisionResult::Move },
-                // Trash encounters a turtle -> Movement is blocked.
-                { {Ocean::Occupy::Trash,  Ocean::Occupy::Turtle},  Ocean::CollisionResult::Move },
-                // Trash encounters another trash -> Movement is blocked.
-                { {Ocean::Occupy::Trash,  Ocean::Occupy::Trash},   Ocean::CollisionResult::Block },
-                // Trash encounters a ship -> Movement is blocked.
-                { {Ocean::Occupy::Trash,  Ocean::Occupy::Ship},    Ocean::CollisionResult::Die },
+/**
+ * @brief the starting ocean of a single run: loaded from --load-checkpoint, or a fresh grid placed with the populations, densities and idle chances
+ * @param options command line options
+ * @param pool threads that place the grid, the ocean keeps using them
+ * @throws std::runtime_error if the checkpoint can't be loaded
+ */
+Ocean initial_ocean(const Options& options, ThreadPool& pool) {
+    // build the grid in its final layout right away, so a chunked ocean never exists as a dense grid:
+    Ocean ocean(options.rows, options.cols, options.turtles, options.trash, options.ships, options.layout);
+    // a density overrides the population:
+    if (not options.turtle_density.empty()) ocean.num_turtle = ocean.cells_for_density(options.turtle_density.front());
+    if (not options.trash_density.empty()) ocean.num_trash = ocean.cells_for_density(options.trash_density.front());
+    if (not options.ship_density.empty()) ocean.num_ship = ocean.cells_for_density(options.ship_density.front());
+    ocean.placement = placement_of(options);
+    if (options.boundary) {
+        ocean.set_boundary(*options.boundary);
+    }
+    ocean.set_thread_pool(&pool);
+    if (not options.load_checkpoint.empty()) {
+        // resume: dimensions, populations, step, seed and idle chances all come from the checkpoint
+        ocean = Ocean::load_checkpoint(options.load_checkpoint);
+        ocean.set_thread_pool(&pool);
+    } else {
+        ocean.set_dummy_grid();
+        if (options.seed) {
+            ocean.seed(*options.seed);
+        }
+    }
+    // idle chances given on the command line override the checkpoint's:
+    if (not options.turtle_idle.empty()) ocean.turtle_idle_chance = options.turtle_idle.front();
+    if (not options.trash_idle.empty()) ocean.trash_idle_chance = options.trash_idle.front();
+    if (not options.ship_idle.empty()) ocean.ship_idle_chance = options.ship_idle.front();
+    return ocean;
+}
 
-                // Ship encounters an empty space -> It can move.
-                { {Ocean::Occupy::Ship,   Ocean::Occupy::Empty},   Ocean::CollisionResult::Move },
-                // Ship encounters trash -> It survives and remains functional.
-                { {Ocean::Occupy::Ship,   Ocean::Occupy::Trash},   Ocean::CollisionResult::Move },
-                // Ship encounters another ship -> Movement is blocked.
-                { {Ocean::Occupy::Ship,   Ocean::Occupy::Ship},    Ocean::CollisionResult::Block },
-                // Ship encounters a turtle -> Movement is blocked.
-                { {Ocean::Occupy::Ship,   Ocean::Occupy::Turtle},  Ocean::CollisionResult::Move}
-            };
+/**
+ * @brief runs the mean-field engine and prints its populations, and with --validate the agents' next to them
+ * @param options command line options, --mean-field is the block size
+ * @return exit code
+ * @details without --validate or --load-checkpoint no agent grid is built, so any size fits: the fields start out uniform with the
+ *          populations or densities of the options. otherwise they start from the coarse-grained agent grid, patches included.
+ *          a row is printed every tenth of the run, summary lines start with '#'.
+ */
+int run_mean_field_mode(const Options& options) {
+    ThreadPool pool(options.threads);
+    optional<Ocean> agents;
+    optional<DensityOcean> fields;
+    try {
+        if (options.validate or not options.load_checkpoint.empty()) {
+            agents.emplace(initial_ocean(options, pool));
+            agents->set_tile_size(options.tile, options.tile);
+            agents->set_engine(options.engine);
+            agents->set_simd(options.simd);
+            agents->set_grid_layout(options.layout);
+            if (options.boundary) {
+                agents->set_boundary(*options.boundary);
+            }
+            fields.emplace(*agents, options.mean_field);
+        } else {
+            fields.emplace(options.rows, options.cols, options.mean_field);
+            const double cells = static_cast<double>(options.rows) * options.cols;
+            fields->set_idle_chances(options.turtle_idle.empty() ? 1.f / 9.f : options.turtle_idle.front(),
+                                     options.trash_idle.empty() ? 0.5f : options.trash_idle.front(),
+                                     options.ship_idle.empty() ? 0.2f : options.ship_idle.front());
+            fields->fill(Ocean::Occupy::Turtle, options.turtle_density.empty() ? std::min(options.turtles / cells, 1.) : options.turtle_density.front());
+            fields->fill(Ocean::Occupy::Trash, options.trash_density.empty() ? std::min(options.trash / cells, 1.) : options.trash_density.front());
+            fields->fill(Ocean::Occupy::Ship, options.ship_density.empty() ? std::min(options.ships / cells, 1.) : options.ship_density.front());
+            fields->boundary = options.boundary.value_or(Ocean::Boundary::Reflecting);
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    if (not options.validate) {
+        agents.reset();
+    }
+    fields->pool = &pool;
+
+    std::cout << "# mean-field: " << fields->lattice_rows << " x " << fields->lattice_cols << " blocks of " << fields->block << " x " << fields->block
+              << " cells for " << fields->num_rows << " x " << fields->num_cols << ", threads: " << pool.size() << '\n';
+    std::cout << (agents ? "step turtles trash ships agent_turtles agent_trash agent_ships distance\n" : "step turtles trash ships\n");
+    auto print_row = [&] {
+        std::cout << fields->step << ' ' << fields->population(Ocean::Occupy::Turtle) << ' ' << fields->population(Ocean::Occupy::Trash) << ' '
+                  << fields->population(Ocean::Occupy::Ship);
+        if (agents) {
+            std::cout << ' ' << agents->num_turtle << ' ' << agents->num_trash << ' ' << agents->num_ship << ' ' << fields->distance(*agents);
+        }
+        std::cout << '\n';
+    };
 
-            /**
-             * @brief performs collision logic between two objects and updates the cell
-             * @param i row index of 
-             * @param j column index
-             * @param direction the direction which the object will move to 
-             * @param moving_obj the object that is trying to move to new (i, j) coordinate
-             * @param arg_grid grid to work with. can be grid or temp_grid
-             * @return tuple of {curr_i, curr_j, moving_obj, new_i, new_j, colliding_obj}
-             */
-            std::tuple<int, int, Occupy, int, int, Occupy> collision(int i, int j, int new_i, int new_j, Occupy moving_obj, const std::vector<int>& arg_grid) {
-                // get the object existing at the new location that will "crash" with moving_obj
-                Occupy existing_obj = static_cast<Occupy>(arg_grid[new_i * num_cols + new_j]);
+    const int report_every = std::max(options.steps / 10, 1);
+    double field_seconds = 0., agent_seconds = 0.;
+    print_row();
+    for (int t = 1; t <= options.steps; ++t) {
+        auto start = std::chrono::steady_clock::now();
+        fields->update_grid();
+        field_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (agents) {
+            start = std::chrono::steady_clock::now();
+            agents->update_grid();
+            agent_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        if (t % report_every == 0 or t == options.steps) {
+            print_row();
+        }
+    }
+    const double cell_updates = static_cast<double>(options.steps) * fields->num_rows * fields->num_cols;
+    std::cout << "# elapsed [s]: " << field_seconds << ", steps/sec: " << options.steps / field_seconds << ", cell-updates/sec: " << cell_updates / field_seconds << '\n';
+    if (agents) {
+        std::cout << "# agents elapsed [s]: " << agent_seconds << ", speedup: " << agent_seconds / field_seconds << '\n';
+    }
+    return EXIT_SUCCESS;
+}
 
-                CollisionResult collision_outcome = collision_logics[{moving_obj, existing_obj}];
+/**
+ * @brief runs the ocean on --processes processes, one strip of rows each, and with --validate checks the result against this process
+ * @param options command line options
+ * @return exit code, EXIT_FAILURE also if the validation finds a difference
+ */
+int run_decomposed_mode(const Options& options) {
+    if (options.engine == Ocean::Engine::Kinetic) {
+        std::cerr << "the decomposed run uses the tiled engine's rules, it can't stand in for the kinetic engine\n";
+        return EXIT_FAILURE;
+    }
+    ThreadPool pool(options.threads);
+    optional<Ocean> initial;
+    DecomposedRun run;
+    try {
+        initial.emplace(initial_ocean(options, pool));
+        if (options.boundary) {
+            initial->set_boundary(*options.boundary);
+        }
+        run = run_decomposed(*initial, options.processes, options.steps);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    Ocean& ocean = *initial;
+    const double cell_updates = static_cast<double>(options.steps) * ocean.num_cells;
+    std::cout << "grid: " << ocean.num_rows << " x " << ocean.num_cols << ", processes: " << options.processes << '\n';
+    std::cout << "final step: " << ocean.step + options.steps << '\n';
+    std::cout << "final population - turtles: " << run.population[0] << " trash: " << run.population[1] << " ships: " << run.population[2] << '\n';
+    std::cout << "elapsed [s]: " << run.seconds << '\n';
+    std::cout << "steps/sec: " << options.steps / run.seconds << '\n';
+    std::cout << "cell-updates/sec: " << cell_updates / run.seconds << '\n';
+    if (not options.validate) {
+        return EXIT_SUCCESS;
+    }
 
-                // start performing collision logics:
-                switch (collision_outcome) {
-                    // Case 1 - moving_obj can proceed to moving into new cell:
-                    case CollisionResult::Move:
-                        // current cell becomes empty and new cell becomes the moving_obj:
-                        return{i, j, Occupy::Empty, new_i, new_j, moving_obj};
-                    
-                    // Case 2 - moving_obj dies:
-                    case CollisionResult::Die:
-                        // current cell becomes empty:
-                        // new cell remains the same
-                        return{i, j, Occupy::Empty, new_i, new_j, existing_obj};
+    // the same steps in this process, with the engine, layout and threads of the options:
+    ocean.set_tile_size(options.tile, options.tile);
+    ocean.set_engine(options.engine);
+    ocean.set_simd(options.simd);
+    ocean.set_grid_layout(options.layout);
+    Ocean::RunStats stats = ocean.run_headless(options.steps);
+    std::size_t mismatches = 0;
+    for (std::size_t cell = 0; cell < run.grid.size(); ++cell) {
+        mismatches += run.grid[cell] != ocean.grid.get(cell);
+    }
+    const bool same_population = run.population == std::array<int, 3>{ocean.num_turtle, ocean.num_trash, ocean.num_ship};
+    std::cout << "single process elapsed [s]: " << stats.seconds << ", speedup: " << stats.seconds / run.seconds << '\n';
+    std::cout << "validation: " << mismatches << " cells differ, populations " << (same_population ? "match" : "differ") << '\n';
+    return mismatches == 0 and same_population ? EXIT_SUCCESS : EXIT_FAILURE;
+}
 
-                    case CollisionResult::Block:
-                    // Case 2 - moving_obj's move is Blocked:
-                        // new_cell and old_cell all remain the same:
-                        return{i, j, moving_obj, new_i, new_j, existing_obj};
+int main(int argc, char* argv[]) {
 
-                    default:
-                        return{i, j, moving_obj, i, j, moving_obj};
-                }
-            };
+    optional<Options> options = parse_options(argc, argv);
+    if (not options) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (options->layout == GridLayout::Chunked and options->engine != Ocean::Engine::Tiled) {
+        std::cerr << "the chunked layout only runs with the tiled engine\n";
+        return EXIT_FAILURE;
+    }
+    if (options->sweep) {
+        return run_sweep_mode(*options);
+    }
+    if (options->ensemble > 0) {
+        return run_ensemble_mode(*options);
+    }
+    if (options->seed) {
+        seed_random(static_cast<unsigned int>(*options->seed));
+    }
+    if (options->mean_field > 0) {
+        return run_mean_field_mode(*options);
+    }
+    if (options->processes > 0) {
+        return run_decomposed_mode(*options);
+    }
 
+    // the placement runs on the pool too:
+    ThreadPool pool(options->threads);
+    optional<Ocean> initial;
+    try {
+        initial.emplace(initial_ocean(*options, pool));
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    Ocean& ocean = *initial;
+    ocean.set_tile_size(options->tile, options->tile);
+    ocean.set_engine(options->engine);
+    ocean.set_simd(options->simd);
+    ocean.set_grid_layout(options->layout);
+    if (options->boundary) {
+        ocean.set_boundary(*options->boundary);
+    }
+    ocean.set_thread_pool(&pool);
+
+    // export the step metrics, if asked for:
+    std::unique_ptr<MetricsWriter> metrics;
+    if (not options->metrics.empty()) {
+        try {
+            metrics = std::make_unique<MetricsWriter>(options->metrics, options->metrics_every);
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    // and the spatial analytics:
+    std::unique_ptr<AnalyticsWriter> analytics;
+    if (not options->analytics.empty()) {
+        try {
+            analytics = std::make_unique<AnalyticsWriter>(options->analytics, ocean);
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << '\n';
+            return EXIT_FAILURE;
+        }
+    }
 
-            /**
-             * @brief updates coordinate to move the object to the desired position
-             * @param i row index
-             * @param j column index
-             * @param direction the direction which the object will move to 
-             * @param object the Occupy obejct in the cell
-             */
-            std::tuple<int, int, Occupy, int, int, Occupy> move(int i, int j, Occupy object, Direction direction) {
-                // Exit early if the direction is Origin (no movement) or if object is empty
-                if (direction == Direction::Idle or object == Occupy::Empty) {
-                    return{i, j, object, i, j, object};
-                }
-                // Initialize new x and y coordinates
-                int new_i = i, new_j = j;
-                
-                // Determine the new coordinates based on the direction
-                // BE CAREFUL: the (i, j) coordinates are (-y, x) in our case, so be careful
-                // @details for example, "moving East" in our printed grid is increasing j index
-                switch (direction) {
-                    case Direction::East: // East
-                        new_j++;
-                        break;
-                    case Direction::North: // North
-                        new_i--;
-                        break;
-                    case Direction::West: // West
-                        new_j--;
-                        break;
-                    case Direction::South: // South
-                        new_i++;
-                        break;
-                    case Direction::NorthEast: // North-East
-                        new_i--; 
-                        new_j++;
-                        break;
-                    case Direction::NorthWest: // North-West
-                        new_i--;
-                        new_j--;
-                        break;
-                    case Direction::SouthEast: // South-East
-                        new_i++;
-                        new_j++;
-                        break;
-                    case Direction::SouthWest: // South-West
-                        new_i++;
-                        new_j--;
-                        break;
-                    default: break; // handles Origin case
+    if (not options->headless) {
+        std::function<void(Ocean&)> record_metrics = nullptr;
+        if (metrics or analytics) {
+            record_metrics = [&](Ocean& _ocean) {
+                if (metrics) {
+                    metrics->record(_ocean);
                 }
-                // Check for out-of-bounds movement: if the new position is invalid, return early
-                if (new_i < 0 or new_i >= num_rows or new_j < 0 or new_j >= num_cols) {
-                    // cout << "new coordinate out of bounds" << '\n';
-                    return {i, j, object, i, j, object};
+                if (analytics) {
+                    analytics->record(_ocean);
                 }
-
-                // If within bounds, finish the moving logic with collision logic:
-                return this->collision(i, j, new_i, new_j, object, this->grid);
-            };
-        
-        public:
-        //protected:
-            /**
-             * @brief generates random direction based on the user-defined probability for object staying idle
-             * @param idle_chance the probability that object stays idle
-             * @return random integer that corresponds to one of the moves in class Direction based on user-set parameters of probability
-             */
-            Ocean::Direction random_direction(float idle_chance = (1. / 9.f)) {
-                // in total we have 9 moves total, with 1 move being idle and rest of 8 moves being active
-                // based on the given idle_chance, we return corresponding move with pre-defined probabilities
-                float random_num = random_float(0.0, 1.); // 100% percentage pdf
-                
-                // simulate idle_chance probability:
-                if (random_num < idle_chance) {
-                    // if probability satisfies, return Idle:
-                    return Ocean::Direction::Idle;
-                } else {
-                    // rest of the probability, return one of the active moves:
-                    return static_cast<Ocean::Direction>(random_int(1, 8));
-                }
-            }
-
-            /**
-             * @brief generates movement for a turtle on the ocean grid
-             * @details all moves have equal chance of being executed from enum class Direction
-             * @param i row index
-             * @param j column index
-             */
-            std::tuple<int, int, Occupy, int, int, Occupy> turtle_move (int i, int j) {
-                // use random_direction () function with default prob of 1 / 9.
-                //this->move(i, j, Occupy::Turtle, this->random_direction());
-                return this->move(i, j, Occupy::Turtle, this->random_direction());
             };
-            
-            /**
-             * @brief generates movement for a trash on the ocean grid
-             * @details 50% chance of staying idle and 50% of moving in any random direction
-             * @param i row index
-             * @param j column index
-             */
-            std::tuple<int, int, Occupy, int, int, Occupy> trash_move (int i, int j) {
-                // use random_direction () function with idle prob of 50%.
-                //this->move(i, j, Occupy::Trash, this->random_direction(0.5f));
-                return this->move(i, j, Occupy::Trash, this->random_direction(0.5f));
+        }
+        ocean.update(options->steps, std::chrono::milliseconds(options->step_ms), std::chrono::milliseconds(1000 / options->fps), record_metrics);
+        return EXIT_SUCCESS;
+    }
 
-            };
-            /**
-             * @brief generates movement for a ship on the ocean grid
-             * @details 20% chance of staying idle and 80% of moving in any random direction
-             * @param i row index
-             * @param j column index
-             */        
-            std::tuple<int, int, Occupy, int, int, Occupy> ship_move (int i, int j) {
-                // use random_direction () function with idle prob of 20%.
-                //this->move(i, j, Occupy::Ship, this->random_direction(0.2f));
-                return this->move(i, j, Occupy::Ship, this->random_direction(0.2f));
-            };
+    // headless batch run: no rendering, no sleeping, only throughput numbers
+    auto [turtle, trash, ship] = ocean.population(ocean.grid);
+    std::cout << "grid: " << ocean.num_rows << " x " << ocean.num_cols << ", threads: " << pool.size() << ", tiles: " << ocean.tiles.size() + ocean.chunk_tiles.size() << ", simd: " << simd_level_name(ocean.simd) << '\n';
+    std::cout << "initial population - turtles: " << turtle << " trash: " << trash << " ships: " << ship << '\n';
+
+    // record every step to the trajectory, if asked for:
+    std::unique_ptr<TrajectoryWriter> trajectory;
+    if (not options->trajectory.empty()) {
+        try {
+            trajectory = std::make_unique<TrajectoryWriter>(options->trajectory, ocean, options->keyframe_every, options->compress);
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << '\n';
+            return EXIT_FAILURE;
+        }
+        trajectory->record(ocean);
+    }
 
-        
-        public:
-            /**
-            * @brief prints the entire ocean grid with ascii characters
-            * @param cell cell's occupied state - empty, turtle, ship, or trash:
-            * @return char ASCII character
-            * @details the cursor always points back to same position, so the grid is written over the previous one instead of priting new one
-            */
-            void print_grid() {
-                // first, send the cursor to the home position:
-                printf( "%c[1;0H",(char)27); /// TODO: change later
-                std::cout << '\n';
-                
-                // second, print the column indices first:
-                std::cout << " ";
-                for (int j = 0; j < num_cols; ++j) {
-                    //then print out indices, only the first digit
-                    std::cout << " " << j % 10;
-                } 
-                // move to next line:
-                std::cout << '\n';
-                
-                // third, loop over the entire grid vector and print out in matrix form:
-                for (int i = 0; i < num_rows; ++i) { // loop thru each row
-                    // print the row index at the front
-                    std::cout << i % 10 << ' ';
-                    /// loop thru each column
-                    for (int j = 0; j < num_cols; ++j) {
-                        // 1. get each cell's Occupy/Object state
-                        Ocean::Occupy cell_state = get_cell(i, j);
-                        // 2. print the corresponding ASCII of that cell state:
-                        std::cout << get_ascii(cell_state) << " ";
-                    }
-                    // move to the new line
-                    std::cout << '\n';
-                }
-                // finally print all the populations:
-                std::cout << '\n';
-                std::cout << "Turtles: " << num_turtle << '\n';
-                std::cout << "Trash: " << num_trash << '\n';
-                std::cout << "Ships: " << num_ship << '\n';
+    // write a checkpoint every checkpoint_every steps, and once more at the end of the run:
+    std::function<void(Ocean&)> after_step = nullptr;
+    if (trajectory or metrics or analytics or (not options->save_checkpoint.empty() and options->checkpoint_every > 0)) {
+        after_step = [&](Ocean& _ocean) {
+            if (trajectory) {
+                trajectory->record(_ocean);
             }
-
-            void set_dummy_grid() {
-                // Initialize counters to enforce exact population
-                int turtle_count = 0;
-                int trash_count = 0;
-                int ship_count = 0;
-
-                // Desired populations (if constructor had population parameters intialized, handle it here)
-                const int max_turtles = std::min(25, num_turtle);
-                const int max_trash = std::min(25, num_trash);
-                const int max_ships = std::min(2, num_ship);
-
-                // Randomly fill the grid
-                for (int i = 0; i < num_cells; ++i) {
-                    if (turtle_count <= max_turtles && random_float(0.f, 1.f) < 0.0025) {
-                        grid[i] = static_cast<int>(Occupy::Turtle);
-                        turtle_count++;
-                    } else if (trash_count <= max_trash && random_float(0.f, 1.f) < 0.005) {
-                        grid[i] = static_cast<int>(Occupy::Trash);
-                        trash_count++;
-                    } else if (ship_count <= max_ships && random_float(0.f, 1.f) < 0.0002) {
-                        grid[i] = static_cast<int>(Occupy::Ship);
-                        ship_count++;
-                    } else {
-                        grid[i] = static_cast<int>(Occupy::Empty);
-                    }
-                }
-
-                // Populate counts
-                // auto [_num_turtles, _num_trash, _num_ships] = population(grid);
-                this->num_turtle = max_turtles;
-                this->num_trash = max_trash;
-                this->num_ship = max_ships;
+            if (metrics) {
+                metrics->record(_ocean);
             }
-
-            void move_ship(std::vector<int>& temp_grid) {
-                for (int i = 0; i < num_rows ; i++) {
-                    for (int j = 0; j < num_cols; j++) {
-                        if (get_cell(i, j) == Occupy::Ship) {
-                            // get the result of moving objects
-                            auto [old_i, old_j, old_obj, new_i, new_j, new_obj] = ship_move(i, j);
-
-                            int curr_index = i * num_cols + j;
-                            int new_index = new_i * num_cols + new_j;
-
-                            // now try to update this on target_grid:
-                            // check if new indices in TEMP_grid is already occupied by anothe ship
-                            if (temp_grid[new_index] == static_cast<int>(Occupy::Ship)) { // case when it's occupied already
-                                temp_grid[curr_index] = static_cast<int>(Occupy::Ship);
-                            } else { // else the future cell is empty
-                                // update the temp grid accordingly:
-                                temp_grid[curr_index] = static_cast<int>(Occupy::Empty);
-                                temp_grid[new_index] = static_cast<int>(Occupy::Ship);
-                            }
-                        }
-                    }
-                }
+            if (analytics) {
+                analytics->record(_ocean);
             }
-
-            void move_turtle(std::vector<int>& temp_grid) {
-                for (int i = 0; i < num_rows ; i++) {
-                    for (int j = 0; j < num_cols; j++) {
-                        if (get_cell(i, j) == Occupy::Turtle) {
-                            // get the result of moving objects
-                            auto [old_i, old_j, old_obj, new_i, new_j, new_obj] = turtle_move(i, j);
-
-                            int curr_index = i * num_cols + j;
-                            int new_index = new_i * num_cols + new_j;
-
-                            // now try to update this on target_grid:
-                            // check if new indices in TEMP_grid is already occupied:
-                            if (temp_grid[new_index] != static_cast<int>(Occupy::Empty)) { // case when it's occupied already
-                                auto collision_outcome = collision(i, j, new_i, new_j, old_obj, temp_grid);
-                                // retrieve the surviving object at the NEW index
-                                Occupy surviving_obj = std::get<5>(collision_outcome);
-                                // retrieve the object at the old index AFTER collision
-                                Occupy returned_obj = std::get<2>(collision_outcome);
-
-                                // update the temp grid accordingly:
-                                temp_grid[curr_index] = static_cast<int>(returned_obj);
-                                temp_grid[new_index] = static_cast<int>(surviving_obj);
-                            } else { // else the future cell is empty
-                                // update the temp grid accordingly:
-                                temp_grid[curr_index] = static_cast<int>(old_obj);
-                                temp_grid[new_index] = static_cast<int>(new_obj);
-                            }
-                        }
-                    }
-                }
+            if (options->checkpoint_every > 0 and not options->save_checkpoint.empty() and _ocean.step % options->checkpoint_every == 0) {
+                _ocean.save_checkpoint(options->save_checkpoint);
             }
-
-            void move_trash(std::vector<int>& temp_grid) {
-                for (int i = 0; i < num_rows ; i++) {
-                    for (int j = 0; j < num_cols; j++) {
-                        if (get_cell(i, j) == Occupy::Trash) {
-                            // get the result of moving objects
-                            auto [old_i, old_j, old_obj, new_i, new_j, new_obj] = trash_move(i, j);
-
-                            int curr_index = i * num_cols + j;
-                            int new_index = new_i * num_cols + new_j;
-
-                            // now try to update this on target_grid:
-                            // check if new indices in TEMP_grid is already occupied:
-                            if (temp_grid[new_index] != static_cast<int>(Occupy::Empty)) { // case when it's occupied already
-                                auto collision_outcome = collision(i, j, new_i, new_j, old_obj, temp_grid);
-                                // retrieve the surviving object at the NEW index
-                                Occupy surviving_obj = std::get<5>(collision_outcome);
-                                // retrieve the object at the old index AFTER collision
-                                Occupy returned_obj = std::get<2>(collision_outcome);
-
-                                // update the temp grid accordingly:
-                                temp_grid[curr_index] = static_cast<int>(returned_obj);
-                                temp_grid[new_index] = static_cast<int>(surviving_obj);
-                            } else { // else the future cell is empty
-                                // update the temp grid accordingly:
-                                temp_grid[curr_index] = static_cast<int>(old_obj);
-                                temp_grid[new_index] = static_cast<int>(new_obj);
-                            }
-                        }
-                    }
-                }
-            }
-
-
-
-            /**
-             * @brief updates the grid using data independent method
-             * @details First, initializes temp_grid to all zeros. 
-             *          Second, performs all updates on temp_grid while using data from grid to avoid data dependency.
-             *          Basically, we read from grid and write to temp_grid
-             */
-            void update_grid() {
-                // intialize the grid_copy
-                std::vector<int> temp_grid(num_cells, static_cast<int>(Occupy::Empty));
-                
-                // move ships first:
-                move_ship(temp_grid);
-
-                move_turtle(temp_grid);
-
-                move_trash(temp_grid);
-
-                auto [_num_turtle, _num_trash, _num_ship] = population(temp_grid);
-
-                this->num_turtle = _num_turtle;
-                this->num_trash = _num_trash;
-                this->num_ship = _num_ship;
-
-                this->grid = std::move(temp_grid);       
-
-            };
-
-            void update(int total_time) {
-
-                for (int t = 0; t < total_time ; t++) {
-                    print_grid();
-                    update_grid();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-                }
-            };
-
-            std::tuple<int, int, int> population(const std::vector<int>& _grid) {
-                int turtle{0}, ship{0}, trash{0};
-                for (int i = 0 ; i < num_cells; ++i) {
-                    switch(static_cast<Occupy>(_grid[i])) {
-                        case Occupy::Turtle:
-                            turtle++; break;
-                        case Occupy::Trash:
-                            trash++; break;
-                        case Occupy::Ship:
-                            ship++; break;
-                        default:
-                            break;
-                    }
-                }
-                return {turtle, trash, ship};
-            }
-    
-};
-
-/**
- * @brief operator overloading of std::cout so that we can directly print out the cell content
- */
-std::ostream& operator<<(std::ostream& os, const Ocean::Occupy& occupy) {
-    // print out corresponding string for Occupy state:
-    switch (occupy) {
-        case Ocean::Occupy::Empty:
-            os << "empty";
-            break;
-        case Ocean::Occupy::Turtle:
-            os << "turtle";
-            break;
-        case Ocean::Occupy::Trash:
-            os << "trash";
-            break;
-        case Ocean::Occupy::Ship:
-            os << "ship";
-            break;
-    }
-    return os;
-}
-
-
-
-int main() {
-
-    std::vector<int> example = {
-
+        };
+    }
+    // a trajectory that lost frames to a failed write is useless, fail the run:
+    const auto close_trajectory = [&trajectory] {
+        if (not trajectory) {
+            return true;
+        }
+        try {
+            trajectory->close();
+            return true;
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << '\n';
+            return false;
+        }
     };
-    Ocean ocean(70, 70, 40, 40, 14);
-    ocean.set_dummy_grid();
+    Ocean::RunStats stats;
+    try {
+        stats = ocean.run_headless(options->steps, after_step);
+        if (not options->save_checkpoint.empty()) {
+            ocean.save_checkpoint(options->save_checkpoint);
+        }
+    } catch (const std::exception& error) {
+        // a checkpoint that can't be written, stop the run but keep the frames recorded so far:
+        std::cerr << error.what() << '\n';
+        close_trajectory();
+        return EXIT_FAILURE;
+    }
+    if (not close_trajectory()) {
+        return EXIT_FAILURE;
+    }
 
-    ocean.update(100);
+    std::cout << "final step: " << ocean.step << '\n';
+    std::cout << "final population - turtles: " << ocean.num_turtle << " trash: " << ocean.num_trash << " ships: " << ocean.num_ship << '\n';
+    std::cout << "steps: " << stats.steps << '\n';
+    std::cout << "elapsed [s]: " << stats.seconds << '\n';
+    std::cout << "steps/sec: " << stats.steps_per_sec << '\n';
+    std::cout << "cell-updates/sec: " << stats.cell_updates_per_sec << '\n';
+    std::cout << "allocations in first step: " << stats.first_step_allocations << '\n';
+    std::cout << "allocations in later steps: " << stats.allocations << '\n';
+    if (const ChunkedGrid* chunked = std::get_if<ChunkedGrid>(&ocean.grid.cells)) {
+        std::cout << "chunks: " << chunked->live_chunks() << " live, " << chunked->memory_bytes() / (1024. * 1024.) << " MiB\n";
+    }
+    if (trajectory) {
+        std::cout << "trajectory frames: " << trajectory->recorded() << " recorded, " << trajectory->dropped() << " dropped\n";
+    }
+    if (metrics and metrics_enabled) {
+        const Metrics& totals = metrics->totals();
+        std::cout << "phase time [s] -";
+        for (int phase = 0; phase < num_phases; ++phase) {
+            std::cout << ' ' << phase_names[phase] << ": " << totals.phase_seconds[phase];
+        }
+        std::cout << '\n';
+    }
     return EXIT_SUCCESS;
 }
-
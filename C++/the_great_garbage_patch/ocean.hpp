@@ -0,0 +1,6928 @@
+/**
+ * @authors Jiwoong "Alex" Choi
+ * @date 2024.12.11
+ * @file ocean.hpp
+ * @brief the ocean simulation: grid storage, engines, checkpoints and run drivers, shared by the ocean and ocean_bench executables
+ */
+#pragma once
+
+#include <iostream>
+using std::cout, std::cin;
+
+// for 2d grid representation
+#include <vector>
+using std::vector;
+
+// for the packed grid layouts
+#include <bit>
+#include <stdexcept>
+
+/// for visualization of ocean - cursor control in terminal window
+#include <cstdio> 
+
+/// for random number generation
+#include <random>
+#include <array>
+#include <cstdint>
+
+// For seeding with time & sleep
+#include <chrono>
+
+//  for sleep to simulate grid update
+#include <thread> 
+
+#include <variant>
+using std::variant, std::monostate;
+
+#include <tuple>
+using std::tuple;
+
+#include <optional>
+using std::optional, std::nullopt;
+
+#include <algorithm>
+#include <numeric>
+
+#include <string>
+
+// for the tiled, multithreaded grid update
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <climits>
+#include <limits>
+
+// for counting heap allocations
+#include <cstdlib>
+#include <new>
+
+// for checkpoint files: binary writes and memory-mapped reads
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <utility>
+#include <memory>
+#include <type_traits>
+#include <numbers>
+#include <cassert>
+#include <span>
+
+// for the lazy frame sequence of Ocean::frames()
+#include <version>
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#if __has_include(<generator>)
+#include <generator>
+#endif
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Allocation Counter
+ * @section AllocationCounter Allocation Counter
+ * allocation_counter.cpp replaces the global operator new/delete with versions that count every heap allocation,
+ * so the headless mode and the benchmarks can show that the step loop does not allocate.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @brief number of heap allocations made so far by the whole program
+ * @return allocation count, take the difference of two calls to count the allocations in between
+ * @details defined in allocation_counter.cpp, which every executable links
+ */
+std::size_t allocation_count();
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Random Number Generators
+ * @section RandomNumberGenerators Random Number Generators
+ * This section contains functions for generating random integers and floats.
+ * random_int and random_float share one stateful engine per thread and are meant for setup code.
+ * The step loop draws from CounterRng instead, which has no shared state.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @brief shared random engine for all random number generators in this file
+ * @return reference to the calling thread's STATIC engine that's shared by all function invocations on that thread
+ * @details the engine has to be static for all function calls, otherwise the generator gets recreated every time, leading to a sequence of identical seed numbers.
+ *          it is thread_local so ensemble replicas can set up their grids on different threads without sharing state.
+ *          it is seeded with random_device by default; use seed_random() for reproducible runs
+ */
+inline std::default_random_engine& random_engine() {
+    // seed the generator using random device (static reduces computation time and overhead)
+    static thread_local std::random_device random_device;
+    static thread_local std::default_random_engine static_engine( random_device() );
+    return static_engine;
+}
+
+/**
+ * @brief re-seeds the calling thread's shared random engine
+ * @param seed seed value, the same seed reproduces the same sequence of random numbers
+ */
+inline void seed_random(unsigned int seed) {
+    random_engine().seed(seed);
+}
+
+/**
+ * @brief random integer generator within defined range
+ * @param min the lowest value that random number can be, default 0
+ * @param max the highest value that random number can be, default 1
+ * @return int a random integer between min and max, inclusive [min, max]
+ * @details this function draws from the calling thread's static engine, see random_engine()
+ */
+inline int random_int(int min = 0, int max = 1) {
+    // apply distribution to the generator
+    std::uniform_int_distribution<int> distribution(min, max);
+    // finally return the random int
+    return distribution(random_engine());
+};
+
+/**
+ * @brief random float generator within defined range
+ * @param min the lowest value that random number can be, default 0.0
+ * @param max the highest value that random number can be, default 1.0
+ * @return float a random float between min (inclusive) and max(exclusive), [min, max)
+ * @details this function draws from the calling thread's static engine, see random_engine()
+ */
+inline float random_float(float min = 0.f, float max = 1.f) {
+    // apply distribution to the generator
+    std::uniform_real_distribution<float> distribution(min, max);
+    // finally return the random float
+    return distribution(random_engine());
+};
+
+/// @brief multipliers and Weyl sequence increments of Philox4x32
+inline constexpr std::uint32_t philox_m0 = 0xD2511F53, philox_m1 = 0xCD9E8D57;
+inline constexpr std::uint32_t philox_w0 = 0x9E3779B9, philox_w1 = 0xBB67AE85;
+
+/**
+ * @brief Philox4x32-10 counter-based random number generator
+ * @param counter 128-bit counter, every distinct counter gives an independent block of random bits
+ * @param key 64-bit key, e.g. the seed of the simulation
+ * @return 4 uniformly distributed 32-bit random numbers
+ * @details a pure function of (counter, key): there is no state to share between threads, and any draw can be recomputed on its own.
+ *          see Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC'11
+ */
+constexpr std::array<std::uint32_t, 4> philox4x32(std::array<std::uint32_t, 4> counter, std::array<std::uint32_t, 2> key) {
+    for (int round = 0; round < 10; ++round) {
+        std::uint64_t product0 = static_cast<std::uint64_t>(philox_m0) * counter[0];
+        std::uint64_t product1 = static_cast<std::uint64_t>(philox_m1) * counter[2];
+        counter = {
+            static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+            static_cast<std::uint32_t>(product1),
+            static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+            static_cast<std::uint32_t>(product0)
+        };
+        key[0] += philox_w0;
+        key[1] += philox_w1;
+    }
+    return counter;
+}
+
+/**
+ * @class CounterRng
+ * @brief seedable counter-based generator keyed on (seed, step, cell, stream)
+ * @details the random numbers of an agent depend only on the seed, the time step, its cell and the stream (e.g. the species phase),
+ *          so results are bit-identical no matter how cells are split across threads or in which order they are visited.
+ */
+class CounterRng {
+    public:
+        /// @var uint64_t seed
+        /// @brief seed of the generator, used as the Philox key
+        std::uint64_t seed{0};
+
+        CounterRng() = default;
+
+        /**
+         * @brief creates a generator with the given seed
+         * @param _seed seed of the generator
+         */
+        explicit CounterRng(std::uint64_t _seed) : seed(_seed) {}
+
+        /// @brief streams are below this, the bits above hold the high bits of cell indices of 2^32 and more
+        static constexpr std::uint32_t stream_limit = 256;
+
+        /// @brief cell indices are below this, so their high bits fit next to the stream
+        static constexpr std::uint64_t cell_limit = std::uint64_t{1} << 56;
+
+        /**
+         * @brief 4 random 32-bit numbers for one (step, cell, stream) coordinate
+         * @param step time step
+         * @param cell cell index, below cell_limit. indices below 2^32 draw the same numbers as a 32-bit index
+         * @param stream independent stream for the same step and cell, e.g. the phase that draws the number, below stream_limit
+         * @return 4 uniformly distributed 32-bit random numbers
+         */
+        std::array<std::uint32_t, 4> operator()(std::uint64_t step, std::uint64_t cell, std::uint32_t stream = 0) const {
+            return philox4x32({static_cast<std::uint32_t>(cell), stream | static_cast<std::uint32_t>(cell >> 32) * stream_limit, static_cast<std::uint32_t>(step),
+                               static_cast<std::uint32_t>(step >> 32)},
+                              {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)});
+        }
+
+        /**
+         * @brief converts an idle probability into a threshold on a 32-bit random number
+         * @param idle_chance probability in [0, 1]
+         * @return threshold such that (random number < threshold) has probability idle_chance
+         */
+        static std::uint64_t idle_threshold(float idle_chance) {
+            double threshold = static_cast<double>(idle_chance) * 4294967296.0;
+            return static_cast<std::uint64_t>(std::clamp(threshold, 0.0, 4294967296.0));
+        }
+
+        /**
+         * @brief draws a direction from one block of random numbers
+         * @param bits random block from operator()
+         * @param threshold idle threshold from idle_threshold()
+         * @return 0 (idle) with probability idle_chance, otherwise one of the 8 active directions 1..8 with equal chance
+         */
+        static std::int8_t direction(const std::array<std::uint32_t, 4>& bits, std::uint64_t threshold) {
+            if (bits[0] < threshold) {
+                return 0;
+            }
+            // map the second word onto 1..8 without a division:
+            return static_cast<std::int8_t>(1 + ((static_cast<std::uint64_t>(bits[1]) * 8) >> 32));
+        }
+
+        /**
+         * @brief bulk-fills random directions for a list of cells
+         * @param step time step
+         * @param stream stream of the draws, e.g. the species phase
+         * @param cells cell indices of the agents, int or 64-bit
+         * @param count number of cells
+         * @param idle_chance probability that an agent stays idle
+         * @param directions output, directions[k] is the Direction of cells[k] as an integer 0..8
+         */
+        template <class Index>
+        void fill_directions(std::uint64_t step, std::uint32_t stream, const Index* cells, std::size_t count, float idle_chance, std::int8_t* directions) const {
+            const std::uint64_t threshold = idle_threshold(idle_chance);
+            for (std::size_t k = 0; k < count; ++k) {
+                directions[k] = direction((*this)(step, static_cast<std::uint64_t>(cells[k]), stream), threshold);
+            }
+        }
+};
+
+/**
+ * @class CellPermutation
+ * @brief a keyed pseudorandom permutation of [0, size) that can be evaluated at any index without storing it
+ * @details a 4-round Feistel network over the smallest even power of two >= size, with Philox as the round function, walks every value
+ *          outside [0, size) through the network again until it lands inside. the values at indices 0..k-1 are k distinct cells in random
+ *          order, so sampling k cells without replacement costs O(k), and any index can be evaluated on any thread.
+ */
+class CellPermutation {
+    public:
+        /**
+         * @brief creates the permutation
+         * @param _size number of values, below 2^63
+         * @param seed key of the permutation, every seed gives a different permutation
+         */
+        CellPermutation(std::uint64_t _size, std::uint64_t seed) : size(_size), rng(seed) {
+            int bits = 2;
+            while ((std::uint64_t{1} << bits) < size) {
+                bits++;
+            }
+            half_bits = (bits + 1) / 2;
+            mask = (std::uint64_t{1} << half_bits) - 1;
+        }
+
+        /// @brief the value at index, index < size
+        std::uint64_t operator()(std::uint64_t index) const {
+            std::uint64_t value = index;
+            do {
+                value = encrypt(value);
+            } while (value >= size);
+            return value;
+        }
+
+    private:
+        /// @brief one pass through the Feistel network, a permutation of [0, 4^half_bits)
+        std::uint64_t encrypt(std::uint64_t value) const {
+            std::uint64_t left = value >> half_bits, right = value & mask;
+            for (std::uint64_t round = 0; round < 4; ++round) {
+                const std::uint64_t next = left ^ (rng(round, static_cast<std::uint32_t>(right))[0] & mask);
+                left = right;
+                right = next;
+            }
+            return (left << half_bits) | right;
+        }
+
+        std::uint64_t size;
+        CounterRng rng;
+        int half_bits{1};
+        std::uint64_t mask{1};
+};
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Grid Storage
+ * @section GridStorage Grid Storage
+ * This section contains the memory layouts a grid can be stored in. Cells hold the integer value of Ocean::Occupy:
+ * -1 for an empty cell, 0 for a turtle, 1 for a trash and 2 for a ship.
+ * Every layout has the same interface: get/set of a cell, count of a value, and for_each_of to visit the cells holding a value in a range.
+ * The move kernels are templates over the layout, so picking a layout costs one dispatch per phase and not one per cell.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @brief the available grid layouts, in the order of the GridStorage variant
+ */
+enum class GridLayout {
+    Int = 0, ///< one int per cell
+    Byte = 1, ///< one int8_t per cell
+    Bitboard = 2, ///< one bit per cell in each of 3 species planes
+    Chunked = 3 ///< one int8_t per cell in 64 x 64 chunks, allocated only where agents live
+};
+
+/**
+ * @class IntGrid
+ * @brief one int per cell, the original layout
+ */
+class IntGrid {
+    public:
+        IntGrid() = default;
+        /// @brief creates num_cells empty cells
+        explicit IntGrid(std::size_t num_cells) : cells(num_cells, -1) {}
+
+        std::size_t size() const { return cells.size(); }
+        int get(std::size_t cell) const { return cells[cell]; }
+        void set(std::size_t cell, int value) { cells[cell] = value; }
+
+        /// @brief number of cells holding value
+        std::size_t count(int value) const {
+            return static_cast<std::size_t>(std::count(cells.begin(), cells.end(), value));
+        }
+
+        /// @brief calls f(cell) for every cell in [begin, end) holding value
+        template <class F>
+        void for_each_of(int value, std::size_t begin, std::size_t end, F&& f) const {
+            for (std::size_t cell = begin; cell < end; ++cell) {
+                if (cells[cell] == value) {
+                    f(cell);
+                }
+            }
+        }
+
+        std::vector<int> cells;
+};
+
+/**
+ * @class ByteGrid
+ * @brief one int8_t per cell, a quarter of the memory traffic of IntGrid
+ */
+class ByteGrid {
+    public:
+        ByteGrid() = default;
+        /// @brief creates num_cells empty cells
+        explicit ByteGrid(std::size_t num_cells) : cells(num_cells, -1) {}
+
+        std::size_t size() const { return cells.size(); }
+        int get(std::size_t cell) const { return cells[cell]; }
+        void set(std::size_t cell, int value) { cells[cell] = static_cast<std::int8_t>(value); }
+
+        /// @brief number of cells holding value
+        std::size_t count(int value) const {
+            return static_cast<std::size_t>(std::count(cells.begin(), cells.end(), static_cast<std::int8_t>(value)));
+        }
+
+        /// @brief calls f(cell) for every cell in [begin, end) holding value
+        template <class F>
+        void for_each_of(int value, std::size_t begin, std::size_t end, F&& f) const {
+            const std::int8_t wanted = static_cast<std::int8_t>(value);
+            for (std::size_t cell = begin; cell < end; ++cell) {
+                if (cells[cell] == wanted) {
+                    f(cell);
+                }
+            }
+        }
+
+        std::vector<std::int8_t> cells;
+};
+
+/**
+ * @class BitboardGrid
+ * @brief one bit plane per species, 3 bits per cell
+ * @details an empty cell has no bit set in any plane. populations are popcounts of the planes, and for_each_of skips 64 cells
+ *          at a time when a word of the plane is zero. words are read and written through atomic_ref, so tiles on different threads
+ *          may set cells that share a word.
+ */
+class BitboardGrid {
+    public:
+        BitboardGrid() = default;
+        /// @brief creates num_cells empty cells
+        explicit BitboardGrid(std::size_t _num_cells) : num_cells(_num_cells) {
+            for (std::vector<std::uint64_t>& plane : planes) {
+                plane.assign((num_cells + 63) / 64, 0);
+            }
+        }
+
+        std::size_t size() const { return num_cells; }
+
+        int get(std::size_t cell) const {
+            const std::uint64_t mask = std::uint64_t{1} << (cell % 64);
+            for (int value = 0; value < 3; ++value) {
+                if (load(planes[value][cell / 64]) & mask) {
+                    return value;
+                }
+            }
+            return -1;
+        }
+
+        void set(std::size_t cell, int value) {
+            const std::uint64_t mask = std::uint64_t{1} << (cell % 64);
+            int old_value = get(cell);
+            if (old_value == value) {
+                return;
+            }
+            if (old_value >= 0) {
+                std::atomic_ref<std::uint64_t>(planes[old_value][cell / 64]).fetch_and(~mask, std::memory_order_relaxed);
+            }
+            if (value >= 0) {
+                std::atomic_ref<std::uint64_t>(planes[value][cell / 64]).fetch_or(mask, std::memory_order_relaxed);
+            }
+        }
+
+        /// @brief number of cells holding value, a popcount of the plane for species
+        std::size_t count(int value) const {
+            if (value < 0) {
+                return num_cells - count(0) - count(1) - count(2);
+            }
+            std::size_t total = 0;
+            for (const std::uint64_t& word : planes[value]) {
+                total += static_cast<std::size_t>(std::popcount(load(word)));
+            }
+            return total;
+        }
+
+        /// @brief bitmask of the occupied cells among cells [64 * word, 64 * word + 64)
+        std::uint64_t occupied_word(std::size_t word) const {
+            return load(planes[0][word]) | load(planes[1][word]) | load(planes[2][word]);
+        }
+
+        /// @brief calls f(cell) for every cell in [begin, end) holding value (a species), one plane word at a time
+        template <class F>
+        void for_each_of(int value, std::size_t begin, std::size_t end, F&& f) const {
+            if (begin >= end) {
+                return;
+            }
+            const std::vector<std::uint64_t>& plane = planes[value];
+            const std::size_t first_word = begin / 64, last_word = (end - 1) / 64;
+            for (std::size_t word = first_word; word <= last_word; ++word) {
+                std::uint64_t bits = load(plane[word]);
+                // cut off the cells outside [begin, end) in the first and last word:
+                if (word == first_word) {
+                    bits &= ~std::uint64_t{0} << (begin % 64);
+                }
+                if (word == last_word and end % 64 != 0) {
+                    bits &= ~std::uint64_t{0} >> (64 - end % 64);
+                }
+                while (bits) {
+                    f(word * 64 + static_cast<std::size_t>(std::countr_zero(bits)));
+                    bits &= bits - 1;
+                }
+            }
+        }
+
+        std::size_t num_cells{0};
+        std::vector<std::uint64_t> planes[3]; ///< one plane per species, indexed by the cell value
+
+    private:
+        static std::uint64_t load(const std::uint64_t& word) {
+            // atomic_ref needs a non-const object, the load itself doesn't modify the word
+            return std::atomic_ref<std::uint64_t>(const_cast<std::uint64_t&>(word)).load(std::memory_order_relaxed);
+        }
+};
+
+/**
+ * @class ChunkedGrid
+ * @brief square chunks of cells that only exist where something lives, for oceans far larger than a dense grid
+ * @details chunks are chunk_edge x chunk_edge cells, kept in a pool and found through an open-addressing hash index keyed on the
+ *          position of the chunk. a cell without a chunk is empty. set() allocates the chunk when it writes an agent into an absent one,
+ *          and every chunk keeps a population summary, so counts cost O(chunks) and release_empty() can free the chunks that emptied out.
+ *          the index only changes in set() into an absent chunk, reserve_halo() and release_empty(). code that writes from several threads
+ *          reserves the chunks it can reach first, after which cells and population summaries can be written concurrently.
+ */
+class ChunkedGrid {
+    public:
+        /// @brief edge length of a chunk in cells
+        static constexpr std::size_t chunk_edge = 64;
+        /// @brief cells per chunk
+        static constexpr std::size_t chunk_cells = chunk_edge * chunk_edge;
+
+        /**
+         * @brief a chunk_edge x chunk_edge block of cells
+         */
+        struct Chunk {
+            std::int64_t key{-1}; ///< chunk_row * num_chunk_cols + chunk_col, -1 while the slot is free
+            int population[3]{0, 0, 0}; ///< agents in the chunk, indexed by the cell value
+            std::int8_t cells[chunk_cells]; ///< cell values, row-major within the chunk
+            std::int8_t scratch[chunk_cells]; ///< one byte per cell for the engines, e.g. pending moves, zero when the chunk is allocated
+
+            /// @brief true if any agent lives in the chunk
+            bool occupied() const { return population[0] + population[1] + population[2] > 0; }
+        };
+
+        ChunkedGrid() = default;
+        /// @brief creates num_cells empty cells in rows of row_length cells, without allocating any chunk
+        ChunkedGrid(std::size_t _num_cells, std::size_t _row_length) : num_cells(_num_cells), row_length(std::max<std::size_t>(_row_length, 1)) {
+            num_chunk_cols = (row_length + chunk_edge - 1) / chunk_edge;
+            num_chunk_rows = (num_cells / row_length + chunk_edge - 1) / chunk_edge;
+        }
+
+        std::size_t size() const { return num_cells; }
+
+        int get(std::size_t cell) const {
+            const Chunk* chunk = find(chunk_key(cell));
+            return chunk ? chunk->cells[offset(cell)] : -1;
+        }
+
+        void set(std::size_t cell, int value) {
+            Chunk* chunk = find(chunk_key(cell));
+            if (not chunk) {
+                // an absent chunk is empty already:
+                if (value < 0) {
+                    return;
+                }
+                chunk = &chunks[allocate(chunk_key(cell))];
+            }
+            std::int8_t& stored = chunk->cells[offset(cell)];
+            if (stored == value) {
+                return;
+            }
+            if (stored >= 0) {
+                std::atomic_ref<int>(chunk->population[stored]).fetch_sub(1, std::memory_order_relaxed);
+            }
+            if (value >= 0) {
+                std::atomic_ref<int>(chunk->population[value]).fetch_add(1, std::memory_order_relaxed);
+            }
+            stored = static_cast<std::int8_t>(value);
+        }
+
+        /// @brief number of cells holding value, summed from the population summaries
+        std::size_t count(int value) const {
+            if (value < 0) {
+                return num_cells - count(0) - count(1) - count(2);
+            }
+            std::size_t total = 0;
+            for (const Chunk& chunk : chunks) {
+                if (chunk.key >= 0) {
+                    total += static_cast<std::size_t>(chunk.population[value]);
+                }
+            }
+            return total;
+        }
+
+        /// @brief calls f(cell) for every cell in [begin, end) holding value (a species), skipping chunks without that species
+        template <class F>
+        void for_each_of(int value, std::size_t begin, std::size_t end, F&& f) const {
+            if (begin >= end) {
+                return;
+            }
+            const std::size_t first_row = begin / row_length, last_row = (end - 1) / row_length;
+            if (first_row == last_row) {
+                for_each_in_row(value, first_row, begin % row_length, (end - 1) % row_length + 1, f);
+                return;
+            }
+            // longer ranges visit the live chunks band by band, so the cells still come in ascending order:
+            std::vector<std::int64_t> keys;
+            for (const Chunk& chunk : chunks) {
+                if (chunk.key >= 0 and chunk.population[value] > 0) {
+                    keys.push_back(chunk.key);
+                }
+            }
+            std::sort(keys.begin(), keys.end());
+            for (std::size_t k = 0; k < keys.size();) {
+                const std::size_t band = static_cast<std::size_t>(keys[k]) / num_chunk_cols;
+                std::size_t band_end = k;
+                while (band_end < keys.size() and static_cast<std::size_t>(keys[band_end]) / num_chunk_cols == band) {
+                    band_end++;
+                }
+                const std::size_t row_end = std::min({(band + 1) * chunk_edge, last_row + 1, num_cells / row_length});
+                for (std::size_t row = std::max(band * chunk_edge, first_row); row < row_end; ++row) {
+                    for (std::size_t c = k; c < band_end; ++c) {
+                        const std::size_t col_begin = static_cast<std::size_t>(keys[c]) % num_chunk_cols * chunk_edge;
+                        scan_row(*find(keys[c]), value, row, col_begin, std::min(col_begin + chunk_edge, row_length), begin, end, f);
+                    }
+                }
+                k = band_end;
+            }
+        }
+
+        /// @brief calls f(cell) in ascending order for every cell holding value in the chunk that contains cell, with one index lookup
+        template <class F>
+        void for_each_of_chunk(int value, std::size_t cell, F&& f) const {
+            const Chunk* chunk = find(chunk_key(cell));
+            if (not chunk or chunk->population[value] == 0) {
+                return;
+            }
+            const std::array<int, 4> bounds = chunk_bounds(chunk->key);
+            for (std::size_t row = static_cast<std::size_t>(bounds[0]); row < static_cast<std::size_t>(bounds[1]); ++row) {
+                scan_row(*chunk, value, row, static_cast<std::size_t>(bounds[2]), static_cast<std::size_t>(bounds[3]), 0, num_cells, f);
+            }
+        }
+
+        /// @brief the engine scratch byte of a cell, whose chunk has to exist
+        std::int8_t& scratch(std::size_t cell) { return find(chunk_key(cell))->scratch[offset(cell)]; }
+
+        /// @brief the engine scratch byte of a cell, 0 if the cell has no chunk
+        std::int8_t scratch(std::size_t cell) const {
+            const Chunk* chunk = find(chunk_key(cell));
+            return chunk ? chunk->scratch[offset(cell)] : 0;
+        }
+
+        /// @brief zeroes the scratch bytes of every chunk
+        void clear_scratch() {
+            for (Chunk& chunk : chunks) {
+                std::memset(chunk.scratch, 0, chunk_cells);
+            }
+        }
+
+        /**
+         * @brief allocates every missing chunk next to an occupied chunk, so an agent that moves by one cell always lands in an existing chunk
+         * @param wrap the grid wraps around its edges, so the chunks on opposite edges are neighbors
+         */
+        void reserve_halo(bool wrap) {
+            // chunks allocated here have no agents, so the loop doesn't need to visit them:
+            const std::size_t num_slots = chunks.size();
+            for (std::size_t slot = 0; slot < num_slots; ++slot) {
+                if (chunks[slot].key < 0 or not chunks[slot].occupied()) {
+                    continue;
+                }
+                const std::int64_t key = chunks[slot].key;
+                for_each_neighbor(key, wrap, [&](std::int64_t neighbor) {
+                    if (not find(neighbor)) {
+                        allocate(neighbor);
+                    }
+                });
+            }
+        }
+
+        /**
+         * @brief frees the chunks that hold no agent and have no occupied neighbor
+         * @param wrap the grid wraps around its edges, see reserve_halo()
+         * @param on_free called with the pool slot of every freed chunk
+         * @details empty chunks next to occupied ones are kept, since reserve_halo() would allocate them again right away
+         */
+        template <class F>
+        void release_empty(bool wrap, F&& on_free) {
+            for (std::size_t slot = 0; slot < chunks.size(); ++slot) {
+                if (chunks[slot].key < 0 or chunks[slot].occupied()) {
+                    continue;
+                }
+                bool near_agents = false;
+                for_each_neighbor(chunks[slot].key, wrap, [&](std::int64_t neighbor) {
+                    const Chunk* chunk = find(neighbor);
+                    near_agents = near_agents or (chunk and chunk->occupied());
+                });
+                if (near_agents) {
+                    continue;
+                }
+                erase(chunks[slot].key);
+                chunks[slot].key = -1;
+                free_slots.push_back(static_cast<int>(slot));
+                on_free(static_cast<int>(slot));
+            }
+        }
+
+        /// @brief number of allocated chunks
+        std::size_t live_chunks() const { return chunks.size() - free_slots.size(); }
+
+        /// @brief bytes held by the chunk pool and the index
+        std::size_t memory_bytes() const {
+            return chunks.capacity() * sizeof(Chunk) + index_keys.capacity() * sizeof(std::int64_t) + index_slots.capacity() * sizeof(int)
+                   + free_slots.capacity() * sizeof(int);
+        }
+
+        /// @brief first row, first column and the ends of the cells covered by a chunk
+        std::array<int, 4> chunk_bounds(std::int64_t key) const {
+            const std::size_t row_begin = static_cast<std::size_t>(key) / num_chunk_cols * chunk_edge;
+            const std::size_t col_begin = static_cast<std::size_t>(key) % num_chunk_cols * chunk_edge;
+            return {static_cast<int>(row_begin), static_cast<int>(std::min(row_begin + chunk_edge, num_cells / row_length)),
+                    static_cast<int>(col_begin), static_cast<int>(std::min(col_begin + chunk_edge, row_length))};
+        }
+
+        std::size_t num_cells{0};
+        std::size_t row_length{1}; ///< cells per row
+        std::size_t num_chunk_rows{0}; ///< chunks per column of the grid
+        std::size_t num_chunk_cols{0}; ///< chunks per row of the grid
+        std::vector<Chunk> chunks; ///< the chunk pool, free slots have key -1
+        std::vector<int> free_slots; ///< free slots of the pool, reused before the pool grows
+
+    private:
+        /// @brief the key of the chunk holding a cell
+        std::int64_t chunk_key(std::size_t cell) const {
+            return static_cast<std::int64_t>(cell / row_length / chunk_edge * num_chunk_cols + cell % row_length / chunk_edge);
+        }
+
+        /// @brief position of a cell within its chunk
+        std::size_t offset(std::size_t cell) const {
+            return cell / row_length % chunk_edge * chunk_edge + cell % row_length % chunk_edge;
+        }
+
+        /// @brief calls f(key) for the up to 8 chunks around a chunk, including wrapped ones
+        template <class F>
+        void for_each_neighbor(std::int64_t key, bool wrap, F&& f) const {
+            const std::int64_t rows = static_cast<std::int64_t>(num_chunk_rows), cols = static_cast<std::int64_t>(num_chunk_cols);
+            for (std::int64_t dr = -1; dr <= 1; ++dr) {
+                for (std::int64_t dc = -1; dc <= 1; ++dc) {
+                    std::int64_t row = key / cols + dr, col = key % cols + dc;
+                    if (wrap) {
+                        row = (row + rows) % rows;
+                        col = (col + cols) % cols;
+                    } else if (row < 0 or row >= rows or col < 0 or col >= cols) {
+                        continue;
+                    }
+                    if (row * cols + col != key) {
+                        f(row * cols + col);
+                    }
+                }
+            }
+        }
+
+        /// @brief calls f(cell) for the cells of one row in columns [col_begin, col_end) holding value
+        template <class F>
+        void for_each_in_row(int value, std::size_t row, std::size_t col_begin, std::size_t col_end, F& f) const {
+            const std::size_t first = row * row_length;
+            for (std::size_t col = col_begin; col < col_end; col = (col / chunk_edge + 1) * chunk_edge) {
+                const Chunk* chunk = find(chunk_key(first + col));
+                if (chunk and chunk->population[value] > 0) {
+                    scan_row(*chunk, value, row, col, std::min((col / chunk_edge + 1) * chunk_edge, col_end), first + col, first + col_end, f);
+                }
+            }
+        }
+
+        /// @brief calls f(cell) for the cells of one row of a chunk in columns [col_begin, col_end) and cells [begin, end) holding value
+        template <class F>
+        void scan_row(const Chunk& chunk, int value, std::size_t row, std::size_t col_begin, std::size_t col_end, std::size_t begin, std::size_t end, F& f) const {
+            const std::int8_t wanted = static_cast<std::int8_t>(value);
+            const std::int8_t* local = chunk.cells + row % chunk_edge * chunk_edge;
+            for (std::size_t col = col_begin; col < col_end; ++col) {
+                const std::size_t cell = row * row_length + col;
+                if (local[col % chunk_edge] == wanted and cell >= begin and cell < end) {
+                    f(cell);
+                }
+            }
+        }
+
+        /// @brief home position of a key in the index
+        std::size_t home(std::int64_t key) const {
+            return static_cast<std::size_t>((static_cast<std::uint64_t>(key) * 0x9E3779B97F4A7C15ull) >> 20) & (index_keys.size() - 1);
+        }
+
+        Chunk* find(std::int64_t key) {
+            return const_cast<Chunk*>(std::as_const(*this).find(key));
+        }
+
+        const Chunk* find(std::int64_t key) const {
+            if (index_keys.empty()) {
+                return nullptr;
+            }
+            // linear probing, the index is at most half full:
+            for (std::size_t i = home(key);; i = (i + 1) & (index_keys.size() - 1)) {
+                if (index_keys[i] == key) {
+                    return &chunks[index_slots[i]];
+                }
+                if (index_keys[i] < 0) {
+                    return nullptr;
+                }
+            }
+        }
+
+        /// @brief takes a pool slot for a new empty chunk and adds it to the index
+        int allocate(std::int64_t key) {
+            if (2 * (live_chunks() + 1) > index_keys.size()) {
+                rehash(std::max<std::size_t>(16, 2 * index_keys.size()));
+            }
+            int slot;
+            if (not free_slots.empty()) {
+                slot = free_slots.back();
+                free_slots.pop_back();
+            } else {
+                slot = static_cast<int>(chunks.size());
+                chunks.emplace_back();
+            }
+            Chunk& chunk = chunks[slot];
+            chunk.key = key;
+            std::fill(std::begin(chunk.population), std::end(chunk.population), 0);
+            std::memset(chunk.cells, -1, chunk_cells);
+            std::memset(chunk.scratch, 0, chunk_cells);
+            insert(key, slot);
+            return slot;
+        }
+
+        void insert(std::int64_t key, int slot) {
+            std::size_t i = home(key);
+            while (index_keys[i] >= 0) {
+                i = (i + 1) & (index_keys.size() - 1);
+            }
+            index_keys[i] = key;
+            index_slots[i] = slot;
+        }
+
+        /// @brief removes a key from the index, shifting the entries after it back so probing never needs tombstones
+        void erase(std::int64_t key) {
+            const std::size_t mask = index_keys.size() - 1;
+            std::size_t hole = home(key);
+            while (index_keys[hole] != key) {
+                hole = (hole + 1) & mask;
+            }
+            for (std::size_t i = (hole + 1) & mask; index_keys[i] >= 0; i = (i + 1) & mask) {
+                // an entry may move into the hole if its home isn't cyclically in (hole, i]:
+                const std::size_t entry_home = home(index_keys[i]);
+                if (((i - entry_home) & mask) >= ((i - hole) & mask)) {
+                    index_keys[hole] = index_keys[i];
+                    index_slots[hole] = index_slots[i];
+                    hole = i;
+                }
+            }
+            index_keys[hole] = -1;
+        }
+
+        void rehash(std::size_t capacity) {
+            index_keys.assign(capacity, -1);
+            index_slots.assign(capacity, -1);
+            for (std::size_t slot = 0; slot < chunks.size(); ++slot) {
+                if (chunks[slot].key >= 0) {
+                    insert(chunks[slot].key, static_cast<int>(slot));
+                }
+            }
+        }
+
+        std::vector<std::int64_t> index_keys; ///< open-addressing table of chunk keys, -1 for an empty entry, size a power of two
+        std::vector<int> index_slots; ///< pool slot of the chunk in the same entry of index_keys
+};
+
+/**
+ * @class GridStorage
+ * @brief a grid in one of the layouts of GridLayout, selectable at runtime
+ * @details get/set dispatch on every call and are meant for setup and output code. hot loops call visit() once and work on the concrete layout.
+ */
+class GridStorage {
+    public:
+        GridStorage() = default;
+
+        /**
+         * @brief creates a grid of empty cells
+         * @param num_cells number of cells
+         * @param layout memory layout of the cells
+         */
+        explicit GridStorage(std::size_t num_cells, GridLayout layout = GridLayout::Byte, std::size_t _row_length = 0) {
+            reset(num_cells, layout, _row_length);
+        }
+
+        /**
+         * @brief replaces the grid with num_cells empty cells in the given layout
+         * @param row_length cells per row, only the Chunked layout needs it. 0 keeps the previous row length, or one row if there was none
+         * @details a dense grid of the same layout and size is cleared in place, so pointers into its cells stay valid
+         */
+        void reset(std::size_t num_cells, GridLayout layout, std::size_t _row_length = 0) {
+            if (_row_length > 0) {
+                this->row_length = _row_length;
+            }
+            if (this->row_length == 0) {
+                this->row_length = std::max<std::size_t>(num_cells, 1);
+            }
+            if (layout == this->layout() and num_cells == size()) {
+                if (IntGrid* grid = std::get_if<IntGrid>(&cells)) {
+                    std::fill(grid->cells.begin(), grid->cells.end(), -1);
+                    return;
+                }
+                if (ByteGrid* grid = std::get_if<ByteGrid>(&cells)) {
+                    std::fill(grid->cells.begin(), grid->cells.end(), std::int8_t{-1});
+                    return;
+                }
+            }
+            switch (layout) {
+                case GridLayout::Int: cells = IntGrid(num_cells); break;
+                case GridLayout::Byte: cells = ByteGrid(num_cells); break;
+                case GridLayout::Bitboard: cells = BitboardGrid(num_cells); break;
+                case GridLayout::Chunked: cells = ChunkedGrid(num_cells, row_length); break;
+            }
+        }
+
+        /**
+         * @brief converts the grid into another layout, keeping the contents
+         * @param layout the new memory layout
+         */
+        void convert(GridLayout layout) {
+            if (layout == this->layout()) {
+                return;
+            }
+            GridStorage converted(size(), layout, row_length);
+            for (std::size_t cell = 0; cell < size(); ++cell) {
+                // empty cells are empty already, and writing them would allocate chunks for nothing:
+                const int value = get(cell);
+                if (value >= 0) {
+                    converted.set(cell, value);
+                }
+            }
+            *this = std::move(converted);
+        }
+
+        GridLayout layout() const { return static_cast<GridLayout>(cells.index()); }
+        std::size_t size() const { return std::visit([](const auto& grid) { return grid.size(); }, cells); }
+        int get(std::size_t cell) const { return std::visit([cell](const auto& grid) { return grid.get(cell); }, cells); }
+        void set(std::size_t cell, int value) { std::visit([cell, value](auto& grid) { grid.set(cell, value); }, cells); }
+        std::size_t count(int value) const { return std::visit([value](const auto& grid) { return grid.count(value); }, cells); }
+
+        /// @brief get() with a bounds check, throws std::out_of_range
+        int at(std::size_t cell) const {
+            if (cell >= size()) {
+                throw std::out_of_range("GridStorage::at: cell out of range");
+            }
+            return get(cell);
+        }
+
+        /**
+         * @brief calls f with the concrete layout, e.g. IntGrid&
+         * @param f generic callable
+         */
+        template <class F>
+        decltype(auto) visit(F&& f) {
+            return std::visit(std::forward<F>(f), cells);
+        }
+
+        template <class F>
+        decltype(auto) visit(F&& f) const {
+            return std::visit(std::forward<F>(f), cells);
+        }
+
+        variant<IntGrid, ByteGrid, BitboardGrid, ChunkedGrid> cells;
+        std::size_t row_length{0}; ///< cells per row of the grid
+};
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Thread Pool
+ * @section ThreadPool Thread Pool
+ * This section contains a small fixed-size thread pool used to update the grid tile by tile.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @class ThreadPool
+ * @brief fixed set of worker threads that run parallel_for jobs
+ * @details the calling thread takes part in every job, so a pool of size 1 has no worker threads and runs everything inline.
+ *          parallel_for returns only after every task is finished, so consecutive calls act as a barrier between phases.
+ *          jobs are passed by reference and never copied into a std::function, so a parallel_for does not allocate.
+ */
+class ThreadPool {
+    public:
+        /**
+         * @brief spawns the worker threads
+         * @param num_threads total number of threads including the calling thread, at least 1
+         */
+        explicit ThreadPool(int num_threads) {
+            for (int t = 1; t < num_threads; ++t) {
+                workers.emplace_back([this] { worker_loop(); });
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @brief wakes up all workers, tells them to stop and joins them
+         */
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+        }
+
+        /**
+         * @brief number of threads that work on a job, including the calling thread
+         */
+        int size() const {
+            return static_cast<int>(workers.size()) + 1;
+        }
+
+        /**
+         * @brief runs task(0), ..., task(num_tasks - 1) across the pool and waits for all of them
+         * @param num_tasks number of tasks, tasks are handed out dynamically one at a time
+         * @param task callable that is invoked with the task index, it has to outlive the call
+         */
+        template <class Task>
+        void parallel_for(int num_tasks, Task& task) {
+            // nothing to share - run inline and skip the synchronization:
+            if (workers.empty() or num_tasks <= 1) {
+                for (int t = 0; t < num_tasks; ++t) {
+                    task(t);
+                }
+                return;
+            }
+            TaskRef task_ref(task);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job = &task_ref;
+                job_size = num_tasks;
+                next_task = 0;
+                busy_workers = static_cast<int>(workers.size());
+                ++generation;
+            }
+            wake.notify_all();
+            // the calling thread helps out instead of idling:
+            drain();
+            // wait for the workers to finish their last task:
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return busy_workers == 0; });
+            job = nullptr;
+        }
+
+    private:
+        /**
+         * @brief non-owning reference to a callable taking the task index
+         */
+        struct TaskRef {
+            void* object; ///< the callable
+            void (*call)(void*, int); ///< calls the callable with a task index
+
+            template <class Task>
+            explicit TaskRef(Task& task) : object(&task), call([](void* _object, int t) { (*static_cast<Task*>(_object))(t); }) {}
+
+            void operator()(int t) const { call(object, t); }
+        };
+
+        /**
+         * @brief takes tasks off the current job until none are left
+         */
+        void drain() {
+            for (int t = next_task++; t < job_size; t = next_task++) {
+                (*job)(t);
+            }
+        }
+
+        /**
+         * @brief worker thread body: sleep until a new job or stop request arrives
+         */
+        void worker_loop() {
+            unsigned long seen_generation = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stopping or generation != seen_generation; });
+                    if (stopping) {
+                        return;
+                    }
+                    seen_generation = generation;
+                }
+                drain();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (--busy_workers == 0) {
+                        done.notify_one();
+                    }
+                }
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake; ///< signals a new job or a stop request to the workers
+        std::condition_variable done; ///< signals the calling thread that all workers are finished
+        const TaskRef* job{nullptr}; ///< current job, only valid during parallel_for
+        int job_size{0};
+        std::atomic<int> next_task{0};
+        int busy_workers{0};
+        unsigned long generation{0}; ///< incremented for every job so workers can tell new jobs apart
+        bool stopping{false};
+};
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Instrumentation
+ * @section Instrumentation Instrumentation
+ * This section contains the metrics of the step loop: wall-clock time per phase and per-species counters of how moves ended.
+ * Building with OCEAN_METRICS=0 compiles every timer and counter out of the step loop.
+ * ***********************************************************************************************************************************************************************
+ */
+#ifndef OCEAN_METRICS
+#define OCEAN_METRICS 1
+#endif
+
+/// @brief true if the step loop collects metrics, see OCEAN_METRICS
+constexpr bool metrics_enabled = OCEAN_METRICS != 0;
+
+/**
+ * @brief timed parts of a step
+ */
+enum class Phase : int { Ship = 0, Turtle, Trash, Events, Population, Render };
+
+/// @brief number of timed phases
+constexpr int num_phases = 6;
+
+/// @brief names of the phases, indexed by Phase, for the exported metrics. events is the event loop of the kinetic engine
+constexpr const char* phase_names[num_phases] = {"ship", "turtle", "trash", "events", "population", "render"};
+
+/**
+ * @brief how the moves of one species ended
+ * @details every agent of the species lands in exactly one of idle, out_of_bounds, blocks, deaths and moves per step.
+ *          destroyed counts agents of the species that were removed by another agent moving into them.
+ */
+struct SpeciesCounters {
+    std::uint64_t idle{0}; ///< agents that drew the idle direction
+    std::uint64_t out_of_bounds{0}; ///< moves rejected at the edge of the grid
+    std::uint64_t blocks{0}; ///< moves blocked by the collision rules or lost to another agent moving into the same cell
+    std::uint64_t deaths{0}; ///< agents that died moving into another object
+    std::uint64_t moves{0}; ///< moves that were carried out
+    std::uint64_t destroyed{0}; ///< agents removed by another agent moving into their cell
+
+    SpeciesCounters& operator+=(const SpeciesCounters& other) {
+        idle += other.idle;
+        out_of_bounds += other.out_of_bounds;
+        blocks += other.blocks;
+        deaths += other.deaths;
+        moves += other.moves;
+        destroyed += other.destroyed;
+        return *this;
+    }
+};
+
+/**
+ * @brief metrics of one or more steps
+ */
+struct Metrics {
+    std::uint64_t steps{0}; ///< steps covered by these metrics
+    double phase_seconds[num_phases]{}; ///< wall-clock time per phase, indexed by Phase
+    SpeciesCounters counters[3]; ///< counters per species, indexed by Occupy
+
+    /**
+     * @brief adds the metrics of other steps
+     */
+    Metrics& operator+=(const Metrics& other) {
+        steps += other.steps;
+        for (int phase = 0; phase < num_phases; ++phase) {
+            phase_seconds[phase] += other.phase_seconds[phase];
+        }
+        for (int species = 0; species < 3; ++species) {
+            counters[species] += other.counters[species];
+        }
+        return *this;
+    }
+};
+
+/**
+ * @brief adds the wall-clock time of its scope to one phase, compiled out without OCEAN_METRICS
+ */
+class PhaseTimer {
+    public:
+        PhaseTimer(double* _seconds) : seconds(_seconds) {
+            if constexpr (metrics_enabled) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~PhaseTimer() {
+            if constexpr (metrics_enabled) {
+                *seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+        }
+
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    private:
+        double* seconds;
+        std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - SIMD Kernels
+ * @section SimdKernels SIMD Kernels
+ * This section contains the collect and propose passes of the tiled engine on a Byte grid, for many cells or agents per instruction.
+ * Every kernel has an AVX2 version (32 cells or 8 agents per iteration) and an AVX-512 version (64 cells or 16 agents), compiled with
+ * target attributes so the rest of the build doesn't need the instruction sets. The version is picked at run time from the CPU, and the
+ * scalar code of Ocean stays the fallback. Agents next to the grid edge go back to the scalar kernel, so the vector kernels know nothing
+ * about boundaries. Results are bit-identical for every version.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @brief instruction sets of the vector kernels
+ */
+enum class SimdLevel {
+    Scalar = 0, ///< no vector kernel, one cell or agent at a time
+    Avx2 = 1, ///< 256-bit vectors
+    Avx512 = 2 ///< 512-bit vectors
+};
+
+/**
+ * @brief name of a SimdLevel for output, as the command line options spell it
+ */
+inline const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Avx2: return "avx2";
+        case SimdLevel::Avx512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+/**
+ * @brief the best SimdLevel the CPU runs, checked once
+ */
+inline SimdLevel supported_simd_level() {
+#if defined(__x86_64__) and defined(__GNUC__)
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") and __builtin_cpu_supports("avx512bw") and __builtin_cpu_supports("avx512dq")
+            and __builtin_cpu_supports("avx512vl")) {
+            return SimdLevel::Avx512;
+        }
+        return __builtin_cpu_supports("avx2") ? SimdLevel::Avx2 : SimdLevel::Scalar;
+    }();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+/**
+ * @brief inputs and outputs of the vector propose pass over the movers of one tile
+ */
+struct ProposeBatch {
+    const int* movers{nullptr}; ///< cells of the agents
+    int count{0}; ///< number of agents
+    const std::int8_t* cells{nullptr}; ///< the grid, one byte per cell
+    int num_rows{0}; ///< grid rows, at least 3
+    int num_cols{0}; ///< grid columns, at least 3
+    const int* direction_offsets{nullptr}; ///< cell offset of each of the 9 directions, see Ocean::direction_offsets
+    const std::int8_t* codes{nullptr}; ///< proposal code of the moving species against each of the 4 objects, indexed by Occupy + 1
+    std::uint64_t seed{0}; ///< CounterRng seed
+    std::uint64_t step{0}; ///< step of the draws
+    std::uint32_t stream{0}; ///< stream of the draws, the species
+    std::uint64_t threshold{0}; ///< idle threshold, see CounterRng::idle_threshold()
+    std::int8_t* directions{nullptr}; ///< out: direction of every agent
+    std::int8_t* proposals{nullptr}; ///< out: proposal code of every agent away from the edges, indexed by cell
+    int* edges{nullptr}; ///< out: indices into movers of the agents left to the scalar kernel
+    int num_edges{0}; ///< out: number of entries in edges
+    int idle{0}; ///< out: idle agents away from the edges
+    int blocked{0}; ///< out: blocked agents away from the edges
+};
+
+namespace simd {
+
+/**
+ * @brief the scalar end of a propose pass: draws the directions of agents [k, count) and lists them as edges
+ */
+inline void propose_rest(ProposeBatch& batch, int k) {
+    const CounterRng rng(batch.seed);
+    for (; k < batch.count; ++k) {
+        batch.directions[k] = CounterRng::direction(rng(batch.step, static_cast<std::uint32_t>(batch.movers[k]), batch.stream), batch.threshold);
+        batch.edges[batch.num_edges++] = k;
+    }
+}
+
+/**
+ * @brief the scalar end of a collect pass: appends the cells in [begin, end) holding value
+ */
+inline void collect_rest(const std::int8_t* cells, std::size_t begin, std::size_t end, std::int8_t value, std::vector<int>& movers) {
+    for (std::size_t cell = begin; cell < end; ++cell) {
+        if (cells[cell] == value) {
+            movers.push_back(static_cast<int>(cell));
+        }
+    }
+}
+
+#if defined(__x86_64__) and defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+/**
+ * @brief appends the cells in [begin, end) holding value to movers, 32 cells per compare
+ * @details the matches of a block come out of a bit mask lowest bit first, so there's no branch per cell
+ */
+inline void collect_avx2(const std::int8_t* cells, std::size_t begin, std::size_t end, std::int8_t value, std::vector<int>& movers) {
+    const __m256i wanted = _mm256_set1_epi8(value);
+    std::size_t cell = begin;
+    for (; cell + 32 <= end; cell += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + cell));
+        std::uint32_t matches = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, wanted)));
+        while (matches != 0) {
+            movers.push_back(static_cast<int>(cell) + __builtin_ctz(matches));
+            matches &= matches - 1;
+        }
+    }
+    collect_rest(cells, cell, end, value, movers);
+}
+
+/**
+ * @brief the high and low 32 bits of a * multiplier in every lane
+ */
+inline void multiply_wide_avx2(__m256i a, __m256i multiplier, __m256i& high, __m256i& low) {
+    // even lanes multiply in place, odd lanes shifted down:
+    const __m256i even = _mm256_mul_epu32(a, multiplier);
+    const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), multiplier);
+    high = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    low = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+}
+
+/**
+ * @brief the propose pass on 8 agents per iteration, bit-identical to CounterRng::fill_directions() and Ocean::propose_move()
+ * @details per iteration: Philox for 8 counters, directions from the first two words, rows and columns by a double precision
+ *          division, targets from the offset table, a gather of the target cells and the proposal codes from the code table.
+ *          the proposals go to their cells one at a time, since there is no byte scatter
+ */
+inline void propose_avx2(ProposeBatch& batch) {
+    alignas(32) int table[8];
+    for (int l = 0; l < 8; ++l) {
+        table[l] = batch.direction_offsets[1 + l];
+    }
+    const __m256i offsets = _mm256_load_si256(reinterpret_cast<const __m256i*>(table));
+    for (int l = 0; l < 8; ++l) {
+        table[l] = l < 4 ? batch.codes[l] : 0;
+    }
+    const __m256i codes = _mm256_load_si256(reinterpret_cast<const __m256i*>(table));
+    const __m256i one = _mm256_set1_epi32(1), seven = _mm256_set1_epi32(7), zero = _mm256_setzero_si256();
+    // unsigned compares flip the sign bits and compare signed:
+    const __m256i sign = _mm256_set1_epi32(INT_MIN);
+    const bool always_idle = batch.threshold > 0xFFFFFFFFull;
+    const __m256i threshold = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(batch.threshold))), sign);
+    const __m256i cols = _mm256_set1_epi32(batch.num_cols);
+    const __m256i inner_rows = _mm256_xor_si256(_mm256_set1_epi32(batch.num_rows - 2), sign);
+    const __m256i inner_cols = _mm256_xor_si256(_mm256_set1_epi32(batch.num_cols - 2), sign);
+    const __m256i last_read = _mm256_set1_epi32(batch.num_rows * batch.num_cols - 4);
+    const __m256d inverse_cols = _mm256_set1_pd(1. / batch.num_cols);
+    const __m256i m0 = _mm256_set1_epi32(static_cast<int>(philox_m0)), m1 = _mm256_set1_epi32(static_cast<int>(philox_m1));
+    const std::uint32_t key0 = static_cast<std::uint32_t>(batch.seed), key1 = static_cast<std::uint32_t>(batch.seed >> 32);
+    const __m256i stream = _mm256_set1_epi32(static_cast<int>(batch.stream));
+    const __m256i step0 = _mm256_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(batch.step)));
+    const __m256i step1 = _mm256_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(batch.step >> 32)));
+
+    alignas(32) int directions[8], proposals[8];
+    int k = 0;
+    for (; k + 8 <= batch.count; k += 8) {
+        const __m256i cell = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(batch.movers + k));
+
+        // Philox4x32-10 on counter (cell, stream, step), see philox4x32():
+        __m256i c0 = cell, c1 = stream, c2 = step0, c3 = step1;
+        std::uint32_t k0 = key0, k1 = key1;
+        for (int round = 0; round < 10; ++round) {
+            __m256i high0, low0, high1, low1;
+            multiply_wide_avx2(c0, m0, high0, low0);
+            multiply_wide_avx2(c2, m1, high1, low1);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(high1, c1), _mm256_set1_epi32(static_cast<int>(k0)));
+            c1 = low1;
+            c2 = _mm256_xor_si256(_mm256_xor_si256(high0, c3), _mm256_set1_epi32(static_cast<int>(k1)));
+            c3 = low0;
+            k0 += philox_w0;
+            k1 += philox_w1;
+        }
+        // direction 0 if idle, otherwise 1 + the top 3 bits of the second word, see CounterRng::direction():
+        const __m256i idle = always_idle ? _mm256_set1_epi32(-1) : _mm256_cmpgt_epi32(threshold, _mm256_xor_si256(c0, sign));
+        const __m256i dir = _mm256_andnot_si256(idle, _mm256_add_epi32(_mm256_srli_epi32(c1, 29), one));
+
+        // row = cell / cols in double precision, off by at most one, and corrected:
+        __m256i row = _mm256_set_m128i(_mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(cell, 1)), inverse_cols)),
+                                       _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(cell)), inverse_cols)));
+        __m256i col = _mm256_sub_epi32(cell, _mm256_mullo_epi32(row, cols));
+        const __m256i over = _mm256_cmpgt_epi32(col, _mm256_sub_epi32(cols, one));
+        row = _mm256_sub_epi32(row, over);
+        col = _mm256_sub_epi32(col, _mm256_and_si256(over, cols));
+        const __m256i under = _mm256_cmpgt_epi32(zero, col);
+        row = _mm256_add_epi32(row, under);
+        col = _mm256_add_epi32(col, _mm256_and_si256(under, cols));
+
+        // away from the edges, and the 4-byte gather stays inside the grid:
+        const __m256i target = _mm256_add_epi32(cell, _mm256_permutevar8x32_epi32(offsets, _mm256_and_si256(_mm256_sub_epi32(dir, one), seven)));
+        const __m256i interior = _mm256_andnot_si256(_mm256_cmpgt_epi32(target, last_read),
+            _mm256_and_si256(_mm256_cmpgt_epi32(inner_rows, _mm256_xor_si256(_mm256_sub_epi32(row, one), sign)),
+                             _mm256_cmpgt_epi32(inner_cols, _mm256_xor_si256(_mm256_sub_epi32(col, one), sign))));
+        __m256i existing = _mm256_mask_i32gather_epi32(zero, reinterpret_cast<const int*>(batch.cells), target, interior, 1);
+        existing = _mm256_srai_epi32(_mm256_slli_epi32(existing, 24), 24);
+        const __m256i code = _mm256_permutevar8x32_epi32(codes, _mm256_add_epi32(existing, one));
+        const __m256i moving = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi32(code, zero), _mm256_cmpeq_epi32(dir, zero)), _mm256_set1_epi32(-1));
+        const __m256i proposal = _mm256_and_si256(_mm256_or_si256(code, dir), moving);
+
+        _mm256_store_si256(reinterpret_cast<__m256i*>(directions), dir);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(proposals), proposal);
+        const unsigned inside = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(interior)));
+        const unsigned stays = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(dir, zero))));
+        const unsigned moves = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(moving)));
+        batch.idle += __builtin_popcount(inside & stays);
+        batch.blocked += __builtin_popcount(inside & ~stays & ~moves & 0xFF);
+        for (int l = 0; l < 8; ++l) {
+            batch.directions[k + l] = static_cast<std::int8_t>(directions[l]);
+            if (inside >> l & 1) {
+                batch.proposals[batch.movers[k + l]] = static_cast<std::int8_t>(proposals[l]);
+            } else {
+                batch.edges[batch.num_edges++] = k + l;
+            }
+        }
+    }
+    propose_rest(batch, k);
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw,avx512dq,avx512vl")
+/**
+ * @brief appends the cells in [begin, end) holding value to movers, 64 cells per compare, see collect_avx2()
+ */
+inline void collect_avx512(const std::int8_t* cells, std::size_t begin, std::size_t end, std::int8_t value, std::vector<int>& movers) {
+    const __m512i wanted = _mm512_set1_epi8(value);
+    std::size_t cell = begin;
+    for (; cell + 64 <= end; cell += 64) {
+        std::uint64_t matches = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(cells + cell), wanted);
+        while (matches != 0) {
+            movers.push_back(static_cast<int>(cell) + __builtin_ctzll(matches));
+            matches &= matches - 1;
+        }
+    }
+    // the rest of a row is often shorter than 64 cells, a masked compare saves the scalar loop:
+    if (cell < end) {
+        const __mmask64 rest = (std::uint64_t{1} << (end - cell)) - 1;
+        std::uint64_t matches = _mm512_mask_cmpeq_epi8_mask(rest, _mm512_maskz_loadu_epi8(rest, cells + cell), wanted);
+        while (matches != 0) {
+            movers.push_back(static_cast<int>(cell) + __builtin_ctzll(matches));
+            matches &= matches - 1;
+        }
+    }
+}
+
+/**
+ * @brief the high and low 32 bits of a * multiplier in every lane
+ */
+inline void multiply_wide_avx512(__m512i a, __m512i multiplier, __m512i& high, __m512i& low) {
+    const __m512i even = _mm512_mul_epu32(a, multiplier);
+    const __m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), multiplier);
+    high = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+    low = _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32));
+}
+
+/**
+ * @brief the propose pass on 16 agents per iteration, see propose_avx2()
+ */
+inline void propose_avx512(ProposeBatch& batch) {
+    alignas(64) int table[16];
+    for (int l = 0; l < 16; ++l) {
+        table[l] = batch.direction_offsets[1 + l % 8];
+    }
+    const __m512i offsets = _mm512_load_si512(table);
+    for (int l = 0; l < 16; ++l) {
+        table[l] = l < 4 ? batch.codes[l] : 0;
+    }
+    const __m512i codes = _mm512_load_si512(table);
+    const __m512i one = _mm512_set1_epi32(1), seven = _mm512_set1_epi32(7);
+    const bool always_idle = batch.threshold > 0xFFFFFFFFull;
+    const __m512i threshold = _mm512_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(batch.threshold)));
+    const __m512i cols = _mm512_set1_epi32(batch.num_cols);
+    const __m512i inner_rows = _mm512_set1_epi32(batch.num_rows - 2), inner_cols = _mm512_set1_epi32(batch.num_cols - 2);
+    const __m512i last_read = _mm512_set1_epi32(batch.num_rows * batch.num_cols - 4);
+    const __m512d inverse_cols = _mm512_set1_pd(1. / batch.num_cols);
+    const __m512i m0 = _mm512_set1_epi32(static_cast<int>(philox_m0)), m1 = _mm512_set1_epi32(static_cast<int>(philox_m1));
+    const std::uint32_t key0 = static_cast<std::uint32_t>(batch.seed), key1 = static_cast<std::uint32_t>(batch.seed >> 32);
+    const __m512i stream = _mm512_set1_epi32(static_cast<int>(batch.stream));
+    const __m512i step0 = _mm512_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(batch.step)));
+    const __m512i step1 = _mm512_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(batch.step >> 32)));
+
+    alignas(64) int proposals[16];
+    int k = 0;
+    for (; k + 16 <= batch.count; k += 16) {
+        const __m512i cell = _mm512_loadu_si512(batch.movers + k);
+
+        __m512i c0 = cell, c1 = stream, c2 = step0, c3 = step1;
+        std::uint32_t k0 = key0, k1 = key1;
+        for (int round = 0; round < 10; ++round) {
+            __m512i high0, low0, high1, low1;
+            multiply_wide_avx512(c0, m0, high0, low0);
+            multiply_wide_avx512(c2, m1, high1, low1);
+            c0 = _mm512_ternarylogic_epi32(high1, c1, _mm512_set1_epi32(static_cast<int>(k0)), 0x96);
+            c1 = low1;
+            c2 = _mm512_ternarylogic_epi32(high0, c3, _mm512_set1_epi32(static_cast<int>(k1)), 0x96);
+            c3 = low0;
+            k0 += philox_w0;
+            k1 += philox_w1;
+        }
+        const __mmask16 active = always_idle ? __mmask16{0} : _mm512_cmpge_epu32_mask(c0, threshold);
+        const __m512i dir = _mm512_maskz_add_epi32(active, _mm512_srli_epi32(c1, 29), one);
+
+        __m512i row = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvttpd_epi32(_mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(cell)), inverse_cols))),
+                                         _mm512_cvttpd_epi32(_mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(cell, 1)), inverse_cols)), 1);
+        __m512i col = _mm512_sub_epi32(cell, _mm512_mullo_epi32(row, cols));
+        const __mmask16 over = _mm512_cmpge_epi32_mask(col, cols);
+        row = _mm512_mask_add_epi32(row, over, row, one);
+        col = _mm512_mask_sub_epi32(col, over, col, cols);
+        const __mmask16 under = _mm512_cmplt_epi32_mask(col, _mm512_setzero_si512());
+        row = _mm512_mask_sub_epi32(row, under, row, one);
+        col = _mm512_mask_add_epi32(col, under, col, cols);
+
+        const __m512i target = _mm512_add_epi32(cell, _mm512_permutexvar_epi32(_mm512_and_si512(_mm512_sub_epi32(dir, one), seven), offsets));
+        const __mmask16 interior = _mm512_cmplt_epu32_mask(_mm512_sub_epi32(row, one), inner_rows)
+                                 & _mm512_cmplt_epu32_mask(_mm512_sub_epi32(col, one), inner_cols)
+                                 & _mm512_cmple_epi32_mask(target, last_read);
+        __m512i existing = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), interior, target, batch.cells, 1);
+        existing = _mm512_srai_epi32(_mm512_slli_epi32(existing, 24), 24);
+        const __m512i code = _mm512_permutexvar_epi32(_mm512_add_epi32(existing, one), codes);
+        const __mmask16 moving = _mm512_test_epi32_mask(code, code) & _mm512_test_epi32_mask(dir, dir);
+        const __m512i proposal = _mm512_maskz_or_epi32(moving, code, dir);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(batch.directions + k), _mm512_cvtepi32_epi8(dir));
+        _mm512_store_si512(proposals, proposal);
+        const unsigned stays = static_cast<unsigned>(_mm512_testn_epi32_mask(dir, dir));
+        batch.idle += __builtin_popcount(interior & stays);
+        batch.blocked += __builtin_popcount(interior & ~stays & ~static_cast<unsigned>(moving) & 0xFFFF);
+        for (unsigned inside = interior; inside != 0; inside &= inside - 1) {
+            const int l = __builtin_ctz(inside);
+            batch.proposals[batch.movers[k + l]] = static_cast<std::int8_t>(proposals[l]);
+        }
+        for (unsigned outside = static_cast<unsigned>(~interior) & 0xFFFF; outside != 0; outside &= outside - 1) {
+            batch.edges[batch.num_edges++] = k + __builtin_ctz(outside);
+        }
+    }
+    propose_rest(batch, k);
+}
+#pragma GCC pop_options
+#endif
+
+/**
+ * @brief appends the cells in [begin, end) holding value to movers with the collect kernel of the given level
+ */
+inline void collect(SimdLevel level, const std::int8_t* cells, std::size_t begin, std::size_t end, std::int8_t value, std::vector<int>& movers) {
+#if defined(__x86_64__) and defined(__GNUC__)
+    switch (level) {
+        case SimdLevel::Avx2: collect_avx2(cells, begin, end, value, movers); return;
+        case SimdLevel::Avx512: collect_avx512(cells, begin, end, value, movers); return;
+        case SimdLevel::Scalar: break;
+    }
+#endif
+    collect_rest(cells, begin, end, value, movers);
+}
+
+/**
+ * @brief runs the propose kernel of the given level
+ * @return false for SimdLevel::Scalar or a level this build doesn't have, the batch is untouched then
+ */
+inline bool propose(SimdLevel level, ProposeBatch& batch) {
+#if defined(__x86_64__) and defined(__GNUC__)
+    switch (level) {
+        case SimdLevel::Avx2: propose_avx2(batch); return true;
+        case SimdLevel::Avx512: propose_avx512(batch); return true;
+        case SimdLevel::Scalar: return false;
+    }
+#endif
+    return false;
+}
+
+} // namespace simd
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Generators
+ * @section Generators Generators
+ * Generator<T> is the coroutine type of lazy sequences such as Ocean::frames(): the body runs only when the consumer asks for the next
+ * element, and stops for good when the consumer stops asking. It is std::generator where the standard library has it. Otherwise
+ * it is the small generator below, which covers what a range-for over the sequence needs.
+ * ***********************************************************************************************************************************************************************
+ */
+#if defined(__cpp_lib_generator)
+template <class T>
+using Generator = std::generator<T>;
+#else
+/**
+ * @class Generator
+ * @brief a coroutine that yields T, consumed once through an input iterator
+ * @details elements are yielded by reference, so they live in the coroutine and are only valid until the iterator is advanced.
+ */
+template <class T>
+class Generator {
+    public:
+        struct promise_type {
+            const T* value{nullptr}; ///< the element of the last co_yield
+            std::exception_ptr error; ///< exception that ended the body, rethrown to the consumer
+
+            Generator get_return_object() { return Generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            // lazy: nothing runs before the consumer asks for the first element
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            std::suspend_always yield_value(const T& element) noexcept {
+                value = std::addressof(element);
+                return {};
+            }
+            void return_void() noexcept {}
+            void unhandled_exception() { error = std::current_exception(); }
+            // co_await isn't meant for a generator's body:
+            void await_transform() = delete;
+        };
+
+        /**
+         * @brief input iterator over the elements, advancing it resumes the coroutine
+         */
+        class iterator {
+            public:
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+
+                iterator() = default;
+                explicit iterator(std::coroutine_handle<promise_type> _handle) : handle(_handle) {}
+
+                const T& operator*() const { return *handle.promise().value; }
+                const T* operator->() const { return handle.promise().value; }
+                iterator& operator++() {
+                    resume(handle);
+                    return *this;
+                }
+                void operator++(int) { ++*this; }
+                bool operator==(std::default_sentinel_t) const { return not handle or handle.done(); }
+
+            private:
+                std::coroutine_handle<promise_type> handle;
+        };
+
+        Generator(Generator&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+        Generator& operator=(Generator&& other) noexcept {
+            if (this != &other) {
+                if (handle) {
+                    handle.destroy();
+                }
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+        Generator(const Generator&) = delete;
+        Generator& operator=(const Generator&) = delete;
+
+        /**
+         * @brief destroys the coroutine, wherever it is suspended
+         */
+        ~Generator() {
+            if (handle) {
+                handle.destroy();
+            }
+        }
+
+        /**
+         * @brief runs the body up to the first element
+         */
+        iterator begin() {
+            resume(handle);
+            return iterator(handle);
+        }
+        std::default_sentinel_t end() const noexcept { return {}; }
+
+    private:
+        explicit Generator(std::coroutine_handle<promise_type> _handle) : handle(_handle) {}
+
+        /**
+         * @brief runs the body up to its next element or its end, rethrowing what it threw
+         */
+        static void resume(std::coroutine_handle<promise_type> handle) {
+            handle.resume();
+            if (handle.done() and handle.promise().error) {
+                std::rethrow_exception(std::exchange(handle.promise().error, nullptr));
+            }
+        }
+
+        std::coroutine_handle<promise_type> handle;
+};
+#endif
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - class Ocean
+ * @section OceanClass class Ocean
+ * This section contains memebrs for Ocean class
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @class Ocean
+ * @brief 2d cellular representation of ocean with objects
+ */
+class Ocean {
+    public: // @todo later change to private/protected
+        /// @var int num_turtles
+        /// @brief Population of turtles in the simulation.
+        int num_turtle{0};
+        
+        /// @var int num_trashes
+        /// @brief Amount of trash present in the simulation.
+        int num_trash{0};
+        
+        /// @var int num_ships
+        /// @brief Number of ships involved in the simulation.
+        int num_ship{0};
+
+    
+    public:
+        /// @enum Occupy
+        /// @brief textual description of what's in the cell instead of "magic numbers"
+        enum class Occupy {
+            Empty = -1, ///< Represents an invalid state.
+            Turtle = 0, ///< Represents a turtle.
+            Trash = 1, ///< Represents a trash.
+            Ship = 2 ///< Represents a ship.
+        };
+
+        /// @var GridStorage grid
+        /// @brief Represents the 2D grid used in the simulation.
+        /// @details this stores the Occupy value of every cell in one of the GridLayouts. call invalidate_agents() after writing to it directly
+        GridStorage grid;
+        
+        /// @var int num_rows
+        /// @brief Total number of rows in the 2D grid.
+        int num_rows{0};
+        
+        /// @var int num_cols
+        /// @brief Total number of columns in the 2D grid.
+        int num_cols{0};
+        
+        /// @var int64_t num_cells
+        /// @brief Total number of cells in the 2D grid, calculated as num_rows * num_cols.
+        /// @details at most INT_MAX in the dense layouts. only a ChunkedGrid goes beyond, and the tiled engine indexes its cells with 64-bit integers
+        std::int64_t num_cells{0};
+
+        /**
+        * @brief Constructor for Ocean grid object
+        * @param m row size
+        * @param n column size
+        * @param _turtles turtle population
+        * @param _trash trash population
+        * @param _ships ship population
+        * @param layout memory layout of the grid, Chunked allocates nothing up front
+        * @return creates an ocean object with above parameters
+        * @throws std::invalid_argument if rows or cols isn't positive, or rows * cols doesn't fit an int in a dense layout
+        */
+        Ocean(int rows, int cols, int _turtles, int _trash, int _ships, GridLayout layout = GridLayout::Byte)
+            : num_rows(rows), num_cols(cols), num_turtle(_turtles), num_trash(_trash), num_ship(_ships) {
+            if (rows <= 0 or cols <= 0) {
+                throw std::invalid_argument("Ocean: rows and cols must be positive");
+            }
+            /// update number of cells
+            this->num_cells = static_cast<std::int64_t>(num_rows) * num_cols;
+            /// dense layouts and the engines that keep per-cell arrays index cells with ints:
+            require_layout_fits(layout);
+            /// consequenlty, update the grid vector size:
+            this->grid.reset(num_cells, layout, num_cols);
+            /// no cell has a pending move to begin with, chunked grids keep theirs in the chunks:
+            if (layout != GridLayout::Chunked) {
+                this->proposals.assign(num_cells, 0);
+            }
+            /// split the grid into tiles for update_grid():
+            this->set_tile_size(64, 64);
+            /// moves off the grid are rejected unless set_boundary() says otherwise:
+            this->set_boundary(Boundary::Reflecting);
+            /// draw the seed of the step loop from the shared engine, call seed() for a fixed one:
+            this->seed(random_engine()());
+        };
+        /**
+        * @brief Copy Constructor of Ocean Object
+        * @param m row size
+        * @param n column size
+        * @param _turtles turtle population
+        * @param _trash trash population
+        * @param _ships ship population
+        * @return creates a copied ocean object with above parameters
+        */
+        
+        /**
+        * @brief setter for a specific cell
+        * @param ocean the current object Ocean that this method is acting upon
+        * @param i index of row, starting at 0
+        * @param j index of column, starting at 0
+        * @param value value to update that cell
+        */
+        void set_cell(int i, int j, Ocean::Occupy value) {
+            // bounds check like get_cell, then write:
+            const std::size_t cell = static_cast<std::size_t>(i) * num_cols + j;
+            this->grid.at(cell);
+            this->grid.set(cell, static_cast<int>(value));
+            this->invalidate_agents();
+        }
+        /**
+        * @brief getter for a specific cell
+        * @param ocean the current object Ocean that this method is acting upon
+        * @param i index of row, starting at 0
+        * @param j index of column, starting at 0
+        * @return cell state in Occupy enum;
+        */
+        Ocean::Occupy get_cell(int i, int j) {
+            return static_cast<Ocean::Occupy>(this->grid.at(static_cast<std::size_t>(i) * num_cols + j));
+        }
+
+        /**
+        * @brief switches the memory layout of the grid, keeping its contents
+        * @param layout the new layout, see GridLayout
+        * @throws std::invalid_argument for the Chunked layout with an engine other than Tiled, or a dense layout of more than INT_MAX cells
+        */
+        void set_grid_layout(GridLayout layout) {
+            if (layout == GridLayout::Chunked and engine != Engine::Tiled) {
+                throw std::invalid_argument("set_grid_layout: the chunked layout only runs with the tiled engine");
+            }
+            require_layout_fits(layout);
+            if (layout == this->grid.layout()) {
+                return;
+            }
+            this->grid.convert(layout);
+            // pending moves live in the chunks of a chunked grid, and the tiles follow the chunks:
+            if (layout == GridLayout::Chunked) {
+                std::vector<std::int8_t>().swap(proposals);
+            } else {
+                proposals.assign(num_cells, 0);
+            }
+            this->set_tile_size(tile_height, tile_width);
+        }
+
+        /**
+        * @brief checks that the grid's cells can be held in a layout
+        * @throws std::invalid_argument if a dense layout would have more than INT_MAX cells, or any layout more than CounterRng keys
+        */
+        void require_layout_fits(GridLayout layout) const {
+            if (layout != GridLayout::Chunked and num_cells > INT_MAX) {
+                throw std::invalid_argument("Ocean: rows * cols must fit an int, except in the chunked layout");
+            }
+            if (static_cast<std::uint64_t>(num_cells) >= CounterRng::cell_limit) {
+                throw std::invalid_argument("Ocean: rows * cols must be below 2^56");
+            }
+        }
+
+        /**
+        * @brief creates corresponding ASCII character for each occupied state of the cell
+        * @param cell cell's occupied state - empty, turtle, ship, or trash:
+        * @return an ASCII character
+        */
+        char get_ascii(Occupy cell) {
+            // use switch-case to identify corresponding ascii char:
+            switch (cell) {
+                /// empty cell
+                case Occupy::Empty: return ' ';
+                /// turtle cell
+                case Occupy::Turtle: return 'o';
+                /// trash cell
+                case Occupy::Trash: return 'x';
+                /// ship cell
+                case Occupy::Ship: return '|';
+                default:
+                    return '?'; // place holder for possible unknown state
+            };
+        }
+
+        /**
+         * ***********************************************************************************************************************************************************************
+         * SUB_SECTION - Movement Logics
+         * @subsection ObjectMovement movement logics/definitions
+         * This section contains functions, enum classes that define movement & collision logic for objects
+         * ***********************************************************************************************************************************************************************
+         */
+        public:
+        //protected:
+            /**
+             * @brief class that defines possible directions of an object in a cell
+             * @details numbers for eaiser code writing
+             */
+            enum class Direction {
+                Idle = 0,    // No movement
+                East = 1,      // E
+                North = 2,     // N
+                West = 3,      // W
+                South = 4,     // S
+                NorthEast = 5, // NE
+                NorthWest = 6, // NW
+                SouthEast = 7, // SE
+                SouthWest = 8  // SW
+            };
+            
+            /**
+             * @brief class that defins possible optoins of collision outcome between two objects
+             * @details all of these are written interms of a current object that is moving into a new cell space:
+             */
+            enum class CollisionResult {
+                Move = 1, // moving object successfully moves into new space because there's nothing in new space
+                Die = 2, // movign object dies from collision (e.g. turtle dies after colliding with trash)
+                Block = 0, // moving object encounters same type of object (trash vs trash) or non-threatening object (ship vs turtle) and stays idle
+            };
+
+            /**
+             * @brief one entry of the collision matrix
+             */
+            struct CollisionRule {
+                Occupy moving_obj; ///< object that is moving
+                Occupy existing_obj; ///< object already in the target cell
+                CollisionResult result; ///< what happens to the moving object
+            };
+
+            /**
+             * @brief logic/outcome matrix for collision between two objects.
+             * @details Key: {Moving Object, Existing Object} and Value: Action for Moving Object
+             */
+            static constexpr CollisionRule collision_rules[] = {
+                // Turtle encounters an empty space -> It can move.
+                { Ocean::Occupy::Turtle, Ocean::Occupy::Empty,   Ocean::CollisionResult::Move },
+                // Turtle encounters trash -> It dies.
+                { Ocean::Occupy::Turtle, Ocean::Occupy::Trash,   Ocean::CollisionResult::Die },
+                // Turtle encounters a ship -> It dies.
+                { Ocean::Occupy::Turtle, Ocean::Occupy::Ship,    Ocean::CollisionResult::Die },
+                // Turtle encounters another turtle -> Movement is blocked.
+                { Ocean::Occupy::Turtle, Ocean::Occupy::Turtle,  Ocean::CollisionResult::Block },
+
+                // Trash encounters an empty space -> It can move.
+                { Ocean::Occupy::Trash,  Ocean::Occupy::Empty,   Ocean::CollisionResult::Move },
+                // Trash encounters a turtle -> It moves in and the turtle dies.
+                { Ocean::Occupy::Trash,  Ocean::Occupy::Turtle,  Ocean::CollisionResult::Move },
+                // Trash encounters another trash -> Movement is blocked.
+                { Ocean::Occupy::Trash,  Ocean::Occupy::Trash,   Ocean::CollisionResult::Block },
+                // Trash encounters a ship -> It gets collected.
+                { Ocean::Occupy::Trash,  Ocean::Occupy::Ship,    Ocean::CollisionResult::Die },
+
+                // Ship encounters an empty space -> It can move.
+                { Ocean::Occupy::Ship,   Ocean::Occupy::Empty,   Ocean::CollisionResult::Move },
+                // Ship encounters trash -> It survives and remains functional.
+                { Ocean::Occupy::Ship,   Ocean::Occupy::Trash,   Ocean::CollisionResult::Move },
+                // Ship encounters another ship -> Movement is blocked.
+                { Ocean::Occupy::Ship,   Ocean::Occupy::Ship,    Ocean::CollisionResult::Block },
+                // Ship encounters a turtle -> It moves in and the turtle dies.
+                { Ocean::Occupy::Ship,   Ocean::Occupy::Turtle,  Ocean::CollisionResult::Move}
+            };
+
+            /// @brief flat collision matrix, indexed by [moving object + 1][existing object + 1]
+            using CollisionTable = std::array<std::array<CollisionResult, 4>, 4>;
+
+            /**
+             * @brief collision_rules compiled into a flat table at compile time
+             * @details pairs without a rule (only moves of Empty) are Block. a lookup is two array indexings and can never insert anything.
+             */
+            static constexpr CollisionTable collision_logics = [] {
+                CollisionTable table{};
+                for (const CollisionRule& rule : collision_rules) {
+                    table[static_cast<int>(rule.moving_obj) + 1][static_cast<int>(rule.existing_obj) + 1] = rule.result;
+                }
+                return table;
+            }();
+
+            /**
+             * @brief looks up the collision matrix
+             * @param moving_obj object that is moving
+             * @param existing_obj object already in the target cell
+             * @return what happens to the moving object
+             */
+            static constexpr CollisionResult collision_outcome(Occupy moving_obj, Occupy existing_obj) {
+                return collision_logics[static_cast<int>(moving_obj) + 1][static_cast<int>(existing_obj) + 1];
+            }
+
+            /**
+             * @brief outcome of a single move: what the old and the new cell hold afterwards
+             */
+            struct MoveResult {
+                int i; ///< row index of the old cell
+                int j; ///< column index of the old cell
+                Occupy old_obj; ///< object in the old cell after the move
+                int new_i; ///< row index of the new cell
+                int new_j; ///< column index of the new cell
+                Occupy new_obj; ///< object in the new cell after the move
+            };
+
+            /**
+             * @brief performs collision logic between two objects and updates the cell
+             * @param i row index of 
+             * @param j column index
+             * @param direction the direction which the object will move to 
+             * @param moving_obj the object that is trying to move to new (i, j) coordinate
+             * @param arg_grid grid to work with
+             * @return MoveResult {curr_i, curr_j, moving_obj, new_i, new_j, colliding_obj}
+             */
+            MoveResult collision(int i, int j, int new_i, int new_j, Occupy moving_obj, const GridStorage& arg_grid) const {
+                // get the object existing at the new location that will "crash" with moving_obj
+                Occupy existing_obj = static_cast<Occupy>(arg_grid.get(new_i * num_cols + new_j));
+
+                // start performing collision logics:
+                switch (collision_outcome(moving_obj, existing_obj)) {
+                    // Case 1 - moving_obj can proceed to moving into new cell:
+                    case CollisionResult::Move:
+                        // current cell becomes empty and new cell becomes the moving_obj:
+                        return{i, j, Occupy::Empty, new_i, new_j, moving_obj};
+                    
+                    // Case 2 - moving_obj dies:
+                    case CollisionResult::Die:
+                        // current cell becomes empty:
+                        // new cell remains the same
+                        return{i, j, Occupy::Empty, new_i, new_j, existing_obj};
+
+                    case CollisionResult::Block:
+                    // Case 2 - moving_obj's move is Blocked:
+                        // new_cell and old_cell all remain the same:
+                        return{i, j, moving_obj, new_i, new_j, existing_obj};
+
+                    default:
+                        return{i, j, moving_obj, i, j, moving_obj};
+                }
+            };
+
+
+            /**
+             * ***********************************************************************************************************************************************************************
+             * SUB_SECTION - Boundaries
+             * @subsection Boundaries grid boundaries
+             * What happens to a move off the edge of the grid. Neighbors are looked up through row and column maps with one ghost entry on each side:
+             * row_map[i + 1] is row i, and the ghost entries row_map[0] and row_map[num_rows + 1] say where a move off the top or bottom edge ends up,
+             * -1 if it doesn't land on the grid. So a neighbor costs one add and one lookup per coordinate, without bounds checks.
+             * ***********************************************************************************************************************************************************************
+             */
+        public:
+            /**
+             * @brief boundary policies
+             */
+            enum class Boundary {
+                Reflecting = 0, ///< a move off the grid is rejected and the agent stays, the original behavior
+                Periodic = 1, ///< the grid wraps around like a torus
+                Absorbing = 2 ///< an agent moving off the grid leaves the ocean
+            };
+
+            /// @var Boundary boundary
+            /// @brief current boundary policy, change it with set_boundary()
+            Boundary boundary{Boundary::Reflecting};
+
+            /// @var vector<int> row_map
+            /// @brief row_map[i + 1] for i in -1..num_rows: the row a move into row i lands on, -1 if off the grid
+            std::vector<int> row_map;
+
+            /// @var vector<int> col_map
+            /// @brief col_map[j + 1] for j in -1..num_cols: the column a move into column j lands on, -1 if off the grid
+            std::vector<int> col_map;
+
+            /// @var int direction_offsets
+            /// @brief cell index offset of every direction, the neighbor of a cell away from the edges is cell + direction_offsets[dir]
+            int direction_offsets[9]{};
+
+            /**
+             * @brief selects the boundary policy and fills the ghost entries of the neighbor maps
+             * @param _boundary the policy
+             */
+            void set_boundary(Boundary _boundary) {
+                this->boundary = _boundary;
+                row_map.resize(num_rows + 2);
+                col_map.resize(num_cols + 2);
+                for (int i = 0; i < num_rows; ++i) {
+                    row_map[i + 1] = i;
+                }
+                for (int j = 0; j < num_cols; ++j) {
+                    col_map[j + 1] = j;
+                }
+                const bool periodic = boundary == Boundary::Periodic;
+                row_map[0] = periodic ? num_rows - 1 : -1;
+                row_map[num_rows + 1] = periodic ? 0 : -1;
+                col_map[0] = periodic ? num_cols - 1 : -1;
+                col_map[num_cols + 1] = periodic ? 0 : -1;
+                for (int dir = 0; dir < 9; ++dir) {
+                    direction_offsets[dir] = direction_rows[dir] * num_cols + direction_cols[dir];
+                }
+            }
+
+            /**
+             * @brief the cell a move from (i, j) with row and column offsets lands on
+             * @param i row index
+             * @param j column index
+             * @param row_offset -1, 0 or 1
+             * @param col_offset -1, 0 or 1
+             * @tparam Index cell index type, see CellIndex
+             * @return cell index, or -1 if the move leaves the grid
+             */
+            template <class Index = int>
+            Index neighbor(int i, int j, int row_offset, int col_offset) const {
+                int new_i = row_map[i + row_offset + 1];
+                int new_j = col_map[j + col_offset + 1];
+                return (new_i | new_j) < 0 ? -1 : static_cast<Index>(new_i) * num_cols + new_j;
+            }
+
+            /**
+             * @brief the cell a move from cell in direction dir lands on, -1 if the move leaves the grid
+             */
+            template <class Index>
+            Index neighbor(Index cell, int dir) const {
+                return neighbor<Index>(static_cast<int>(cell / num_cols), static_cast<int>(cell % num_cols), direction_rows[dir], direction_cols[dir]);
+            }
+
+            /**
+             * @brief updates coordinate to move the object to the desired position
+             * @param i row index
+             * @param j column index
+             * @param direction the direction which the object will move to 
+             * @param object the Occupy obejct in the cell
+             * @return MoveResult of the move, unchanged cells if the move is idle or rejected at the boundary
+             */
+            MoveResult move(int i, int j, Occupy object, Direction direction) {
+                // Exit early if the direction is Origin (no movement) or if object is empty
+                if (direction == Direction::Idle or object == Occupy::Empty) {
+                    return{i, j, object, i, j, object};
+                }
+                // Look up the new coordinates through the boundary maps
+                // BE CAREFUL: the (i, j) coordinates are (-y, x) in our case, so be careful
+                // @details for example, "moving East" in our printed grid is increasing j index
+                int dir = static_cast<int>(direction);
+                int target = neighbor(i, j, direction_rows[dir], direction_cols[dir]);
+                // Moves off the grid: the agent stays, or leaves the ocean with the absorbing boundary
+                if (target < 0) {
+                    if (boundary == Boundary::Absorbing) {
+                        return {i, j, Occupy::Empty, i, j, Occupy::Empty};
+                    }
+                    return {i, j, object, i, j, object};
+                }
+                int new_i = target / num_cols;
+                int new_j = target % num_cols;
+
+                // If within bounds, finish the moving logic with collision logic:
+                return this->collision(i, j, new_i, new_j, object, this->grid);
+            };
+        
+        public:
+        //protected:
+            /// @brief probability that a turtle stays idle in a step, by default the same as any one of the 9 moves
+            float turtle_idle_chance{1.f / 9.f};
+            /// @brief probability that a trash stays idle in a step
+            float trash_idle_chance{0.5f};
+            /// @brief probability that a ship stays idle in a step
+            float ship_idle_chance{0.2f};
+
+            /**
+             * @brief generates random direction based on the user-defined probability for object staying idle
+             * @param idle_chance the probability that object stays idle
+             * @return random integer that corresponds to one of the moves in class Direction based on user-set parameters of probability
+             */
+            Ocean::Direction random_direction(float idle_chance = (1. / 9.f)) {
+                // in total we have 9 moves total, with 1 move being idle and rest of 8 moves being active
+                // based on the given idle_chance, we return corresponding move with pre-defined probabilities
+                float random_num = random_float(0.0, 1.); // 100% percentage pdf
+                
+                // simulate idle_chance probability:
+                if (random_num < idle_chance) {
+                    // if probability satisfies, return Idle:
+                    return Ocean::Direction::Idle;
+                } else {
+                    // rest of the probability, return one of the active moves:
+                    return static_cast<Ocean::Direction>(random_int(1, 8));
+                }
+            }
+
+            /**
+             * @brief generates movement for an agent of one species on the ocean grid
+             * @tparam Species the species of the agent, selects the row of the collision matrix at compile time
+             * @param i row index
+             * @param j column index
+             * @param idle_chance the probability that the agent stays idle
+             */
+            template <Occupy Species>
+            MoveResult species_move(int i, int j, float idle_chance) {
+                return this->move(i, j, Species, this->random_direction(idle_chance));
+            }
+
+            /**
+             * @brief generates movement for a turtle on the ocean grid
+             * @details all moves have equal chance of being executed from enum class Direction
+             * @param i row index
+             * @param j column index
+             */
+            MoveResult turtle_move (int i, int j) {
+                return species_move<Occupy::Turtle>(i, j, turtle_idle_chance);
+            };
+            
+            /**
+             * @brief generates movement for a trash on the ocean grid
+             * @details 50% chance of staying idle and 50% of moving in any random direction
+             * @param i row index
+             * @param j column index
+             */
+            MoveResult trash_move (int i, int j) {
+                return species_move<Occupy::Trash>(i, j, trash_idle_chance);
+            };
+            /**
+             * @brief generates movement for a ship on the ocean grid
+             * @details 20% chance of staying idle and 80% of moving in any random direction
+             * @param i row index
+             * @param j column index
+             */        
+            MoveResult ship_move (int i, int j) {
+                return species_move<Occupy::Ship>(i, j, ship_idle_chance);
+            };
+
+        /**
+         * ***********************************************************************************************************************************************************************
+         * SUB_SECTION - Tiled Grid Update
+         * @subsection TiledUpdate tiled, multithreaded grid update
+         * The grid is split into rectangular tiles that are updated in parallel. Every species moves in its own phase, and every phase has two passes:
+         *  1. propose: each agent draws a direction from `rng` and looks up the collision outcome against the current grid. Moves that go anywhere are recorded in `proposals`.
+         *  2. resolve: each agent applies its own proposal. When several agents want the same cell, the agent with the lowest source cell index wins and the rest stay put.
+         * Same-species moves are always blocked in collision_logics, so a source cell is never the target of another move and every cell is written by one agent only.
+         * Directions are keyed on (seed, step, cell, species), so together this makes the result bit-identical for any scan order, tile size and number of threads,
+         * and tiles can write across their edges without locking.
+         * The rules of both passes are propose_rule(), winner_rule() and resolve_rule(). They see the grid through a view that maps cells to neighbors,
+         * objects, proposals and the keys that order contested moves, so FixedOcean and Subdomain run the same code on their own indexing.
+         * ***********************************************************************************************************************************************************************
+         */
+        public:
+            /**
+             * @brief index type of the cells of a layout: int on the dense layouts, 64-bit on a ChunkedGrid, which may have more than INT_MAX cells
+             */
+            template <class Cells>
+            using CellIndex = std::conditional_t<std::is_same_v<std::remove_const_t<Cells>, ChunkedGrid>, std::int64_t, int>;
+
+            /**
+             * @brief rectangular block of the grid that one thread updates at a time
+             * @tparam Index cell index type, see CellIndex
+             */
+            template <class Index>
+            struct BasicTile {
+                int row_begin{0}; ///< first row of the tile
+                int row_end{0}; ///< one past the last row of the tile
+                int col_begin{0}; ///< first column of the tile
+                int col_end{0}; ///< one past the last column of the tile
+                std::vector<Index> movers; ///< cells of this tile that hold the moving species in the current phase
+                std::vector<std::int8_t> directions; ///< direction drawn for each of the movers
+                std::vector<int> edges; ///< indices into movers that the SIMD propose pass leaves to the scalar kernel
+                std::vector<int> changed; ///< cells written during this step, only filled when track_changes is on, so the grid has at most INT_MAX cells
+                int removed[3]{0, 0, 0}; ///< agents removed from the grid during this step, indexed by Occupy
+                SpeciesCounters counters[3]; ///< move outcomes during this step, indexed by Occupy, merged into step_metrics
+            };
+
+            /// @brief a tile of a dense layout
+            using Tile = BasicTile<int>;
+
+            /// @brief a tile of a ChunkedGrid, one per chunk, see Chunked World
+            using ChunkTile = BasicTile<std::int64_t>;
+
+            /// @var vector<Tile> tiles
+            /// @brief tiles covering a dense grid in row-major order, empty on a ChunkedGrid
+            std::vector<Tile> tiles;
+
+            /// @var vector<ChunkTile> chunk_tiles
+            /// @brief chunk_tiles[slot] covers the chunk in pool slot slot of a ChunkedGrid, empty on a dense grid
+            std::vector<ChunkTile> chunk_tiles;
+
+            /// @brief the tiles of a layout, tiles or chunk_tiles
+            template <class Cells>
+            auto& tiles_of(const Cells&) {
+                if constexpr (std::is_same_v<Cells, ChunkedGrid>) {
+                    return chunk_tiles;
+                } else {
+                    return tiles;
+                }
+            }
+
+            /// @var vector<int8_t> proposals
+            /// @brief pending move of every cell in the current phase: direction in the low 4 bits, CollisionResult in the high bits, 0 if none.
+            ///        empty on a ChunkedGrid, which keeps the pending moves in its chunks
+            std::vector<std::int8_t> proposals;
+
+            /// @brief tile size of the last set_tile_size(), kept to split the grid again after a layout change
+            int tile_height{64}, tile_width{64};
+
+            /// @var CounterRng rng
+            /// @brief random numbers of the step loop, keyed on (seed, step, cell, species)
+            CounterRng rng;
+
+            /// @var uint64_t step
+            /// @brief number of steps simulated so far, part of the random number key
+            std::uint64_t step{0};
+
+            /// @var bool track_changes
+            /// @brief record the cells every step writes in changed_cells, for consumers that only look at what changed
+            bool track_changes{false};
+
+            /// @var vector<int> changed_cells
+            /// @brief sorted, unique cells written by the last update_grid(), only filled when track_changes is on
+            /// @details a cell can be listed and still hold the same value, e.g. when a ship moved out and another ship moved in
+            std::vector<int> changed_cells;
+
+            /// @var Metrics step_metrics
+            /// @brief phase timings and move counters of the last update_grid(), see Instrumentation
+            Metrics step_metrics;
+
+            /// @var double render_seconds
+            /// @brief time spent in print_grid() since the last step, added to the next step's metrics
+            double render_seconds{0.};
+
+            /// @var bool tile_scratch_ready
+            /// @brief true once the tiles' scratch buffers are large enough for any later step, see reserve_tile_scratch()
+            bool tile_scratch_ready{false};
+
+            /// @var ThreadPool* pool
+            /// @brief pool that runs the tiles, not owned by the ocean. nullptr runs all tiles on the calling thread
+            ThreadPool* pool{nullptr};
+
+            /// @var SimdLevel simd
+            /// @brief vector kernel of the propose pass on a Byte grid, the best the CPU runs unless set_simd() says otherwise
+            SimdLevel simd{supported_simd_level()};
+
+            /// @brief row offset of each Direction, indexed by the enum value
+            static constexpr int direction_rows[9] = {0, 0, -1, 0, 1, -1, -1, 1, 1};
+            /// @brief column offset of each Direction, indexed by the enum value
+            static constexpr int direction_cols[9] = {0, 1, 0, -1, 0, 1, -1, 1, -1};
+
+            /**
+             * @brief high bits of the proposal code for every (species, existing object) pair, 0 if the move is blocked
+             * @details indexed like collision_logics, so a proposal is (code | direction) without any branching on the outcome
+             */
+            static constexpr std::array<std::array<std::int8_t, 4>, 4> proposal_codes = [] {
+                std::array<std::array<std::int8_t, 4>, 4> codes{};
+                for (int moving = 0; moving < 4; ++moving) {
+                    for (int existing = 0; existing < 4; ++existing) {
+                        CollisionResult result = collision_logics[moving][existing];
+                        codes[moving][existing] = result == CollisionResult::Block ? 0 : static_cast<std::int8_t>(static_cast<int>(result) << 4);
+                    }
+                }
+                return codes;
+            }();
+
+            /// @brief proposal code of a Move in direction dir, see proposals
+            static constexpr std::int8_t move_code(int dir) {
+                return static_cast<std::int8_t>(dir | (static_cast<int>(CollisionResult::Move) << 4));
+            }
+
+            /**
+             * @brief propose rule of one agent
+             * @tparam Species the species of the agent
+             * @param view the grid: object(cell) is what a cell holds, absorbing() whether leaving the grid is a death
+             * @param dir direction drawn for the agent, 0..8
+             * @param target_of target_of(dir) is the cell the agent's move in direction dir lands on, -1 off the grid
+             * @return proposal code: 0 if the agent doesn't go anywhere, otherwise direction | CollisionResult << 4.
+             *         with the absorbing boundary a move off the grid is a Die proposal
+             */
+            template <Occupy Species, class View, class TargetOf>
+            static std::int8_t propose_rule(const View& view, int dir, TargetOf&& target_of) {
+                // idle agents don't go anywhere:
+                if (dir == 0) {
+                    return 0;
+                }
+                const auto target = target_of(dir);
+                if (target < 0) {
+                    // off the grid: rejected, or the agent leaves the ocean, which resolves like a death
+                    return view.absorbing() ? static_cast<std::int8_t>(dir | (static_cast<int>(CollisionResult::Die) << 4)) : 0;
+                }
+                const std::int8_t code = proposal_codes[static_cast<int>(Species) + 1][view.object(target) + 1];
+                return code == 0 ? 0 : static_cast<std::int8_t>(code | dir);
+            }
+
+            /**
+             * @brief winner rule of a contested cell: of the agents proposing a Move into it, the one with the lowest key moves
+             * @param view the grid: proposal(cell) is the pending move of a cell, key(cell) orders the sources, the global cell index
+             * @param source_of source_of(dir) is the cell a Move in direction dir into the contested cell comes from, -1 if there is none
+             * @return the winning source, -1 if no agent moves in
+             */
+            template <class View, class SourceOf>
+            static auto winner_rule(const View& view, SourceOf&& source_of) {
+                using Index = decltype(source_of(1));
+                using Key = decltype(view.key(Index{}));
+                Index winner = -1;
+                Key winner_key = std::numeric_limits<Key>::max();
+                for (int dir = 1; dir <= 8; ++dir) {
+                    const Index source = source_of(dir);
+                    if (source >= 0 and view.proposal(source) == move_code(dir) and view.key(source) < winner_key) {
+                        winner = source;
+                        winner_key = view.key(source);
+                    }
+                }
+                return winner;
+            }
+
+            /**
+             * @brief how resolve_rule() settled a proposal
+             */
+            template <class Index>
+            struct Resolution {
+                CollisionResult outcome; ///< Die, Move, or Block if another agent won the target
+                Index target; ///< the cell moved into, for a Move
+                int replaced; ///< the object a Move replaced in the target
+            };
+
+            /**
+             * @brief resolve rule of one agent with a proposal: a Die empties its cell, a Move that wins its target replaces whatever is there
+             * @tparam Species the species of the agent
+             * @param view the grid: target(cell, dir) is the cell a Move lands on, winner(target) the source that gets it (see winner_rule()),
+             *             object(cell) and set(cell, value) read and write the grid
+             * @param cell cell of the agent
+             * @param code its proposal, not 0
+             */
+            template <Occupy Species, class View, class Index>
+            static Resolution<Index> resolve_rule(View& view, Index cell, std::int8_t code) {
+                constexpr int empty = static_cast<int>(Occupy::Empty);
+                if (static_cast<CollisionResult>(code >> 4) == CollisionResult::Die) {
+                    // moving object dies, the target stays as it is:
+                    view.set(cell, empty);
+                    return {CollisionResult::Die, cell, empty};
+                }
+                const Index target = view.target(cell, code & 0xF);
+                if (view.winner(target) != cell) {
+                    // another agent claimed the target first, stay put:
+                    return {CollisionResult::Block, target, empty};
+                }
+                // the object in the target (if any) is replaced by the moving object:
+                const int replaced = view.object(target);
+                view.set(target, static_cast<int>(Species));
+                view.set(cell, empty);
+                return {CollisionResult::Move, target, replaced};
+            }
+
+            /**
+             * @brief the grid as the rules see it: cells in row-major order, neighbors through the boundary maps
+             */
+            template <class Cells>
+            struct GridView {
+                using Index = CellIndex<Cells>;
+                const Ocean& ocean; ///< the ocean, for its boundary and proposals
+                Cells& cells; ///< the grid in its concrete layout
+
+                // a Move never leaves the grid, only the periodic boundary can wrap it around an edge:
+                Index target(Index cell, int dir) const {
+                    return ocean.boundary == Boundary::Periodic ? ocean.neighbor(cell, dir) : cell + ocean.direction_offsets[dir];
+                }
+                Index winner(Index target) const { return ocean.move_winner(cells, target); }
+                int object(Index cell) const { return cells.get(cell); }
+                void set(Index cell, int value) const { cells.set(cell, value); }
+                bool absorbing() const { return ocean.boundary == Boundary::Absorbing; }
+                std::int8_t proposal(Index cell) const { return ocean.proposal(cells, cell); }
+                Index key(Index cell) const { return cell; }
+            };
+
+            /**
+             * @brief per-agent move kernel shared by both engines, propose_rule() on the ocean's grid
+             * @tparam Species the species of the agent
+             * @param cells the grid in its concrete layout
+             * @param i row index of the agent
+             * @param j column index of the agent
+             * @param dir direction drawn for the agent, 0..8
+             * @return proposal code, see propose_rule()
+             */
+            template <Occupy Species, class Cells>
+            std::int8_t propose_move(const Cells& cells, int i, int j, int dir) const {
+                return propose_rule<Species>(GridView<const Cells>{*this, cells}, dir,
+                                             [&](int d) { return neighbor<CellIndex<Cells>>(i, j, direction_rows[d], direction_cols[d]); });
+            }
+
+            /**
+             * @brief counts the agents whose proposal already decides how their move ends: idle, out of bounds or blocked
+             * @param counters counters of the agent's species
+             * @param cell cell of the agent
+             * @param dir direction drawn for the agent
+             * @param proposal proposal code from propose_move()
+             */
+            template <class Index>
+            void count_proposal(SpeciesCounters& counters, Index cell, int dir, std::int8_t proposal) const {
+                if (dir == 0) {
+                    counters.idle++;
+                } else if (proposal == 0) {
+                    if (neighbor(cell, dir) < 0) {
+                        counters.out_of_bounds++;
+                    } else {
+                        counters.blocks++;
+                    }
+                }
+            }
+
+            /**
+             * @brief splits the grid into tiles of (at most) tile_rows x tile_cols cells
+             * @param tile_rows number of rows per tile
+             * @param tile_cols number of columns per tile
+             */
+            void set_tile_size(int tile_rows, int tile_cols) {
+                this->tile_height = tile_rows;
+                this->tile_width = tile_cols;
+                tiles.clear();
+                chunk_tiles.clear();
+                std::fill(proposals.begin(), proposals.end(), 0);
+                this->tile_scratch_ready = false;
+                if (ChunkedGrid* chunked = std::get_if<ChunkedGrid>(&grid.cells)) {
+                    // a chunked grid has one tile per chunk in chunk_tiles, see prepare_chunk_tiles():
+                    chunked->clear_scratch();
+                    return;
+                }
+                for (int row = 0; row < num_rows; row += tile_rows) {
+                    for (int col = 0; col < num_cols; col += tile_cols) {
+                        Tile tile;
+                        tile.row_begin = row;
+                        tile.row_end = std::min(row + tile_rows, num_rows);
+                        tile.col_begin = col;
+                        tile.col_end = std::min(col + tile_cols, num_cols);
+                        tiles.push_back(std::move(tile));
+                    }
+                }
+            }
+
+            /**
+             * @brief sizes the scratch buffers of every tile for the largest phase it can ever see
+             * @details a tile never holds more agents of one species than its area or that species' population.
+             *          agents are never born, so after this the tiled engine does not allocate until the grid is changed from outside.
+             */
+            void reserve_tile_scratch() {
+                std::size_t most_agents = static_cast<std::size_t>(std::max({num_turtle, num_trash, num_ship, 0}));
+                for (Tile& tile : tiles) {
+                    std::size_t area = static_cast<std::size_t>(tile.row_end - tile.row_begin) * (tile.col_end - tile.col_begin);
+                    reserve_tile(tile, std::min(area, most_agents), area);
+                }
+                this->tile_scratch_ready = true;
+            }
+
+            /**
+             * @brief sizes the scratch buffers of one tile
+             * @param tile the tile
+             * @param most_movers most agents of one species the tile can hold
+             * @param area cells of the tile
+             */
+            template <class Index>
+            void reserve_tile(BasicTile<Index>& tile, std::size_t most_movers, std::size_t area) {
+                tile.movers.reserve(most_movers);
+                tile.directions.reserve(most_movers);
+                tile.edges.reserve(most_movers);
+                if (track_changes) {
+                    // a move writes two cells
+                    tile.changed.reserve(2 * area);
+                }
+            }
+
+            /**
+             * @brief turns recording of the changed cells of every step on or off
+             * @param on fill changed_cells in update_grid()
+             * @details the change lists are reserved here for the worst case, so recording keeps the step loop allocation free.
+             * @throws std::invalid_argument to turn it on for more than INT_MAX cells, the change lists hold int cells
+             */
+            void set_track_changes(bool on) {
+                if (on and num_cells > INT_MAX) {
+                    throw std::invalid_argument("set_track_changes: changes are only tracked on grids of at most INT_MAX cells");
+                }
+                this->track_changes = on;
+                // a chunked grid grows its change list with the occupied region instead:
+                if (on and grid.layout() != GridLayout::Chunked) {
+                    changed_cells.reserve(2 * static_cast<std::size_t>(num_cells));
+                }
+                this->tile_scratch_ready = false;
+            }
+
+            /**
+             * @brief seeds the random numbers of the step loop
+             * @param seed seed value, the same seed and initial grid reproduce the same run
+             */
+            void seed(std::uint64_t seed) {
+                this->rng = CounterRng(seed);
+            }
+
+            /**
+             * @brief selects the vector kernel of the propose pass, see SIMD Kernels
+             * @param level the kernel, lowered to the best one the CPU runs. every level gives the same results
+             */
+            void set_simd(SimdLevel level) {
+                this->simd = std::min(level, supported_simd_level());
+            }
+
+            /**
+             * @brief sets the thread pool used by update_grid()
+             * @param thread_pool pool to run the tiles on, nullptr to run everything on the calling thread
+             */
+            void set_thread_pool(ThreadPool* thread_pool) {
+                this->pool = thread_pool;
+            }
+
+            /**
+             * @brief runs task(tile) for every tile of a list, on the thread pool if there is one
+             * @param tile_list tiles or chunk_tiles
+             * @param task callable taking a tile of the list
+             */
+            template <class Tiles, class Task>
+            void for_each_tile(Tiles& tile_list, Task&& task) {
+                auto run_tile = [&](int t) { task(tile_list[t]); };
+                if (pool) {
+                    pool->parallel_for(static_cast<int>(tile_list.size()), run_tile);
+                } else {
+                    for (int t = 0; t < static_cast<int>(tile_list.size()); ++t) {
+                        run_tile(t);
+                    }
+                }
+            }
+
+            /**
+             * @brief pending move of a cell: an entry of proposals, or on a ChunkedGrid the scratch byte of the cell in its chunk
+             */
+            template <class Cells>
+            std::int8_t& proposal(Cells& cells, CellIndex<Cells> cell) {
+                if constexpr (std::is_same_v<Cells, ChunkedGrid>) {
+                    return cells.scratch(cell);
+                } else {
+                    return proposals[cell];
+                }
+            }
+
+            template <class Cells>
+            std::int8_t proposal(const Cells& cells, CellIndex<Cells> cell) const {
+                if constexpr (std::is_same_v<Cells, ChunkedGrid>) {
+                    return cells.scratch(cell);
+                } else {
+                    return proposals[cell];
+                }
+            }
+
+            /**
+             * @brief propose pass of a phase: records where the agents of one species in the tile want to move
+             * @tparam Species the species that moves in this phase
+             * @param tile the tile to work on
+             * @param cells the grid in its concrete layout
+             * @param idle_chance probability that an agent of this species stays idle
+             */
+            template <Occupy Species, class Cells>
+            void propose_moves(BasicTile<CellIndex<Cells>>& tile, Cells& cells, float idle_chance) {
+                using Index = CellIndex<Cells>;
+                // forget the proposals of the previous phase:
+                for (Index cell : tile.movers) {
+                    proposal(cells, cell) = 0;
+                }
+                tile.movers.clear();
+
+                // collect the agents of this phase, row by row, or the whole chunk at once if the tile is one:
+                auto collect = [&](std::size_t cell) { tile.movers.push_back(static_cast<Index>(cell)); };
+                if constexpr (std::is_same_v<Cells, ChunkedGrid>) {
+                    if (tile.row_begin < tile.row_end) {
+                        cells.for_each_of_chunk(static_cast<int>(Species), static_cast<std::size_t>(tile.row_begin) * num_cols + tile.col_begin, collect);
+                    }
+                } else {
+                    for (int i = tile.row_begin; i < tile.row_end; ++i) {
+                        if constexpr (std::is_same_v<Cells, ByteGrid>) {
+                            if (simd != SimdLevel::Scalar) {
+                                simd::collect(simd, cells.cells.data(), static_cast<std::size_t>(i) * num_cols + tile.col_begin,
+                                              static_cast<std::size_t>(i) * num_cols + tile.col_end, static_cast<std::int8_t>(Species), tile.movers);
+                                continue;
+                            }
+                        }
+                        cells.for_each_of(static_cast<int>(Species), i * num_cols + tile.col_begin, i * num_cols + tile.col_end, collect);
+                    }
+                }
+                // draw all of their directions in one go:
+                tile.directions.resize(tile.movers.size());
+                if constexpr (std::is_same_v<Cells, ByteGrid>) {
+                    if (simd != SimdLevel::Scalar and num_rows >= 3 and num_cols >= 3) {
+                        propose_moves_simd<Species>(tile, cells, idle_chance);
+                        return;
+                    }
+                }
+                rng.fill_directions(step, static_cast<std::uint32_t>(Species), tile.movers.data(), tile.movers.size(), idle_chance, tile.directions.data());
+
+                for (std::size_t k = 0; k < tile.movers.size(); ++k) {
+                    const Index cell = tile.movers[k];
+                    std::int8_t& code = proposal(cells, cell);
+                    code = propose_move<Species>(cells, static_cast<int>(cell / num_cols), static_cast<int>(cell % num_cols), tile.directions[k]);
+                    if constexpr (metrics_enabled) {
+                        count_proposal(tile.counters[static_cast<int>(Species)], cell, tile.directions[k], code);
+                    }
+                }
+            }
+
+            /**
+             * @brief propose pass on a Byte grid with the vector kernel of simd, see SIMD Kernels
+             * @details the kernel draws every direction and proposes the moves of the agents away from the edges, this finishes the
+             *          agents on the edges with propose_move(). the counts of the kernel go into the tile's counters
+             */
+            template <Occupy Species>
+            void propose_moves_simd(Tile& tile, ByteGrid& cells, float idle_chance) {
+                tile.edges.resize(tile.movers.size());
+                ProposeBatch batch;
+                batch.movers = tile.movers.data();
+                batch.count = static_cast<int>(tile.movers.size());
+                batch.cells = cells.cells.data();
+                batch.num_rows = num_rows;
+                batch.num_cols = num_cols;
+                batch.direction_offsets = direction_offsets;
+                batch.codes = proposal_codes[static_cast<int>(Species) + 1].data();
+                batch.seed = rng.seed;
+                batch.step = step;
+                batch.stream = static_cast<std::uint32_t>(Species);
+                batch.threshold = CounterRng::idle_threshold(idle_chance);
+                batch.directions = tile.directions.data();
+                batch.proposals = proposals.data();
+                batch.edges = tile.edges.data();
+                simd::propose(simd, batch);
+
+                for (int e = 0; e < batch.num_edges; ++e) {
+                    const int k = tile.edges[e];
+                    const int cell = tile.movers[k];
+                    proposals[cell] = propose_move<Species>(cells, cell / num_cols, cell % num_cols, tile.directions[k]);
+                    if constexpr (metrics_enabled) {
+                        count_proposal(tile.counters[static_cast<int>(Species)], cell, tile.directions[k], proposals[cell]);
+                    }
+                }
+                if constexpr (metrics_enabled) {
+                    tile.counters[static_cast<int>(Species)].idle += batch.idle;
+                    tile.counters[static_cast<int>(Species)].blocks += batch.blocked;
+                }
+            }
+
+            /**
+             * @brief finds the agent that gets to move into a cell, winner_rule() on the ocean's grid
+             * @param cells the grid in its concrete layout
+             * @param target cell index that agents may want to move into
+             * @return the lowest source cell index among agents proposing a Move into target, -1 if there is none
+             */
+            template <class Cells>
+            CellIndex<Cells> move_winner(const Cells& cells, CellIndex<Cells> target) const {
+                using Index = CellIndex<Cells>;
+                const GridView<const Cells> view{*this, cells};
+                const int target_i = static_cast<int>(target / num_cols);
+                const int target_j = static_cast<int>(target % num_cols);
+                // a source that moves into target with direction d sits at target - offset(d):
+                if (target_i > 0 and target_i < num_rows - 1 and target_j > 0 and target_j < num_cols - 1) {
+                    return winner_rule(view, [&](int dir) -> Index { return target - direction_offsets[dir]; });
+                }
+                // next to an edge the sources are wrapped by the boundary, or don't exist:
+                return winner_rule(view, [&](int dir) { return neighbor<Index>(target_i, target_j, -direction_rows[dir], -direction_cols[dir]); });
+            }
+
+            /**
+             * @brief resolve pass of a phase: applies the proposals of the tile's agents to the grid
+             * @tparam Species the species that moves in this phase
+             * @param tile the tile to work on
+             * @param cells the grid in its concrete layout
+             */
+            template <Occupy Species, class Cells>
+            void resolve_moves(BasicTile<CellIndex<Cells>>& tile, Cells& cells) {
+                using Index = CellIndex<Cells>;
+                const GridView<Cells> view{*this, cells};
+                for (Index cell : tile.movers) {
+                    // idle and blocked agents have nothing to apply:
+                    const std::int8_t code = proposal(cells, cell);
+                    if (code == 0) {
+                        continue;
+                    }
+                    const Resolution<Index> resolved = resolve_rule<Species>(view, cell, code);
+                    if (resolved.outcome == CollisionResult::Die) {
+                        tile.removed[static_cast<int>(Species)]++;
+                        if (track_changes) {
+                            tile.changed.push_back(static_cast<int>(cell));
+                        }
+                        if constexpr (metrics_enabled) {
+                            tile.counters[static_cast<int>(Species)].deaths++;
+                        }
+                        continue;
+                    }
+                    if (resolved.outcome == CollisionResult::Block) {
+                        if constexpr (metrics_enabled) {
+                            tile.counters[static_cast<int>(Species)].blocks++;
+                        }
+                        continue;
+                    }
+                    if (resolved.replaced != static_cast<int>(Occupy::Empty)) {
+                        tile.removed[resolved.replaced]++;
+                        if constexpr (metrics_enabled) {
+                            tile.counters[resolved.replaced].destroyed++;
+                        }
+                    }
+                    if constexpr (metrics_enabled) {
+                        tile.counters[static_cast<int>(Species)].moves++;
+                    }
+                    if (track_changes) {
+                        tile.changed.push_back(static_cast<int>(cell));
+                        tile.changed.push_back(static_cast<int>(resolved.target));
+                    }
+                }
+            }
+
+            /**
+             * @brief moves every agent of one species by one step, see Tiled Grid Update
+             * @tparam Species the species to move
+             * @param idle_chance probability that an agent of this species stays idle
+             */
+            template <Occupy Species>
+            void move_phase(float idle_chance) {
+                // dispatch on the layout once, the kernels below work on the concrete layout:
+                grid.visit([&](auto& cells) {
+                    if (engine == Engine::Sparse) {
+                        move_agents<Species>(cells, idle_chance);
+                        return;
+                    }
+                    if constexpr (std::is_same_v<std::decay_t<decltype(cells)>, ChunkedGrid>) {
+                        prepare_chunk_tiles<Species>(cells);
+                    }
+                    auto& tile_list = tiles_of(cells);
+                    for_each_tile(tile_list, [&](auto& tile) { propose_moves<Species>(tile, cells, idle_chance); });
+                    for_each_tile(tile_list, [&](auto& tile) { resolve_moves<Species>(tile, cells); });
+                });
+            }
+
+        /**
+         * ***********************************************************************************************************************************************************************
+         * SUB_SECTION - Chunked World
+         * @subsection ChunkedWorld tiled engine on a ChunkedGrid
+         * On a ChunkedGrid the tiles are the chunks: chunk_tiles[slot] covers the chunk in pool slot slot, and the pending moves live in the scratch
+         * bytes of the chunks instead of proposals. Before every phase the chunks around occupied chunks are allocated, so no move lands
+         * outside a chunk while the tiles run in parallel, and chunks without the moving species get an empty tile. After every step the
+         * chunks that emptied out are freed. Memory and step time follow the occupied region, not the nominal size of the grid.
+         * Cell indices of the chunk tiles are 64-bit, so a chunked grid can have more than INT_MAX cells, e.g. 100000 x 100000.
+         * ***********************************************************************************************************************************************************************
+         */
+        public:
+            /**
+             * @brief sets up one tile per chunk for a phase
+             * @tparam Species the species that moves in this phase
+             * @param cells the chunked grid
+             */
+            template <Occupy Species>
+            void prepare_chunk_tiles(ChunkedGrid& cells) {
+                cells.reserve_halo(boundary == Boundary::Periodic);
+                const std::size_t most_agents = static_cast<std::size_t>(std::max({num_turtle, num_trash, num_ship, 0}));
+                while (chunk_tiles.size() < cells.chunks.size()) {
+                    // the pool grew, new tiles are sized like reserve_tile_scratch() would:
+                    chunk_tiles.emplace_back();
+                    reserve_tile(chunk_tiles.back(), std::min(ChunkedGrid::chunk_cells, most_agents), ChunkedGrid::chunk_cells);
+                }
+                for (std::size_t slot = 0; slot < cells.chunks.size(); ++slot) {
+                    ChunkTile& tile = chunk_tiles[slot];
+                    const ChunkedGrid::Chunk& chunk = cells.chunks[slot];
+                    // forget the proposals of the previous phase here, the tile may be empty in this one:
+                    for (std::int64_t cell : tile.movers) {
+                        cells.scratch(cell) = 0;
+                    }
+                    tile.movers.clear();
+                    if (chunk.key < 0 or chunk.population[static_cast<int>(Species)] == 0) {
+                        tile.row_begin = tile.row_end = tile.col_begin = tile.col_end = 0;
+                        continue;
+                    }
+                    const std::array<int, 4> bounds = cells.chunk_bounds(chunk.key);
+                    tile.row_begin = bounds[0];
+                    tile.row_end = bounds[1];
+                    tile.col_begin = bounds[2];
+                    tile.col_end = bounds[3];
+                }
+            }
+
+            /**
+             * @brief frees the chunks that emptied out during a step, if the grid is chunked
+             */
+            void release_chunks() {
+                if (ChunkedGrid* chunked = std::get_if<ChunkedGrid>(&grid.cells)) {
+                    // the movers of a freed chunk can't be looked up anymore, and its scratch is zeroed when the slot is reused:
+                    chunked->release_empty(boundary == Boundary::Periodic, [&](int slot) {
+                        if (slot < static_cast<int>(chunk_tiles.size())) {
+                            chunk_tiles[slot].movers.clear();
+                        }
+                    });
+                }
+            }
+
+        /**
+         * ***********************************************************************************************************************************************************************
+         * SUB_SECTION - Sparse Agent Engine
+         * @subsection SparseEngine sparse agent-list engine
+         * Keeps a compact list of agent positions per species next to the grid, so a step costs O(agents) instead of O(cells).
+         * The grid stays the occupancy lookup for collisions. Moves follow the same propose/resolve rules and the same random numbers
+         * as the tiled engine, so both engines produce the same grid for the same seed.
+         * ***********************************************************************************************************************************************************************
+         */
+        public:
+            /**
+             * @brief selects how update_grid() finds the agents to move
+             */
+            enum class Engine {
+                Tiled, ///< scans every cell of every tile, parallel over tiles
+                Sparse, ///< walks the per-species agent lists, cost scales with population
+                Kinetic ///< asynchronous moves from an event queue, cost scales with the number of moves, see Kinetic Monte Carlo Engine
+            };
+
+            /**
+             * @brief positions of all agents of one species, as separate row and column arrays
+             */
+            struct AgentList {
+                std::vector<int> rows; ///< row index of each agent
+                std::vector<int> cols; ///< column index of each agent
+            };
+
+            /// @var Engine engine
+            /// @brief engine used by update_grid()
+            Engine engine{Engine::Tiled};
+
+            /// @var AgentList agents[3]
+            /// @brief agent lists of the sparse engine, indexed by Occupy
+            AgentList agents[3];
+
+            /// @var vector<int> agent_slots
+            /// @brief index of the cell's agent in its species' AgentList, only meaningful for occupied cells
+            std::vector<int> agent_slots;
+
+            /// @var vector<int> claims
+            /// @brief lowest source cell that wants to move into each cell during a phase, INT_MAX if none
+            std::vector<int> claims;
+
+            /// @var bool agents_valid
+            /// @brief false when the grid was changed behind the agent lists' back and they have to be rebuilt
+            bool agents_valid{false};
+
+            /// @brief scratch buffers of a sparse phase, kept around so phases don't allocate
+            std::vector<int> phase_cells, phase_targets;
+            std::vector<std::int8_t> phase_directions, phase_outcomes;
+
+            /**
+             * @brief selects the engine used by update_grid()
+             * @param _engine the engine to switch to
+             * @throws std::invalid_argument for an engine other than Tiled on a chunked grid, whose per-cell arrays would be dense
+             */
+            void set_engine(Engine _engine) {
+                if (_engine != Engine::Tiled and grid.layout() == GridLayout::Chunked) {
+                    throw std::invalid_argument("set_engine: the chunked layout only runs with the tiled engine");
+                }
+                this->engine = _engine;
+                this->agents_valid = false;
+                this->kinetic_valid = false;
+            }
+
+            /**
+             * @brief marks the agent lists and the tile scratch sizes as stale, call after writing to grid directly
+             */
+            void invalidate_agents() {
+                this->agents_valid = false;
+                this->kinetic_valid = false;
+                this->tile_scratch_ready = false;
+            }
+
+            /**
+             * @brief rebuilds the agent lists from the grid with one full scan
+             */
+            void rebuild_agents() {
+                agent_slots.assign(num_cells, -1);
+                claims.assign(num_cells, INT_MAX);
+                for (AgentList& list : agents) {
+                    list.rows.clear();
+                    list.cols.clear();
+                }
+                grid.visit([&](const auto& cells) {
+                    for (int obj = 0; obj < 3; ++obj) {
+                        cells.for_each_of(obj, 0, cells.size(), [&](std::size_t cell) {
+                            agent_slots[cell] = static_cast<int>(agents[obj].rows.size());
+                            agents[obj].rows.push_back(static_cast<int>(cell) / num_cols);
+                            agents[obj].cols.push_back(static_cast<int>(cell) % num_cols);
+                        });
+                    }
+                });
+                // agents are never born, so the lists can only shrink - size the phase scratch once here:
+                std::size_t most_agents = 0;
+                for (const AgentList& list : agents) {
+                    most_agents = std::max(most_agents, list.rows.size());
+                }
+                phase_cells.reserve(most_agents);
+                phase_targets.reserve(most_agents);
+                phase_directions.reserve(most_agents);
+                phase_outcomes.reserve(most_agents);
+                this->agents_valid = true;
+            }
+
+            /**
+             * @brief removes the agent in a cell from its species' list
+             * @param obj species of the agent
+             * @param cell cell index of the agent
+             * @details the last agent of the list takes its slot, so removal is O(1)
+             */
+            void remove_agent(int obj, int cell) {
+                AgentList& list = agents[obj];
+                int slot = agent_slots[cell];
+                int last = static_cast<int>(list.rows.size()) - 1;
+                list.rows[slot] = list.rows[last];
+                list.cols[slot] = list.cols[last];
+                agent_slots[list.rows[slot] * num_cols + list.cols[slot]] = slot;
+                list.rows.pop_back();
+                list.cols.pop_back();
+            }
+
+            /**
+             * @brief decrements the population counter of a species
+             * @param obj the species as stored in the grid
+             */
+            void count_removed(int obj) {
+                switch (static_cast<Occupy>(obj)) {
+                    case Occupy::Turtle: num_turtle--; break;
+                    case Occupy::Trash: num_trash--; break;
+                    case Occupy::Ship: num_ship--; break;
+                    default: break;
+                }
+            }
+
+            /**
+             * @brief moves every agent of one species by one step using the agent lists
+             * @tparam Species the species to move
+             * @param cells the grid in its concrete layout
+             * @param idle_chance probability that an agent of this species stays idle
+             * @details propose: every agent draws a direction and records its target and outcome, Moves claim their target.
+             *          resolve: winners of a claim move and replace the object in the target, Die outcomes empty the source.
+             */
+            template <Occupy Species, class Cells>
+            void move_agents(Cells& cells, float idle_chance) {
+                if (not agents_valid) {
+                    rebuild_agents();
+                }
+                AgentList& list = agents[static_cast<int>(Species)];
+                const std::size_t count = list.rows.size();
+
+                // propose: draw directions in bulk and record targets
+                phase_cells.resize(count);
+                for (std::size_t k = 0; k < count; ++k) {
+                    phase_cells[k] = list.rows[k] * num_cols + list.cols[k];
+                }
+                phase_directions.resize(count);
+                rng.fill_directions(step, static_cast<std::uint32_t>(Species), phase_cells.data(), count, idle_chance, phase_directions.data());
+
+                phase_targets.resize(count);
+                phase_outcomes.resize(count);
+                for (std::size_t k = 0; k < count; ++k) {
+                    int dir = phase_directions[k];
+                    std::int8_t code = propose_move<Species>(cells, list.rows[k], list.cols[k], dir);
+                    // off-grid targets are never claimed, they are either rejected or absorbed:
+                    int target = neighbor(list.rows[k], list.cols[k], direction_rows[dir], direction_cols[dir]);
+                    phase_targets[k] = target;
+                    phase_outcomes[k] = static_cast<std::int8_t>(code >> 4);
+                    if constexpr (metrics_enabled) {
+                        count_proposal(step_metrics.counters[static_cast<int>(Species)], phase_cells[k], dir, code);
+                    }
+                    if (phase_outcomes[k] == static_cast<std::int8_t>(CollisionResult::Move)) {
+                        claims[target] = std::min(claims[target], phase_cells[k]);
+                    }
+                }
+
+                // resolve: apply in list order, the claims already decided who wins
+                std::size_t died = 0;
+                for (std::size_t k = 0; k < count; ++k) {
+                    CollisionResult outcome = static_cast<CollisionResult>(phase_outcomes[k]);
+                    int cell = phase_cells[k];
+                    if (outcome == CollisionResult::Die) {
+                        cells.set(cell, static_cast<int>(Occupy::Empty));
+                        if (track_changes) {
+                            changed_cells.push_back(cell);
+                        }
+                        // mark the slot dead, the list is compacted after the loop
+                        list.rows[k] = -1;
+                        died++;
+                        if constexpr (metrics_enabled) {
+                            step_metrics.counters[static_cast<int>(Species)].deaths++;
+                        }
+                        continue;
+                    }
+                    if (outcome != CollisionResult::Move) {
+                        continue;
+                    }
+                    int target = phase_targets[k];
+                    if (claims[target] != cell) {
+                        if constexpr (metrics_enabled) {
+                            step_metrics.counters[static_cast<int>(Species)].blocks++;
+                        }
+                        continue;
+                    }
+                    // the object in the target (if any) is replaced by the moving object:
+                    int existing_obj = cells.get(target);
+                    if (existing_obj != static_cast<int>(Occupy::Empty)) {
+                        count_removed(existing_obj);
+                        remove_agent(existing_obj, target);
+                        if constexpr (metrics_enabled) {
+                            step_metrics.counters[existing_obj].destroyed++;
+                        }
+                    }
+                    if constexpr (metrics_enabled) {
+                        step_metrics.counters[static_cast<int>(Species)].moves++;
+                    }
+                    cells.set(target, static_cast<int>(Species));
+                    cells.set(cell, static_cast<int>(Occupy::Empty));
+                    if (track_changes) {
+                        changed_cells.push_back(cell);
+                        changed_cells.push_back(target);
+                    }
+                    list.rows[k] = target / num_cols;
+                    list.cols[k] = target % num_cols;
+                    agent_slots[target] = static_cast<int>(k);
+                }
+
+                // reset only the claims that were touched:
+                for (std::size_t k = 0; k < count; ++k) {
+                    if (phase_outcomes[k] == static_cast<std::int8_t>(CollisionResult::Move)) {
+                        claims[phase_targets[k]] = INT_MAX;
+                    }
+                }
+
+                // drop the agents that died, keeping the order of the survivors:
+                if (died > 0) {
+                    std::size_t kept = 0;
+                    for (std::size_t k = 0; k < count; ++k) {
+                        if (list.rows[k] < 0) {
+                            continue;
+                        }
+                        list.rows[kept] = list.rows[k];
+                        list.cols[kept] = list.cols[k];
+                        agent_slots[list.rows[kept] * num_cols + list.cols[kept]] = static_cast<int>(kept);
+                        kept++;
+                    }
+                    list.rows.resize(kept);
+                    list.cols.resize(kept);
+                    for (std::size_t d = 0; d < died; ++d) {
+                        count_removed(static_cast<int>(Species));
+                    }
+                }
+            }
+
+        /**
+         * ***********************************************************************************************************************************************************************
+         * SUB_SECTION - Kinetic Monte Carlo Engine
+         * @subsection KineticEngine kinetic Monte Carlo engine
+         * An asynchronous alternative to the step-synchronous engines. Time is continuous and measured in steps.
+         * Every agent attempts moves as a Poisson process with rate 1 - idle chance of its species, so it makes as many move attempts per step
+         * on average as in the synchronous engines, and idle agents cost nothing. The next attempt of every agent sits in a binary heap ordered by time.
+         * An attempt picks one of the 8 directions uniformly and is resolved right away with collision_outcome(), so there are no conflicting moves.
+         * update_grid() handles all attempts up to the next whole step. Waiting times are memoryless, so every step starts by redrawing the pending attempts
+         * of all living agents from the step's start. The random numbers of an agent's n-th attempt in a step come from CounterRng(step, n, cell at the start
+         * of the step, kinetic_stream), and ties are broken by that cell. A step then only depends on the seed, the step and the grid it starts from,
+         * so runs resumed from a checkpoint match the uninterrupted run.
+         * ***********************************************************************************************************************************************************************
+         */
+        public:
+            /**
+             * @brief one agent of the kinetic engine
+             */
+            struct KineticAgent {
+                int cell{0}; ///< cell of the agent
+                Occupy species{Occupy::Empty}; ///< species of the agent
+                bool alive{true}; ///< false once the agent died or was destroyed
+                std::int8_t direction{0}; ///< direction of the next attempt, 1..8
+                int origin{0}; ///< cell of the agent at the start of the step, keys its random numbers and breaks ties
+                std::uint32_t attempts{0}; ///< attempts drawn so far in the step, the counter of the next draw
+                std::array<std::uint32_t, 4> bits{}; ///< CounterRng block of the current pair of attempts
+                double next_time{0.}; ///< time of the next attempt
+            };
+
+            /**
+             * @brief a pending move attempt in the event queue
+             */
+            struct KineticEvent {
+                double time; ///< when the attempt happens
+                int origin; ///< cell of the agent at the start of the step
+                int agent; ///< index into kinetic_agents
+
+                /// @brief later events compare greater, ties are broken by origin so the order doesn't depend on the agent indices
+                bool operator>(const KineticEvent& other) const {
+                    return time > other.time or (time == other.time and origin > other.origin);
+                }
+            };
+
+            /// @brief CounterRng stream of the kinetic engine, apart from the species streams of the synchronous engines
+            static constexpr std::uint32_t kinetic_stream = 3;
+
+            /// @var vector<KineticAgent> kinetic_agents
+            /// @brief every agent present at the start of the step, dead agents are dropped when the next step starts
+            std::vector<KineticAgent> kinetic_agents;
+
+            /// @var vector<int> kinetic_slots
+            /// @brief index into kinetic_agents of the agent in every cell, -1 for empty cells
+            std::vector<int> kinetic_slots;
+
+            /// @var vector<KineticEvent> kinetic_queue
+            /// @brief min-heap of the next attempt of every living agent, at most one entry per agent
+            std::vector<KineticEvent> kinetic_queue;
+
+            /// @var bool kinetic_valid
+            /// @brief false when the kinetic state has to be rebuilt from the grid
+            bool kinetic_valid{false};
+
+            /**
+             * @brief idle chance of a species
+             */
+            float idle_chance_of(Occupy species) const {
+                switch (species) {
+                    case Occupy::Turtle: return turtle_idle_chance;
+                    case Occupy::Trash: return trash_idle_chance;
+                    case Occupy::Ship: return ship_idle_chance;
+                    default: return 1.f;
+                }
+            }
+
+            /**
+             * @brief draws the next attempt of an agent and queues it if it happens before the next whole step
+             * @param id index of the agent
+             * @param now current time, the attempt happens after it
+             * @param heapify false while restart_kinetic_attempts() fills the queue, which it turns into a heap once at the end
+             * @details an agent of a species that never moves (idle chance 1) is never queued. Attempts after the end of the step are dropped,
+             *          the next step redraws them. One CounterRng block holds two attempts, the agent keeps the second one
+             */
+            void schedule_attempt(int id, double now, bool heapify = true) {
+                KineticAgent& agent = kinetic_agents[id];
+                const double rate = 1. - static_cast<double>(idle_chance_of(agent.species));
+                if (rate <= 0.) {
+                    return;
+                }
+                if (agent.attempts % 2 == 0) {
+                    const std::uint64_t counter = static_cast<std::uint64_t>(step) << 32 | agent.attempts / 2;
+                    agent.bits = rng(counter, static_cast<std::uint32_t>(agent.origin), kinetic_stream);
+                }
+                const std::uint32_t time_bits = agent.bits[2 * (agent.attempts % 2)];
+                const std::uint32_t direction_bits = agent.bits[2 * (agent.attempts % 2) + 1];
+                agent.attempts++;
+                // exponential waiting time from a uniform number in (0, 1):
+                const double uniform = (static_cast<double>(time_bits) + 0.5) * (1. / 4294967296.);
+                agent.next_time = now - std::log(uniform) / rate;
+                if (agent.next_time >= static_cast<double>(step + 1)) {
+                    return;
+                }
+                agent.direction = static_cast<std::int8_t>(1 + ((static_cast<std::uint64_t>(direction_bits) * 8) >> 32));
+                kinetic_queue.push_back({agent.next_time, agent.origin, id});
+                if (heapify) {
+                    std::push_heap(kinetic_queue.begin(), kinetic_queue.end(), std::greater<>());
+                }
+            }
+
+            /**
+             * @brief builds the agents from the grid
+             */
+            template <class Cells>
+            void rebuild_kinetic(const Cells& cells) {
+                kinetic_agents.clear();
+                kinetic_queue.clear();
+                kinetic_slots.assign(num_cells, -1);
+                for (int cell = 0; cell < num_cells; ++cell) {
+                    int value = cells.get(cell);
+                    if (value == static_cast<int>(Occupy::Empty)) {
+                        continue;
+                    }
+                    kinetic_slots[cell] = static_cast<int>(kinetic_agents.size());
+                    kinetic_agents.push_back({cell, static_cast<Occupy>(value)});
+                }
+                // every living agent has at most one queued attempt, so the heap never grows past this:
+                kinetic_queue.reserve(kinetic_agents.size());
+                this->kinetic_valid = true;
+            }
+
+            /**
+             * @brief drops the dead agents and the pending attempts, and draws the first attempt of every living agent from the start of the current step
+             */
+            void restart_kinetic_attempts() {
+                kinetic_queue.clear();
+                int living = 0;
+                for (const KineticAgent& previous : kinetic_agents) {
+                    if (not previous.alive) {
+                        continue;
+                    }
+                    KineticAgent& agent = kinetic_agents[living];
+                    agent = previous;
+                    agent.origin = agent.cell;
+                    agent.attempts = 0;
+                    kinetic_slots[agent.cell] = living;
+                    schedule_attempt(living, static_cast<double>(step), false);
+                    ++living;
+                }
+                kinetic_agents.resize(living);
+                std::make_heap(kinetic_queue.begin(), kinetic_queue.end(), std::greater<>());
+            }
+
+            /**
+             * @brief removes an agent from the grid bookkeeping and the populations
+             */
+            void kill_kinetic_agent(int id) {
+                KineticAgent& agent = kinetic_agents[id];
+                agent.alive = false;
+                kinetic_slots[agent.cell] = -1;
+                count_removed(static_cast<int>(agent.species));
+            }
+
+            /**
+             * @brief handles every move attempt before the next whole step
+             * @tparam Cells concrete grid layout
+             * @param cells the grid
+             */
+            template <class Cells>
+            void kinetic_events(Cells& cells) {
+                if (not kinetic_valid) {
+                    rebuild_kinetic(cells);
+                }
+                restart_kinetic_attempts();
+                const double end = static_cast<double>(step + 1);
+                while (not kinetic_queue.empty() and kinetic_queue.front().time < end) {
+                    std::pop_heap(kinetic_queue.begin(), kinetic_queue.end(), std::greater<>());
+                    const KineticEvent event = kinetic_queue.back();
+                    kinetic_queue.pop_back();
+                    KineticAgent& agent = kinetic_agents[event.agent];
+                    // attempts of agents that were destroyed in the meantime are dropped:
+                    if (not agent.alive) {
+                        continue;
+                    }
+                    const int species = static_cast<int>(agent.species);
+                    const int target = neighbor(agent.cell, agent.direction);
+                    if (target < 0 and boundary == Boundary::Absorbing) {
+                        // the agent leaves the ocean:
+                        cells.set(agent.cell, static_cast<int>(Occupy::Empty));
+                        if (track_changes) {
+                            changed_cells.push_back(agent.cell);
+                        }
+                        kill_kinetic_agent(event.agent);
+                        if constexpr (metrics_enabled) {
+                            step_metrics.counters[species].deaths++;
+                        }
+                        continue;
+                    }
+                    if (target < 0) {
+                        if constexpr (metrics_enabled) {
+                            step_metrics.counters[species].out_of_bounds++;
+                        }
+                        schedule_attempt(event.agent, event.time);
+                        continue;
+                    }
+                    const Occupy existing_obj = static_cast<Occupy>(cells.get(target));
+                    switch (collision_outcome(agent.species, existing_obj)) {
+                        case CollisionResult::Block:
+                            if constexpr (metrics_enabled) {
+                                step_metrics.counters[species].blocks++;
+                            }
+                            schedule_attempt(event.agent, event.time);
+                            break;
+
+                        case CollisionResult::Die:
+                            // moving object dies, the target stays as it is:
+                            cells.set(agent.cell, static_cast<int>(Occupy::Empty));
+                            if (track_changes) {
+                                changed_cells.push_back(agent.cell);
+                            }
+                            kill_kinetic_agent(event.agent);
+                            if constexpr (metrics_enabled) {
+                                step_metrics.counters[species].deaths++;
+                            }
+                            break;
+
+                        case CollisionResult::Move:
+                            // the object in the target (if any) is replaced by the moving object:
+                            if (existing_obj != Occupy::Empty) {
+                                kill_kinetic_agent(kinetic_slots[target]);
+                                if constexpr (metrics_enabled) {
+                                    step_metrics.counters[static_cast<int>(existing_obj)].destroyed++;
+                                }
+                            }
+                            cells.set(target, species);
+                            cells.set(agent.cell, static_cast<int>(Occupy::Empty));
+                            if (track_changes) {
+                                changed_cells.push_back(agent.cell);
+                                changed_cells.push_back(target);
+                            }
+                            kinetic_slots[agent.cell] = -1;
+                            kinetic_slots[target] = event.agent;
+                            agent.cell = target;
+                            if constexpr (metrics_enabled) {
+                                step_metrics.counters[species].moves++;
+                            }
+                            schedule_attempt(event.agent, event.time);
+                            break;
+                    }
+                }
+            }
+
+        
+        public:
+            /**
+             * ***********************************************************************************************************************************************************************
+             * SUB_SECTION - Terminal Rendering
+             * @subsection TerminalRendering terminal rendering
+             * This section draws the grid in the terminal. The last drawn frame is kept, and every later frame only moves the cursor to the cells
+             * that differ from it. A frame is built in one buffer and handed to the terminal with a single write().
+             * ***********************************************************************************************************************************************************************
+             */
+            /// @var vector<int8_t> screen
+            /// @brief Occupy value of every cell as it is currently shown in the terminal, empty before the first frame
+            std::vector<std::int8_t> screen;
+
+            /// @var string frame_buffer
+            /// @brief escape sequences and characters of the frame being drawn, reused across frames
+            std::string frame_buffer;
+
+            /**
+             * @brief appends the escape sequence that moves the cursor to a 1-based terminal row and column
+             */
+            void move_cursor(int row, int col) {
+                char sequence[32];
+                int length = std::snprintf(sequence, sizeof(sequence), "\x1b[%d;%dH", row, col);
+                frame_buffer.append(sequence, static_cast<std::size_t>(length));
+            }
+
+            /**
+             * @brief writes the frame buffer to standard output with as few write() calls as the terminal accepts, normally one
+             */
+            void flush_frame() {
+                std::cout.flush(); // anything printed through iostream must come before the frame
+                const char* data = frame_buffer.data();
+                std::size_t remaining = frame_buffer.size();
+                while (remaining > 0) {
+                    ssize_t written = ::write(STDOUT_FILENO, data, remaining);
+                    if (written < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        return; // the terminal went away, nothing sensible left to do
+                    }
+                    data += written;
+                    remaining -= static_cast<std::size_t>(written);
+                }
+            }
+
+            /**
+             * @brief forgets the frame on screen, so the next print_grid() redraws everything, e.g. after other output scrolled the terminal
+             */
+            void invalidate_screen() {
+                screen.clear();
+            }
+
+            /**
+             * @brief draws the ocean grid with ascii characters
+             * @details the first frame clears the terminal and draws the column and row indices and every cell.
+             *          later frames compare the grid with the frame on screen and only redraw the cells that changed, so a frame of a mostly
+             *          unchanged ocean costs a few bytes instead of a full redraw. cell (i, j) sits at terminal row i + 3, column 2 * j + 3.
+             *          the whole frame is written with a single write() call.
+             */
+            void print_grid() {
+                PhaseTimer timer(&render_seconds);
+                frame_buffer.clear();
+                const std::size_t cells_on_screen = static_cast<std::size_t>(num_cells);
+                if (screen.size() != cells_on_screen) {
+                    // first frame: clear the terminal and draw the indices, every cell is redrawn below
+                    screen.assign(cells_on_screen, static_cast<std::int8_t>(CHAR_MIN));
+                    frame_buffer += "\x1b[2J\x1b[H\n ";
+                    for (int j = 0; j < num_cols; ++j) {
+                        // only the first digit of the column index
+                        frame_buffer += ' ';
+                        frame_buffer += static_cast<char>('0' + j % 10);
+                    }
+                    for (int i = 0; i < num_rows; ++i) {
+                        move_cursor(i + 3, 1);
+                        frame_buffer += static_cast<char>('0' + i % 10);
+                    }
+                }
+
+                grid.visit([&](const auto& cells) {
+                    // the cursor stays right behind the last character written, so neighboring changes need no cursor move
+                    int cursor = -1;
+                    for (int cell = 0; cell < num_cells; ++cell) {
+                        const std::int8_t value = static_cast<std::int8_t>(cells.get(cell));
+                        if (value == screen[cell]) {
+                            continue;
+                        }
+                        screen[cell] = value;
+                        const int i = cell / num_cols;
+                        const int j = cell % num_cols;
+                        if (cell != cursor) {
+                            move_cursor(i + 3, 2 * j + 3);
+                        }
+                        frame_buffer += get_ascii(static_cast<Occupy>(value));
+                        frame_buffer += ' ';
+                        cursor = (j + 1 < num_cols) ? cell + 1 : -1;
+                    }
+                });
+
+                // finally the populations, cleared to the end of the line since they can get shorter:
+                move_cursor(num_rows + 4, 1);
+                frame_buffer += "Turtles: " + std::to_string(num_turtle) + "\x1b[K\n";
+                frame_buffer += "Trash: " + std::to_string(num_trash) + "\x1b[K\n";
+                frame_buffer += "Ships: " + std::to_string(num_ship) + "\x1b[K\n";
+                flush_frame();
+            }
+
+        /**
+         * ***********************************************************************************************************************************************************************
+         * SUB_SECTION - Initial Placement
+         * @subsection InitialPlacement initial placement
+         * set_dummy_grid() fills an empty grid with exactly num_turtle turtles, num_trash trash and num_ship ships. Every species is either spread
+         * uniformly or gathered around a few patch centers. The uniform species take the first cells of a CellPermutation, which are distinct
+         * by construction, so placement costs O(agents) instead of O(cells) and blocks of agents are placed on the thread pool.
+         * Every draw comes from a CounterRng keyed on a placement seed, so the grid doesn't depend on the number of threads.
+         * ***********************************************************************************************************************************************************************
+         */
+        public:
+            /**
+             * @brief how the agents of a species are spread over the initial grid
+             */
+            enum class Distribution {
+                Uniform, ///< every cell is equally likely
+                Patches ///< around patch centers, like trash gathered by currents
+            };
+
+            /**
+             * @brief placement settings of set_dummy_grid()
+             */
+            struct Placement {
+                Distribution distributions[3]{Distribution::Uniform, Distribution::Uniform, Distribution::Uniform}; ///< indexed by Occupy
+                int patches{3}; ///< patch centers of every species placed in patches
+                double patch_radius{8.}; ///< standard deviation of the distance of an agent from its patch center, in cells
+            };
+
+            /// @var Placement placement
+            /// @brief how set_dummy_grid() spreads the agents
+            Placement placement;
+
+            /// @brief agents per parallel block of set_dummy_grid()
+            static constexpr long long placement_block = 4096;
+
+            /// @brief attempts to find a free cell near a patch center before an agent is placed anywhere on the grid
+            static constexpr std::uint64_t patch_attempts = 32;
+
+            /**
+             * @brief the number of cells that make up a fraction of the grid, to set a population from a density
+             * @param density fraction of the cells, clamped to [0, 1]
+             */
+            int cells_for_density(double density) const {
+                return static_cast<int>(std::llround(std::clamp(density, 0., 1.) * num_cells));
+            }
+
+            /**
+             * @brief places exactly num_turtle turtles, num_trash trash and num_ship ships on an empty grid, following placement
+             * @details the placement seed is drawn from random_engine(), so seed_random() reproduces the grid. species in patches are placed
+             *          first, then the uniform species fill cells of a CellPermutation. populations that don't fit are cut down to the free cells.
+             */
+            void set_dummy_grid() {
+                const std::uint64_t placement_seed = random_engine()();
+                grid.reset(static_cast<std::size_t>(num_cells), grid.layout());
+                if (grid.layout() == GridLayout::Chunked) {
+                    // the tiles of the old chunks are gone with them:
+                    chunk_tiles.clear();
+                }
+
+                // populations beyond the number of cells can't be placed:
+                int* populations[3] = {&num_turtle, &num_trash, &num_ship};
+                long long room = num_cells;
+                for (int* population : populations) {
+                    *population = static_cast<int>(std::clamp<long long>(*population, 0, room));
+                    room -= *population;
+                }
+
+                const CounterRng placement_rng(placement_seed);
+                bool patched = false;
+                for (int species = 0; species < 3; ++species) {
+                    if (placement.distributions[species] == Distribution::Patches and *populations[species] > 0) {
+                        place_patches(species, *populations[species], placement_rng);
+                        patched = true;
+                    }
+                }
+                place_uniform(placement_seed, patched);
+                this->invalidate_agents();
+            }
+
+        private:
+            /**
+             * @brief runs task(block) for blocks 0..num_blocks-1, on the thread pool if there is one
+             */
+            template <class Task>
+            void for_each_block(long long num_blocks, Task&& task) {
+                auto run_block = [&](int block) { task(static_cast<long long>(block)); };
+                if (pool) {
+                    pool->parallel_for(static_cast<int>(num_blocks), run_block);
+                } else {
+                    for (long long block = 0; block < num_blocks; ++block) {
+                        task(block);
+                    }
+                }
+            }
+
+            /**
+             * @brief places the uniform species: index k of the CellPermutation holds the k-th of these agents, turtles first, then trash, then ships
+             * @param placement_seed seed of the permutation
+             * @param patched cells may be taken by patches already, an agent that lands on one moves on to the next unused index
+             */
+            void place_uniform(std::uint64_t placement_seed, bool patched) {
+                long long ends[3];
+                long long total = 0;
+                const int counts[3] = {num_turtle, num_trash, num_ship};
+                for (int species = 0; species < 3; ++species) {
+                    total += placement.distributions[species] == Distribution::Uniform ? counts[species] : 0;
+                    ends[species] = total;
+                }
+                if (total == 0) {
+                    return;
+                }
+                const CellPermutation permutation(static_cast<std::uint64_t>(num_cells), placement_seed);
+                auto species_of = [&](long long agent) { return agent < ends[0] ? 0 : agent < ends[1] ? 1 : 2; };
+                const long long num_blocks = (total + placement_block - 1) / placement_block;
+
+                if (not patched and grid.layout() != GridLayout::Chunked) {
+                    // distinct cells of an empty grid with a fixed size: every block writes its own agents
+                    for_each_block(num_blocks, [&](long long block) {
+                        grid.visit([&](auto& cells) {
+                            for (long long agent = block * placement_block; agent < std::min(total, (block + 1) * placement_block); ++agent) {
+                                cells.set(permutation(static_cast<std::uint64_t>(agent)), species_of(agent));
+                            }
+                        });
+                    });
+                    return;
+                }
+                // evaluate the permutation in parallel, then write in order, since patches may hold cells and chunks may be allocated:
+                std::vector<std::int64_t> targets(static_cast<std::size_t>(total));
+                for_each_block(num_blocks, [&](long long block) {
+                    for (long long agent = block * placement_block; agent < std::min(total, (block + 1) * placement_block); ++agent) {
+                        targets[agent] = static_cast<std::int64_t>(permutation(static_cast<std::uint64_t>(agent)));
+                    }
+                });
+                grid.visit([&](auto& cells) {
+                    std::uint64_t next = static_cast<std::uint64_t>(total);
+                    for (long long agent = 0; agent < total; ++agent) {
+                        std::uint64_t cell = static_cast<std::uint64_t>(targets[agent]);
+                        while (cells.get(cell) != static_cast<int>(Occupy::Empty)) {
+                            cell = permutation(next++);
+                        }
+                        cells.set(cell, species_of(agent));
+                    }
+                });
+            }
+
+            /**
+             * @brief a cell drawn uniformly from a 32-bit random number, bits * num_cells / 2^32 without overflowing for grids of 2^32 cells and more
+             */
+            std::int64_t scale_to_cells(std::uint32_t bits) const {
+                const std::uint64_t cells = static_cast<std::uint64_t>(num_cells);
+                return static_cast<std::int64_t>(bits * (cells >> 32) + ((bits * (cells & 0xFFFFFFFF)) >> 32));
+            }
+
+            /**
+             * @brief cell of an agent of a patched species, normally distributed around its patch center
+             * @return cell index, -1 if the draw is off the grid
+             */
+            std::int64_t patch_cell(const CounterRng& placement_rng, int species, int agent, std::uint64_t attempt, const std::vector<std::int64_t>& centers) const {
+                const std::array<std::uint32_t, 4> bits = placement_rng(attempt | static_cast<std::uint64_t>(species) << 32, static_cast<std::uint32_t>(agent), 2);
+                const std::int64_t center = centers[agent % centers.size()];
+                // Box-Muller, u1 in (0, 1] so the logarithm is finite:
+                const double u1 = (bits[0] + 1.) / 4294967296.;
+                const double u2 = bits[1] / 4294967296.;
+                const double radius = placement.patch_radius * std::sqrt(-2. * std::log(u1));
+                int i = static_cast<int>(center / num_cols) + static_cast<int>(std::lround(radius * std::cos(2. * std::numbers::pi * u2)));
+                int j = static_cast<int>(center % num_cols) + static_cast<int>(std::lround(radius * std::sin(2. * std::numbers::pi * u2)));
+                if (boundary == Boundary::Periodic) {
+                    i = (i % num_rows + num_rows) % num_rows;
+                    j = (j % num_cols + num_cols) % num_cols;
+                }
+                if (i < 0 or i >= num_rows or j < 0 or j >= num_cols) {
+                    return -1;
+                }
+                return static_cast<std::int64_t>(i) * num_cols + j;
+            }
+
+            /**
+             * @brief places count agents of one species around placement.patches uniformly drawn centers
+             * @details the first draw of every agent is computed in parallel. agents are then written in order, and an agent whose cell is
+             *          off the grid or taken draws again, and after patch_attempts draws it takes any free cell.
+             */
+            void place_patches(int species, int count, const CounterRng& placement_rng) {
+                std::vector<std::int64_t> centers(static_cast<std::size_t>(std::max(placement.patches, 1)));
+                for (std::size_t p = 0; p < centers.size(); ++p) {
+                    const std::array<std::uint32_t, 4> bits = placement_rng(static_cast<std::uint64_t>(species), static_cast<std::uint32_t>(p), 1);
+                    centers[p] = scale_to_cells(bits[0]);
+                }
+                std::vector<std::int64_t> targets(static_cast<std::size_t>(count));
+                for_each_block((count + placement_block - 1) / placement_block, [&](long long block) {
+                    for (long long agent = block * placement_block; agent < std::min<long long>(count, (block + 1) * placement_block); ++agent) {
+                        targets[agent] = patch_cell(placement_rng, species, static_cast<int>(agent), 0, centers);
+                    }
+                });
+                grid.visit([&](auto& cells) {
+                    for (int agent = 0; agent < count; ++agent) {
+                        std::int64_t cell = targets[agent];
+                        for (std::uint64_t attempt = 1; cell < 0 or cells.get(cell) != static_cast<int>(Occupy::Empty); ++attempt) {
+                            if (attempt < patch_attempts) {
+                                cell = patch_cell(placement_rng, species, agent, attempt, centers);
+                            } else {
+                                // the patch is full, any free cell will do:
+                                const std::uint32_t bits = placement_rng(attempt | static_cast<std::uint64_t>(species) << 32, static_cast<std::uint32_t>(agent), 3)[0];
+                                cell = scale_to_cells(bits);
+                            }
+                        }
+                        cells.set(cell, species);
+                    }
+                });
+            }
+
+        public:
+            /**
+             * @brief moves all ships by one step
+             */
+            void move_ship() {
+                move_phase<Occupy::Ship>(ship_idle_chance);
+            }
+
+            /**
+             * @brief moves all turtles by one step
+             */
+            void move_turtle() {
+                move_phase<Occupy::Turtle>(turtle_idle_chance);
+            }
+
+            /**
+             * @brief moves all trash by one step
+             */
+            void move_trash() {
+                move_phase<Occupy::Trash>(trash_idle_chance);
+            }
+
+            /**
+             * @brief updates the grid by one step with the selected engine
+             * @details ships move first, then turtles, then trash. Each phase sees the result of the phases before it.
+             *          see Tiled Grid Update for how moves within a phase are resolved independently of scan order.
+             *          the kinetic engine instead handles the asynchronous move attempts up to the next step, see Kinetic Monte Carlo Engine.
+             *          populations are updated from the agents removed in each phase instead of recounting the grid.
+             *          with track_changes on, the cells written in this step are collected in changed_cells.
+             */
+            void update_grid() {
+                if (engine == Engine::Tiled and not tile_scratch_ready) {
+                    reserve_tile_scratch();
+                }
+                changed_cells.clear();
+                // the frame drawn before this step counts towards it:
+                step_metrics = Metrics{};
+                step_metrics.steps = 1;
+                step_metrics.phase_seconds[static_cast<int>(Phase::Render)] = std::exchange(render_seconds, 0.);
+
+                if (engine == Engine::Kinetic) {
+                    // asynchronous moves, no species phases:
+                    PhaseTimer timer(&step_metrics.phase_seconds[static_cast<int>(Phase::Events)]);
+                    grid.visit([&](auto& cells) { kinetic_events(cells); });
+                } else {
+                    // move ships first:
+                    {
+                        PhaseTimer timer(&step_metrics.phase_seconds[static_cast<int>(Phase::Ship)]);
+                        move_ship();
+                    }
+                    {
+                        PhaseTimer timer(&step_metrics.phase_seconds[static_cast<int>(Phase::Turtle)]);
+                        move_turtle();
+                    }
+                    {
+                        PhaseTimer timer(&step_metrics.phase_seconds[static_cast<int>(Phase::Trash)]);
+                        move_trash();
+                    }
+                }
+
+                // merge the per-tile counters into the populations:
+                PhaseTimer timer(&step_metrics.phase_seconds[static_cast<int>(Phase::Population)]);
+                merge_tiles(tiles);
+                merge_tiles(chunk_tiles);
+                if (track_changes) {
+                    // a cell can be written in several phases, list it once:
+                    std::sort(changed_cells.begin(), changed_cells.end());
+                    changed_cells.erase(std::unique(changed_cells.begin(), changed_cells.end()), changed_cells.end());
+                }
+                release_chunks();
+                this->step++;
+            };
+
+            /**
+             * @brief merges the removed agents, changed cells and counters of the tiles into the ocean and clears them for the next step
+             * @param tile_list tiles or chunk_tiles
+             */
+            template <class Tiles>
+            void merge_tiles(Tiles& tile_list) {
+                for (auto& tile : tile_list) {
+                    this->num_turtle -= tile.removed[static_cast<int>(Occupy::Turtle)];
+                    this->num_trash -= tile.removed[static_cast<int>(Occupy::Trash)];
+                    this->num_ship -= tile.removed[static_cast<int>(Occupy::Ship)];
+                    std::fill(std::begin(tile.removed), std::end(tile.removed), 0);
+                    if (track_changes) {
+                        changed_cells.insert(changed_cells.end(), tile.changed.begin(), tile.changed.end());
+                        tile.changed.clear();
+                    }
+                    if constexpr (metrics_enabled) {
+                        for (int species = 0; species < 3; ++species) {
+                            step_metrics.counters[species] += tile.counters[species];
+                            tile.counters[species] = SpeciesCounters{};
+                        }
+                    }
+                }
+            }
+
+            /**
+             * @brief runs the simulation and shows it in the terminal
+             * @param total_time number of steps to simulate
+             * @param step_interval wall-clock time of one step, 0 to step as fast as possible
+             * @param frame_interval shortest time between two frames, so drawing can't hold back a fast simulation
+             * @param after_step optional callback after every step, e.g. to export metrics
+             * @details steps and frames are paced separately: a frame shows the latest step whenever frame_interval has passed,
+             *          and the steps between two frames are never drawn. the last step is always drawn.
+             */
+            void update(int total_time, std::chrono::milliseconds step_interval = std::chrono::milliseconds(500),
+                        std::chrono::milliseconds frame_interval = std::chrono::milliseconds(33), const std::function<void(Ocean&)>& after_step = nullptr) {
+                using clock = std::chrono::steady_clock;
+                const std::uint64_t last_step = this->step + static_cast<std::uint64_t>(std::max(0, total_time));
+                auto next_step = clock::now();
+                print_grid();
+                auto next_frame = next_step + frame_interval;
+                for (const Frame& frame : frames(total_time)) {
+                    if (after_step) {
+                        after_step(*this);
+                    }
+                    next_step += step_interval;
+                    std::this_thread::sleep_until(next_step);
+                    auto now = clock::now();
+                    if (frame.step < last_step and now >= next_frame) {
+                        print_grid();
+                        next_frame = now + frame_interval;
+                    }
+                }
+                if (total_time > 0) {
+                    print_grid();
+                }
+            };
+
+            /**
+             * @brief a view of the ocean after a step, handed out by frames()
+             * @details nothing is copied: changed and grid point into the ocean, and are valid until the next frame is asked for.
+             */
+            struct Frame {
+                std::uint64_t step{0}; ///< Ocean::step of the frame
+                std::array<int, 3> population{}; ///< turtles, trash and ships, indexed by Occupy
+                std::span<const int> changed; ///< sorted, unique cells written since the previous frame, or since frames() started
+                const GridStorage* grid{nullptr}; ///< the ocean's own grid
+            };
+
+            /**
+             * @brief the steps of the simulation as a lazy sequence of frames
+             * @param total_time number of steps to simulate, negative for no end
+             * @param every steps between two frames, at least 1. the changed cells of the skipped steps are merged into the next frame
+             * @return a Generator that runs every steps whenever its consumer asks for the next frame, and never runs ahead of it
+             * @details switches change tracking on. the ocean must outlive the generator and must not be stepped by anything else
+             *          while it is suspended. the grid before the first frame is the ocean as it was when the first frame was asked for.
+             *          breaking out of the loop over the frames stops the simulation where it is.
+             */
+            Generator<Frame> frames(int total_time = -1, int every = 1) {
+                set_track_changes(true);
+                every = std::max(1, every);
+                // cells of the steps since the last frame, only needed when steps are skipped:
+                std::vector<int> merged;
+                std::vector<int> scratch;
+                for (int t = 0; total_time < 0 or t < total_time; ) {
+                    merged.clear();
+                    const int steps = total_time < 0 ? every : std::min(every, total_time - t);
+                    for (int k = 0; k < steps; ++k, ++t) {
+                        update_grid();
+                        if (steps > 1) {
+                            scratch.clear();
+                            std::set_union(merged.begin(), merged.end(), changed_cells.begin(), changed_cells.end(), std::back_inserter(scratch));
+                            std::swap(merged, scratch);
+                        }
+                    }
+                    Frame frame;
+                    frame.step = this->step;
+                    frame.population = {num_turtle, num_trash, num_ship};
+                    frame.changed = steps > 1 ? std::span<const int>(merged) : std::span<const int>(changed_cells);
+                    frame.grid = &grid;
+                    co_yield frame;
+                }
+            }
+
+            /**
+             * @brief throughput numbers of a headless run
+             */
+            struct RunStats {
+                int steps{0}; ///< number of steps that were simulated
+                double seconds{0.}; ///< wall-clock time spent in the step loop
+                double steps_per_sec{0.}; ///< steps / seconds
+                double cell_updates_per_sec{0.}; ///< steps * num_cells / seconds
+                std::size_t first_step_allocations{0}; ///< heap allocations of the first step, which sizes the scratch buffers
+                std::size_t allocations{0}; ///< heap allocations of all later steps, 0 in the steady state
+            };
+
+            /**
+             * @brief runs the simulation without rendering or sleeping, for batch runs and measurements
+             * @param total_time number of steps to simulate
+             * @param after_step optional callback after every step, e.g. to write checkpoints. its time counts towards the run
+             * @return RunStats with elapsed wall-clock time, throughput and heap allocations of the step loop
+             */
+            RunStats run_headless(int total_time, const std::function<void(Ocean&)>& after_step = nullptr) {
+                RunStats stats;
+                std::size_t allocations_before = allocation_count();
+                auto start = std::chrono::steady_clock::now();
+                for (int t = 0; t < total_time ; t++) {
+                    update_grid();
+                    if (after_step) {
+                        after_step(*this);
+                    }
+                    if (t == 0) {
+                        stats.first_step_allocations = allocation_count() - allocations_before;
+                        allocations_before = allocation_count();
+                    }
+                }
+                auto stop = std::chrono::steady_clock::now();
+
+                stats.steps = total_time;
+                stats.seconds = std::chrono::duration<double>(stop - start).count();
+                stats.allocations = allocation_count() - allocations_before;
+                // guard against a zero duration on tiny runs:
+                if (stats.seconds > 0.) {
+                    stats.steps_per_sec = total_time / stats.seconds;
+                    stats.cell_updates_per_sec = static_cast<double>(total_time) * num_cells / stats.seconds;
+                }
+                return stats;
+            };
+
+            /**
+             * @brief counts the populations in a grid
+             * @param _grid grid to count, in any layout
+             * @return tuple of {turtles, trash, ships}
+             * @details counts with popcount on a Bitboard layout and with one pass per species otherwise
+             */
+            std::tuple<int, int, int> population(const GridStorage& _grid) const {
+                int turtle = static_cast<int>(_grid.count(static_cast<int>(Occupy::Turtle)));
+                int trash = static_cast<int>(_grid.count(static_cast<int>(Occupy::Trash)));
+                int ship = static_cast<int>(_grid.count(static_cast<int>(Occupy::Ship)));
+                return {turtle, trash, ship};
+            }
+
+        /**
+         * ***********************************************************************************************************************************************************************
+         * SUB_SECTION - Checkpoints
+         * @subsection Checkpoints binary checkpoint/restart
+         * A checkpoint file is an 80-byte header followed by the grid in its packed in-memory layout (int grids are packed to bytes).
+         * The header holds the dimensions, populations, step number, seed and idle chances. CounterRng has no other state, so that is the whole RNG state,
+         * and a restored ocean continues exactly like the uninterrupted run with the tiled, sparse or kinetic engine, in any layout and thread count.
+         * Files are read through mmap and the grid is copied out of the mapping in bulk. Before that, one pass over the payload checks that
+         * every cell holds a valid value and that the populations in the header match the grid, so a corrupt file fails to load instead of
+         * failing in the step loop. Files are synced to disk before they replace the previous checkpoint.
+         * ***********************************************************************************************************************************************************************
+         */
+        public:
+            /**
+             * @brief fixed-size header at the start of every checkpoint file
+             */
+            struct CheckpointHeader {
+                char magic[8]; ///< "OCEANCK" followed by a null byte
+                std::uint32_t version; ///< format version, checkpoint_version
+                std::uint32_t byte_order; ///< 0x01020304 as written by the saving machine, to detect foreign byte order
+                std::int32_t num_rows; ///< grid rows
+                std::int32_t num_cols; ///< grid columns
+                std::int32_t num_turtle; ///< turtle population
+                std::int32_t num_trash; ///< trash population
+                std::int32_t num_ship; ///< ship population
+                std::uint32_t layout; ///< GridLayout of the payload, Byte or Bitboard
+                std::uint64_t step; ///< steps simulated so far
+                std::uint64_t seed; ///< seed of the CounterRng
+                std::uint32_t original_layout; ///< GridLayout of the ocean that was saved, restored on load
+                std::uint32_t boundary; ///< Boundary policy, zero (Reflecting) in files written before boundaries were selectable
+                float turtle_idle_chance; ///< chance that a turtle stays idle
+                float trash_idle_chance; ///< chance that trash stays idle
+                float ship_idle_chance; ///< chance that a ship stays idle
+                std::uint32_t reserved; ///< zero, keeps the header a multiple of 8 bytes
+            };
+            static_assert(sizeof(CheckpointHeader) == 80, "checkpoint header must stay 80 bytes");
+
+            /// @brief current checkpoint format version, 2 added the idle chances
+            static constexpr std::uint32_t checkpoint_version = 2;
+
+            /**
+             * @brief size of the payload of a grid in a packed layout
+             * @param cells number of cells
+             * @param layout Byte or Bitboard
+             * @return payload size in bytes
+             */
+            static std::size_t checkpoint_payload_size(std::size_t cells, GridLayout layout) {
+                if (layout == GridLayout::Bitboard) {
+                    return 3 * ((cells + 63) / 64) * sizeof(std::uint64_t);
+                }
+                return cells;
+            }
+
+            /**
+             * @brief writes the ocean state to a checkpoint file
+             * @param path file to write. the file is written under a temporary name and renamed, so a crash never leaves a torn checkpoint
+             * @throws std::runtime_error if the file can't be written
+             */
+            void save_checkpoint(const std::string& path) const {
+                CheckpointHeader header{};
+                std::memcpy(header.magic, "OCEANCK", 8);
+                header.version = checkpoint_version;
+                header.byte_order = 0x01020304;
+                header.num_rows = num_rows;
+                header.num_cols = num_cols;
+                header.num_turtle = num_turtle;
+                header.num_trash = num_trash;
+                header.num_ship = num_ship;
+                header.step = step;
+                header.seed = rng.seed;
+                header.original_layout = static_cast<std::uint32_t>(grid.layout());
+                header.boundary = static_cast<std::uint32_t>(boundary);
+                header.turtle_idle_chance = turtle_idle_chance;
+                header.trash_idle_chance = trash_idle_chance;
+                header.ship_idle_chance = ship_idle_chance;
+                header.layout = static_cast<std::uint32_t>(grid.layout() == GridLayout::Bitboard ? GridLayout::Bitboard : GridLayout::Byte);
+
+                const std::string temp_path = path + ".tmp";
+                {
+                    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+                    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                    grid.visit([&](const auto& cells) {
+                        using Cells = std::decay_t<decltype(cells)>;
+                        if constexpr (std::is_same_v<Cells, BitboardGrid>) {
+                            for (const std::vector<std::uint64_t>& plane : cells.planes) {
+                                file.write(reinterpret_cast<const char*>(plane.data()), static_cast<std::streamsize>(plane.size() * sizeof(std::uint64_t)));
+                            }
+                        } else if constexpr (std::is_same_v<Cells, ByteGrid>) {
+                            file.write(reinterpret_cast<const char*>(cells.cells.data()), static_cast<std::streamsize>(cells.cells.size()));
+                        } else if constexpr (std::is_same_v<Cells, ChunkedGrid>) {
+                            // expand to bytes one row at a time, absent chunks are empty cells
+                            std::vector<std::int8_t> row(static_cast<std::size_t>(num_cols));
+                            for (int i = 0; i < num_rows; ++i) {
+                                for (int j = 0; j < num_cols; ++j) {
+                                    row[j] = static_cast<std::int8_t>(cells.get(static_cast<std::size_t>(i) * num_cols + j));
+                                }
+                                file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+                            }
+                        } else {
+                            // pack ints to bytes, cell values fit into an int8_t
+                            std::vector<std::int8_t> packed(cells.cells.begin(), cells.cells.end());
+                            file.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size()));
+                        }
+                    });
+                    file.close();
+                    if (not file) {
+                        throw std::runtime_error("save_checkpoint: can't write " + temp_path);
+                    }
+                }
+                // the data has to be on disk before the rename makes it the checkpoint, or a crash can leave an empty file:
+                sync_path(temp_path, "save_checkpoint: can't sync " + temp_path);
+                if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+                    throw std::runtime_error("save_checkpoint: can't rename " + temp_path + " to " + path);
+                }
+                // and the rename itself lives in the directory:
+                const std::size_t slash = path.find_last_of('/');
+                const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+                sync_path(directory, "save_checkpoint: can't sync " + directory);
+            }
+
+            /**
+             * @brief flushes a file or directory to disk
+             * @throws std::runtime_error with message if it can't be opened or synced
+             */
+            static void sync_path(const std::string& path, const std::string& message) {
+                const int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    throw std::runtime_error(message + ": " + std::strerror(errno));
+                }
+                const int result = ::fsync(fd);
+                const int error = errno;
+                ::close(fd);
+                if (result != 0) {
+                    throw std::runtime_error(message + ": " + std::strerror(error));
+                }
+            }
+
+            /**
+             * @brief counts the populations of a checkpoint payload, checking every cell on the way
+             * @param payload the packed grid after the header
+             * @param cells number of cells
+             * @param layout Byte or Bitboard
+             * @return turtles, trash and ships, or nullopt if a cell holds an invalid value or, in a Bitboard payload, more than one species
+             *         or a bit beyond the last cell is set
+             */
+            static optional<std::array<std::size_t, 3>> checkpoint_populations(const char* payload, std::size_t cells, GridLayout layout) {
+                std::array<std::size_t, 3> population{0, 0, 0};
+                if (layout == GridLayout::Byte) {
+                    std::array<std::size_t, 256> histogram{};
+                    for (std::size_t cell = 0; cell < cells; ++cell) {
+                        histogram[static_cast<std::uint8_t>(payload[cell])]++;
+                    }
+                    // -1 (empty) is 255 as a byte, 0..2 are the species, anything else is corrupt:
+                    if (histogram[255] + histogram[0] + histogram[1] + histogram[2] != cells) {
+                        return nullopt;
+                    }
+                    return std::array<std::size_t, 3>{histogram[0], histogram[1], histogram[2]};
+                }
+                const std::size_t words = (cells + 63) / 64;
+                const std::uint64_t last_mask = cells % 64 == 0 ? ~std::uint64_t{0} : (std::uint64_t{1} << (cells % 64)) - 1;
+                std::array<std::uint64_t, 3> word{};
+                for (std::size_t w = 0; w < words; ++w) {
+                    for (int plane = 0; plane < 3; ++plane) {
+                        std::memcpy(&word[plane], payload + (plane * words + w) * sizeof(std::uint64_t), sizeof(std::uint64_t));
+                        population[plane] += static_cast<std::size_t>(std::popcount(word[plane]));
+                    }
+                    const std::uint64_t any = word[0] | word[1] | word[2];
+                    if ((word[0] & word[1]) | (word[0] & word[2]) | (word[1] & word[2]) or (w + 1 == words and (any & ~last_mask))) {
+                        return nullopt;
+                    }
+                }
+                return population;
+            }
+
+            /**
+             * @brief restores an ocean from a checkpoint file
+             * @param path file written by save_checkpoint()
+             * @return the restored ocean, in the grid layout and boundary it was saved with. tiles, engine and thread pool are defaults and can be set again
+             * @throws std::runtime_error if the file can't be read or isn't a valid checkpoint
+             */
+            static Ocean load_checkpoint(const std::string& path) {
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    throw std::runtime_error("load_checkpoint: can't open " + path);
+                }
+                struct stat file_stat{};
+                if (::fstat(fd, &file_stat) != 0 or static_cast<std::size_t>(file_stat.st_size) < sizeof(CheckpointHeader)) {
+                    ::close(fd);
+                    throw std::runtime_error("load_checkpoint: " + path + " is too short for a checkpoint");
+                }
+                const std::size_t file_size = static_cast<std::size_t>(file_stat.st_size);
+                void* mapping = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                // the mapping stays valid after the descriptor is closed:
+                ::close(fd);
+                if (mapping == MAP_FAILED) {
+                    throw std::runtime_error("load_checkpoint: can't map " + path);
+                }
+                // unmap on every way out of this function:
+                std::unique_ptr<void, std::function<void(void*)>> unmap(mapping, [file_size](void* memory) { ::munmap(memory, file_size); });
+                const char* bytes = static_cast<const char*>(mapping);
+
+                CheckpointHeader header;
+                std::memcpy(&header, bytes, sizeof(header));
+                if (std::memcmp(header.magic, "OCEANCK", 8) != 0) {
+                    throw std::runtime_error("load_checkpoint: " + path + " is not an ocean checkpoint");
+                }
+                if (header.version != checkpoint_version) {
+                    throw std::runtime_error("load_checkpoint: " + path + " has unsupported version " + std::to_string(header.version));
+                }
+                if (header.byte_order != 0x01020304) {
+                    throw std::runtime_error("load_checkpoint: " + path + " was written with a different byte order");
+                }
+                const GridLayout layout = static_cast<GridLayout>(header.layout);
+                const auto is_chance = [](float chance) { return chance >= 0.f and chance <= 1.f; };
+                if (header.num_rows <= 0 or header.num_cols <= 0 or (layout != GridLayout::Byte and layout != GridLayout::Bitboard)
+                    or not is_chance(header.turtle_idle_chance) or not is_chance(header.trash_idle_chance) or not is_chance(header.ship_idle_chance)) {
+                    throw std::runtime_error("load_checkpoint: " + path + " has a corrupt header");
+                }
+                const std::size_t cells = static_cast<std::size_t>(header.num_rows) * static_cast<std::size_t>(header.num_cols);
+                const std::size_t payload_size = checkpoint_payload_size(cells, layout);
+                if (file_size != sizeof(CheckpointHeader) + payload_size) {
+                    throw std::runtime_error("load_checkpoint: " + path + " has the wrong size for its grid");
+                }
+                // the step loop indexes tables with the cell values and trusts the populations, check both before anything uses them:
+                const optional<std::array<std::size_t, 3>> population = checkpoint_populations(bytes + sizeof(CheckpointHeader), cells, layout);
+                if (not population) {
+                    throw std::runtime_error("load_checkpoint: " + path + " has invalid cells");
+                }
+                if (header.num_turtle < 0 or header.num_trash < 0 or header.num_ship < 0
+                    or *population != std::array<std::size_t, 3>{static_cast<std::size_t>(header.num_turtle), static_cast<std::size_t>(header.num_trash),
+                                                                  static_cast<std::size_t>(header.num_ship)}) {
+                    throw std::runtime_error("load_checkpoint: " + path + " has populations that don't match its grid");
+                }
+
+                Ocean ocean(header.num_rows, header.num_cols, header.num_turtle, header.num_trash, header.num_ship);
+                ocean.grid.reset(cells, layout);
+                const char* payload = bytes + sizeof(CheckpointHeader);
+                ocean.grid.visit([&](auto& _cells) {
+                    using Cells = std::decay_t<decltype(_cells)>;
+                    if constexpr (std::is_same_v<Cells, BitboardGrid>) {
+                        for (std::vector<std::uint64_t>& plane : _cells.planes) {
+                            std::memcpy(plane.data(), payload, plane.size() * sizeof(std::uint64_t));
+                            payload += plane.size() * sizeof(std::uint64_t);
+                        }
+                    } else if constexpr (std::is_same_v<Cells, ByteGrid>) {
+                        std::memcpy(_cells.cells.data(), payload, _cells.cells.size());
+                    }
+                });
+                ocean.set_grid_layout(static_cast<GridLayout>(std::min<std::uint32_t>(header.original_layout, 3)));
+                ocean.set_boundary(static_cast<Boundary>(std::min<std::uint32_t>(header.boundary, 2)));
+                ocean.step = header.step;
+                ocean.turtle_idle_chance = header.turtle_idle_chance;
+                ocean.trash_idle_chance = header.trash_idle_chance;
+                ocean.ship_idle_chance = header.ship_idle_chance;
+                ocean.seed(header.seed);
+                ocean.invalidate_agents();
+                return ocean;
+            }
+    
+};
+
+/**
+ * @brief operator overloading of std::cout so that we can directly print out the cell content
+ */
+inline std::ostream& operator<<(std::ostream& os, const Ocean::Occupy& occupy) {
+    // print out corresponding string for Occupy state:
+    switch (occupy) {
+        case Ocean::Occupy::Empty:
+            os << "empty";
+            break;
+        case Ocean::Occupy::Turtle:
+            os << "turtle";
+            break;
+        case Ocean::Occupy::Trash:
+            os << "trash";
+            break;
+        case Ocean::Occupy::Ship:
+            os << "ship";
+            break;
+    }
+    return os;
+}
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Fixed-Size Ocean
+ * @section FixedOcean Fixed-Size Ocean
+ * This section contains an ocean whose dimensions are template parameters, for production runs on a grid size known at compile time.
+ * The cells live in a std::array, and every index, neighbor offset and edge test is a constant expression, so the compiler turns the row and
+ * column arithmetic into shifts or multiplications and unrolls the 8 directions. It runs the tiled engine's rules on one thread, and with the
+ * same seed and initial grid it gives bit-identical results to Ocean. Ocean stays the class for sizes only known at run time.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @class FixedOcean
+ * @brief an Ocean of Rows x Cols cells with std::array storage and compile-time indexing
+ * @tparam Rows number of rows
+ * @tparam Cols number of columns
+ * @tparam Bound boundary policy, see Ocean::Boundary
+ * @details the object holds the grid and the scratch of a step inline, about 7 bytes per cell, so large sizes belong on the heap
+ *          (std::make_unique). it counts populations but doesn't collect step metrics or track changed cells.
+ */
+template <int Rows, int Cols, Ocean::Boundary Bound = Ocean::Boundary::Reflecting>
+class FixedOcean {
+    public:
+        static_assert(Rows > 0 and Cols > 0 and static_cast<long long>(Rows) * Cols <= INT_MAX, "FixedOcean needs 0 < Rows * Cols < 2^31");
+
+        using Occupy = Ocean::Occupy;
+        using CollisionResult = Ocean::CollisionResult;
+
+        static constexpr int num_rows = Rows; ///< number of rows
+        static constexpr int num_cols = Cols; ///< number of columns
+        static constexpr int num_cells = Rows * Cols; ///< number of cells
+
+        int num_turtle{0}; ///< turtle population
+        int num_trash{0}; ///< trash population
+        int num_ship{0}; ///< ship population
+        float turtle_idle_chance{1.f / 9.f}; ///< probability that a turtle stays idle in a step
+        float trash_idle_chance{0.5f}; ///< probability that a trash stays idle in a step
+        float ship_idle_chance{0.2f}; ///< probability that a ship stays idle in a step
+        CounterRng rng{0}; ///< random numbers of the step loop, keyed like Ocean::rng
+        std::uint64_t step{0}; ///< number of steps simulated so far
+
+        /**
+         * @brief copies the grid, populations, idle chances, seed and step of a runtime ocean
+         * @param ocean ocean of the same size and boundary, in any layout
+         * @throws std::invalid_argument if the size or boundary doesn't match
+         */
+        explicit FixedOcean(const Ocean& ocean)
+            : num_turtle(ocean.num_turtle), num_trash(ocean.num_trash), num_ship(ocean.num_ship), turtle_idle_chance(ocean.turtle_idle_chance),
+              trash_idle_chance(ocean.trash_idle_chance), ship_idle_chance(ocean.ship_idle_chance), rng(ocean.rng), step(ocean.step) {
+            if (ocean.num_rows != Rows or ocean.num_cols != Cols or ocean.boundary != Bound) {
+                throw std::invalid_argument("FixedOcean: the ocean's size or boundary doesn't match the template parameters");
+            }
+            for (int cell = 0; cell < num_cells; ++cell) {
+                cells[cell] = static_cast<std::int8_t>(ocean.grid.get(cell));
+            }
+            proposals.fill(0);
+        }
+
+        /**
+         * @brief the object in cell (i, j), unchecked. the index is only checked in debug builds
+         */
+        Occupy get_cell(int i, int j) const {
+            assert(i >= 0 and i < Rows and j >= 0 and j < Cols);
+            return static_cast<Occupy>(cells[i * Cols + j]);
+        }
+
+        /**
+         * @brief writes cell (i, j), unchecked. the populations are left as they are
+         */
+        void set_cell(int i, int j, Occupy value) {
+            assert(i >= 0 and i < Rows and j >= 0 and j < Cols);
+            cells[i * Cols + j] = static_cast<std::int8_t>(value);
+        }
+
+        /**
+         * @brief updates the grid by one step: ships, then turtles, then trash, like Ocean::update_grid() with the tiled engine
+         */
+        void update_grid() {
+            move_phase<Occupy::Ship>(ship_idle_chance);
+            move_phase<Occupy::Turtle>(turtle_idle_chance);
+            move_phase<Occupy::Trash>(trash_idle_chance);
+            step++;
+        }
+
+        /// @brief the cells, row-major, holding Occupy values
+        std::array<std::int8_t, num_cells> cells;
+
+    private:
+        /// @brief cell index offset of every direction, see Ocean::direction_offsets
+        static constexpr std::array<int, 9> direction_offsets = [] {
+            std::array<int, 9> offsets{};
+            for (int dir = 0; dir < 9; ++dir) {
+                offsets[dir] = Ocean::direction_rows[dir] * Cols + Ocean::direction_cols[dir];
+            }
+            return offsets;
+        }();
+
+        /**
+         * @brief the grid as Ocean's rules see it, see Ocean::propose_rule()
+         * @tparam Self FixedOcean, const for the propose and winner rules
+         */
+        template <class Self>
+        struct View {
+            Self& ocean; ///< the ocean viewed
+
+            static int target(int cell, int dir) {
+                return Bound == Ocean::Boundary::Periodic ? neighbor(cell / Cols, cell % Cols, Ocean::direction_rows[dir], Ocean::direction_cols[dir])
+                                                          : cell + direction_offsets[dir];
+            }
+            int winner(int target) const { return ocean.move_winner(target); }
+            int object(int cell) const { return ocean.cells[cell]; }
+            void set(int cell, int value) const { ocean.cells[cell] = static_cast<std::int8_t>(value); }
+            static constexpr bool absorbing() { return Bound == Ocean::Boundary::Absorbing; }
+            std::int8_t proposal(int cell) const { return ocean.proposals[cell]; }
+            static int key(int cell) { return cell; }
+        };
+
+        /**
+         * @brief the cell a move from (i, j) with row and column offsets lands on, -1 if it leaves the grid
+         */
+        static constexpr int neighbor(int i, int j, int row_offset, int col_offset) {
+            int new_i = i + row_offset;
+            int new_j = j + col_offset;
+            if constexpr (Bound == Ocean::Boundary::Periodic) {
+                new_i = new_i < 0 ? Rows - 1 : new_i == Rows ? 0 : new_i;
+                new_j = new_j < 0 ? Cols - 1 : new_j == Cols ? 0 : new_j;
+            } else if (static_cast<unsigned>(new_i) >= static_cast<unsigned>(Rows) or static_cast<unsigned>(new_j) >= static_cast<unsigned>(Cols)) {
+                return -1;
+            }
+            return new_i * Cols + new_j;
+        }
+
+        /**
+         * @brief proposal of one agent, Ocean::propose_rule() on the fixed grid
+         */
+        template <Occupy Species>
+        std::int8_t propose_move(int cell, int dir) const {
+            return Ocean::propose_rule<Species>(View<const FixedOcean>{*this}, dir, [cell](int d) {
+                return neighbor(cell / Cols, cell % Cols, Ocean::direction_rows[d], Ocean::direction_cols[d]);
+            });
+        }
+
+        /**
+         * @brief the lowest source cell proposing a Move into target, -1 if there is none, Ocean::winner_rule() on the fixed grid
+         */
+        int move_winner(int target) const {
+            const View<const FixedOcean> view{*this};
+            const int target_i = target / Cols;
+            const int target_j = target % Cols;
+            if (target_i > 0 and target_i < Rows - 1 and target_j > 0 and target_j < Cols - 1) {
+                return Ocean::winner_rule(view, [target](int dir) { return target - direction_offsets[dir]; });
+            }
+            return Ocean::winner_rule(view, [target_i, target_j](int dir) {
+                return neighbor(target_i, target_j, -Ocean::direction_rows[dir], -Ocean::direction_cols[dir]);
+            });
+        }
+
+        /**
+         * @brief lists the cells holding species in movers, in increasing order
+         * @return number of cells listed
+         * @details reads 8 cells per word and skips words without the species, which is most of them on a sparse grid. the word count is
+         *          a constant, so there's no tail loop unless num_cells isn't a multiple of 8
+         */
+        int collect_movers(std::int8_t species) {
+            constexpr std::uint64_t ones = 0x0101010101010101ull;
+            constexpr int num_words = num_cells / 8;
+            const std::uint64_t pattern = ones * static_cast<std::uint8_t>(species);
+            int count = 0;
+            for (int word = 0; word < num_words; ++word) {
+                std::uint64_t bytes;
+                std::memcpy(&bytes, cells.data() + word * 8, 8);
+                // a byte of x is zero where the cell holds species, and this is nonzero iff x has a zero byte:
+                const std::uint64_t x = bytes ^ pattern;
+                if (((x - ones) & ~x & (ones << 7)) == 0) {
+                    continue;
+                }
+                for (int cell = word * 8; cell < word * 8 + 8; ++cell) {
+                    if (cells[cell] == species) {
+                        movers[count++] = cell;
+                    }
+                }
+            }
+            if constexpr (num_cells % 8 != 0) {
+                for (int cell = num_words * 8; cell < num_cells; ++cell) {
+                    if (cells[cell] == species) {
+                        movers[count++] = cell;
+                    }
+                }
+            }
+            return count;
+        }
+
+        /**
+         * @brief moves every agent of one species: propose against the grid before the phase, then resolve, see Tiled Grid Update
+         */
+        template <Occupy Species>
+        void move_phase(float idle_chance) {
+            constexpr std::int8_t species = static_cast<std::int8_t>(Species);
+            const int count = collect_movers(species);
+            rng.fill_directions(step, static_cast<std::uint32_t>(Species), movers.data(), static_cast<std::size_t>(count), idle_chance, directions.data());
+            for (int k = 0; k < count; ++k) {
+                proposals[movers[k]] = propose_move<Species>(movers[k], directions[k]);
+            }
+
+            const View<FixedOcean> view{*this};
+            int removed[3]{0, 0, 0};
+            for (int k = 0; k < count; ++k) {
+                const int cell = movers[k];
+                const std::int8_t code = proposals[cell];
+                if (code == 0) {
+                    continue;
+                }
+                const Ocean::Resolution<int> resolved = Ocean::resolve_rule<Species>(view, cell, code);
+                if (resolved.outcome == CollisionResult::Die) {
+                    removed[static_cast<int>(Species)]++;
+                } else if (resolved.outcome == CollisionResult::Move and resolved.replaced != static_cast<int>(Occupy::Empty)) {
+                    removed[resolved.replaced]++;
+                }
+            }
+            // the proposals are read by neighbors until the last resolve, clear them afterwards:
+            for (int k = 0; k < count; ++k) {
+                proposals[movers[k]] = 0;
+            }
+            num_turtle -= removed[static_cast<int>(Occupy::Turtle)];
+            num_trash -= removed[static_cast<int>(Occupy::Trash)];
+            num_ship -= removed[static_cast<int>(Occupy::Ship)];
+        }
+
+        std::array<std::int8_t, num_cells> proposals; ///< pending move of every cell in the current phase
+        std::array<int, num_cells> movers; ///< cells of the moving species in the current phase
+        std::array<std::int8_t, num_cells> directions; ///< direction drawn for each of the movers
+};
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Mean-Field Engine
+ * @section MeanField Mean-Field Engine
+ * This section contains a coarse-grained engine for oceans too large to simulate agent by agent. The ocean is cut into blocks of block x block
+ * cells, and every block of a coarse lattice holds the expected number of turtles, trash and ships in it instead of the agents themselves.
+ * A step has the same three phases as the agent engines, and a phase has two parts:
+ * - collisions: the movers of a block aim at cells in it and in its 8 neighbor blocks, with the chances a uniformly placed agent's move
+ *   lands there. they find what the target block holds in proportion to its densities, and collision_logics decides: Move destroys the
+ *   occupant, Die removes the mover and Block keeps it in place. of several movers aiming at the same cell only one gets in, in the mean.
+ * - transport: the movers that got in spread to the neighbor blocks with fractions whose mean and variance per step are those of the
+ *   agents' displacement, scaled to blocks. so the advection (mean) and diffusion (variance) terms both come from the direction chances,
+ *   i.e. from the idle chances, and a block larger than 1 doesn't make the fields spread faster than the agents.
+ * The fields treat every block as well mixed, so they miss the depletion that builds up around ships and trash in the agent model and
+ * overestimate collision rates once it has. A step costs O(blocks) instead of O(cells) and runs on the thread pool in bands of lattice rows.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @class DensityOcean
+ * @brief per-species density fields on a coarse lattice, evolved with the mean-field rules of the agent model
+ * @details the densities are expected agent counts per block, so populations are sums and need no rounding. blocks on the last lattice row
+ *          or column are cut short if the ocean size isn't a multiple of block. with block 1 every block is a single cell.
+ */
+class DensityOcean {
+    public:
+        using Occupy = Ocean::Occupy;
+        using CollisionResult = Ocean::CollisionResult;
+        using Boundary = Ocean::Boundary;
+
+        /// @brief chance of every direction 0..8 of Ocean::Direction for an agent of one species, indexed like Ocean::direction_rows
+        using DirectionChances = std::array<double, 9>;
+
+        int num_rows; ///< rows of the ocean the lattice stands for
+        int num_cols; ///< columns of the ocean the lattice stands for
+        int block; ///< ocean cells per block side
+        int lattice_rows; ///< rows of blocks
+        int lattice_cols; ///< columns of blocks
+        Boundary boundary{Boundary::Reflecting}; ///< what a move off the ocean does, like Ocean::boundary
+        std::uint64_t step{0}; ///< number of steps simulated so far
+        ThreadPool* pool{nullptr}; ///< threads of update_grid(), nullptr runs on the calling thread
+        int band_rows{8}; ///< lattice rows per task of update_grid()
+
+        /// @brief direction chances of every species, indexed by Occupy. set from idle chances by set_idle_chances(), a biased table models a current
+        std::array<DirectionChances, 3> direction_chances;
+
+        /**
+         * @brief an empty lattice for an ocean of rows x cols cells
+         * @throws std::invalid_argument if a size or block isn't positive
+         */
+        DensityOcean(int rows, int cols, int _block) : num_rows(rows), num_cols(cols), block(_block) {
+            if (rows <= 0 or cols <= 0 or _block <= 0) {
+                throw std::invalid_argument("DensityOcean: rows, cols and block must be positive");
+            }
+            lattice_rows = (rows + block - 1) / block;
+            lattice_cols = (cols + block - 1) / block;
+            const std::size_t size = static_cast<std::size_t>(lattice_rows) * lattice_cols;
+            for (int species = 0; species < 3; ++species) {
+                counts[species].assign(size, 0.);
+                next[species].assign(size, 0.);
+            }
+            inflow.assign(size, 0.);
+            admitted.assign(size, 0.);
+            move_fraction.assign(size, 0.);
+            die_fraction.assign(size, 0.);
+            set_idle_chances(1.f / 9.f, 0.5f, 0.2f);
+        }
+
+        /**
+         * @brief coarse-grains the grid of an agent ocean, taking over its idle chances, boundary and step
+         * @param ocean ocean in any layout
+         * @param _block ocean cells per block side
+         */
+        DensityOcean(const Ocean& ocean, int _block) : DensityOcean(ocean.num_rows, ocean.num_cols, _block) {
+            set_idle_chances(ocean.turtle_idle_chance, ocean.trash_idle_chance, ocean.ship_idle_chance);
+            boundary = ocean.boundary;
+            step = ocean.step;
+            counts = coarse_grain(ocean);
+        }
+
+        /**
+         * @brief sets the direction chances of the agent model: idle with the idle chance, otherwise one of the 8 directions with equal chance
+         */
+        void set_idle_chances(float turtle_idle, float trash_idle, float ship_idle) {
+            const float idle[3] = {turtle_idle, trash_idle, ship_idle};
+            for (int species = 0; species < 3; ++species) {
+                direction_chances[species].fill((1. - idle[species]) / 8.);
+                direction_chances[species][0] = idle[species];
+            }
+        }
+
+        /**
+         * @brief spreads a species evenly over the ocean, density agents per cell
+         */
+        void fill(Occupy species, double density) {
+            for (int bi = 0; bi < lattice_rows; ++bi) {
+                for (int bj = 0; bj < lattice_cols; ++bj) {
+                    counts[static_cast<int>(species)][index(bi, bj)] = density * block_rows(bi) * block_cols(bj);
+                }
+            }
+        }
+
+        /**
+         * @brief counts the agents of an ocean per block of this lattice
+         * @param ocean ocean of the same size
+         * @return agents per block, indexed by Occupy and then by block, row-major
+         */
+        std::array<std::vector<double>, 3> coarse_grain(const Ocean& ocean) const {
+            if (ocean.num_rows != num_rows or ocean.num_cols != num_cols) {
+                throw std::invalid_argument("DensityOcean::coarse_grain: the ocean's size doesn't match");
+            }
+            std::array<std::vector<double>, 3> grained;
+            for (std::vector<double>& field : grained) {
+                field.assign(counts[0].size(), 0.);
+            }
+            ocean.grid.visit([&](const auto& cells) {
+                for (int species = 0; species < 3; ++species) {
+                    cells.for_each_of(species, 0, cells.size(), [&](std::size_t cell) {
+                        const int i = static_cast<int>(cell / static_cast<std::size_t>(num_cols));
+                        const int j = static_cast<int>(cell % static_cast<std::size_t>(num_cols));
+                        grained[species][index(i / block, j / block)] += 1.;
+                    });
+                }
+            });
+            return grained;
+        }
+
+        /**
+         * @brief how far the densities are from the coarse-grained grid of an agent ocean
+         * @return sum over species and blocks of the absolute count differences, divided by the agents of the ocean
+         */
+        double distance(const Ocean& ocean) const {
+            const std::array<std::vector<double>, 3> grained = coarse_grain(ocean);
+            double difference = 0.;
+            double agents = 0.;
+            for (int species = 0; species < 3; ++species) {
+                for (std::size_t b = 0; b < grained[species].size(); ++b) {
+                    difference += std::abs(counts[species][b] - grained[species][b]);
+                    agents += grained[species][b];
+                }
+            }
+            return agents > 0. ? difference / agents : difference;
+        }
+
+        /**
+         * @brief expected number of agents of a species in the whole ocean
+         */
+        double population(Occupy species) const {
+            const std::vector<double>& field = counts[static_cast<int>(species)];
+            return std::accumulate(field.begin(), field.end(), 0.);
+        }
+
+        /**
+         * @brief expected number of agents of a species in block (bi, bj)
+         */
+        double count(Occupy species, int bi, int bj) const {
+            return counts[static_cast<int>(species)][index(bi, bj)];
+        }
+
+        /**
+         * @brief expected fraction of the cells of block (bi, bj) that hold a species
+         */
+        double density(Occupy species, int bi, int bj) const {
+            return count(species, bi, bj) / area(bi, bj);
+        }
+
+        /**
+         * @brief advances the fields by one step: ships, then turtles, then trash, like Ocean::update_grid()
+         */
+        void update_grid() {
+            move_phase(Occupy::Ship);
+            move_phase(Occupy::Turtle);
+            move_phase(Occupy::Trash);
+            step++;
+        }
+
+    private:
+        /// @brief expected agents per block, indexed by Occupy, and the fields being written by a phase
+        std::array<std::vector<double>, 3> counts, next;
+
+        /// @brief per block, scratch of a phase: movers aiming at its cells, the fraction of them not turned away by another mover,
+        /// and the fractions of them that get in and that die
+        std::vector<double> inflow, admitted, move_fraction, die_fraction;
+
+        /// @brief fraction of a block's agents that go to each neighbor block in a step, indexed (row offset + 1) * 3 + column offset + 1
+        using Transfer = std::array<double, 9>;
+
+        /// @brief where the agents of a block aim, and where the ones that got in are transported, for full blocks, blocks cut short
+        /// in rows, in columns, and in both
+        std::array<Transfer, 4> aims, transports;
+
+        std::size_t index(int bi, int bj) const {
+            return static_cast<std::size_t>(bi) * lattice_cols + bj;
+        }
+
+        int block_rows(int bi) const {
+            return std::min(block, num_rows - bi * block);
+        }
+
+        int block_cols(int bj) const {
+            return std::min(block, num_cols - bj * block);
+        }
+
+        double area(int bi, int bj) const {
+            return static_cast<double>(block_rows(bi)) * block_cols(bj);
+        }
+
+        /// @brief the entry of aims or transports that applies to block (bi, bj)
+        int shape(int bi, int bj) const {
+            return (block_rows(bi) != block ? 1 : 0) + (block_cols(bj) != block ? 2 : 0);
+        }
+
+        /**
+         * @brief where the agents of a block of height x width cells aim
+         * @details a move with row offset dr from a uniformly placed agent leaves the block's rows with chance 1 / height if dr != 0, and
+         *          the same holds for the columns. both are independent, so a diagonal move aims at the diagonal neighbor block with chance
+         *          1 / (height * width). idle agents aim nowhere, so the entries add up to 1 - idle chance
+         */
+        static Transfer aim_of(const DirectionChances& chances, int height, int width) {
+            Transfer aim{};
+            auto cross = [](int offset, int to, int size) {
+                if (offset == 0) {
+                    return to == 0 ? 1. : 0.;
+                }
+                return to == offset ? 1. / size : to == 0 ? 1. - 1. / size : 0.;
+            };
+            for (int dir = 1; dir <= 8; ++dir) {
+                for (int to_row = -1; to_row <= 1; ++to_row) {
+                    for (int to_col = -1; to_col <= 1; ++to_col) {
+                        aim[(to_row + 1) * 3 + to_col + 1] += chances[dir] * cross(Ocean::direction_rows[dir], to_row, height)
+                                                            * cross(Ocean::direction_cols[dir], to_col, width);
+                    }
+                }
+            }
+            return aim;
+        }
+
+        /**
+         * @brief where the agents of a block of height x width cells that got into their target cell are transported, per agent that aimed
+         * @details a displacement of one cell is 1 / size blocks, so every direction moves its agents with chance 1 / size^2 per axis: that
+         *          matches the variance of the displacement. a drift, from direction chances that aren't symmetric, is added upwind, so the
+         *          mean matches too. on 1 x 1 blocks this is the agent model's own step
+         */
+        static Transfer transport_of(const DirectionChances& chances, int height, int width) {
+            Transfer transport{};
+            const double active = 1. - chances[0];
+            if (active <= 0.) {
+                return transport;
+            }
+            auto spread = [](int offset, int to, int size) {
+                const double moved = 1. / (static_cast<double>(size) * size);
+                if (offset == 0) {
+                    return to == 0 ? 1. : 0.;
+                }
+                return to == offset ? moved : to == 0 ? 1. - moved : 0.;
+            };
+            double drift_rows = 0., drift_cols = 0.;
+            for (int dir = 1; dir <= 8; ++dir) {
+                const double chance = chances[dir] / active;
+                drift_rows += chance * Ocean::direction_rows[dir];
+                drift_cols += chance * Ocean::direction_cols[dir];
+                for (int to_row = -1; to_row <= 1; ++to_row) {
+                    for (int to_col = -1; to_col <= 1; ++to_col) {
+                        transport[(to_row + 1) * 3 + to_col + 1] += chance * spread(Ocean::direction_rows[dir], to_row, height)
+                                                                  * spread(Ocean::direction_cols[dir], to_col, width);
+                    }
+                }
+            }
+            // the spread moves the mean by drift / size^2 blocks, the rest of drift / size goes to the downstream neighbor:
+            const double extra_rows = std::abs(drift_rows) * (1. / height - 1. / (static_cast<double>(height) * height));
+            const double extra_cols = std::abs(drift_cols) * (1. / width - 1. / (static_cast<double>(width) * width));
+            const double kept = std::min(transport[4], extra_rows + extra_cols);
+            if (kept > 0.) {
+                transport[4] -= kept;
+                transport[(drift_rows > 0. ? 2 : 0) * 3 + 1] += kept * extra_rows / (extra_rows + extra_cols);
+                transport[3 + (drift_cols > 0. ? 2 : 0)] += kept * extra_cols / (extra_rows + extra_cols);
+            }
+            for (double& entry : transport) {
+                entry *= active;
+            }
+            return transport;
+        }
+
+        /**
+         * @brief the lattice rows or columns next to one, and their part of shape()
+         */
+        struct Neighbors {
+            int at[3]; ///< row or column at offset -1, 0 and 1, -1 if it's off the ocean
+            int shape[3]; ///< 1 (rows) or 2 (columns) where that row or column of blocks is cut short, 0 otherwise
+        };
+
+        /**
+         * @brief the rows or columns next to position, wrapped on a periodic ocean
+         * @param size lattice_rows or lattice_cols
+         * @param last_shape shape bit of the last row or column if it's cut short, otherwise 0
+         */
+        Neighbors neighbors(int position, int size, int last_shape) const {
+            Neighbors result;
+            for (int offset = -1; offset <= 1; ++offset) {
+                int moved = position + offset;
+                if (boundary == Boundary::Periodic) {
+                    moved = moved < 0 ? size - 1 : moved == size ? 0 : moved;
+                } else if (moved < 0 or moved >= size) {
+                    moved = -1;
+                }
+                result.at[offset + 1] = moved;
+                result.shape[offset + 1] = moved == size - 1 ? last_shape : 0;
+            }
+            return result;
+        }
+
+        /**
+         * @brief runs task(first lattice row, last lattice row) over bands of band_rows rows, on the pool if there is one
+         */
+        template <class Task>
+        void for_each_band(Task&& task) {
+            const int num_bands = (lattice_rows + band_rows - 1) / band_rows;
+            auto run_band = [&](int band) { task(band * band_rows, std::min(lattice_rows, (band + 1) * band_rows)); };
+            if (pool) {
+                pool->parallel_for(num_bands, run_band);
+            } else {
+                for (int band = 0; band < num_bands; ++band) {
+                    run_band(band);
+                }
+            }
+        }
+
+        /**
+         * @brief moves one species: the inflow and outcome fractions of every block first, then the new counts from them
+         * @details both passes only write the block they are at, so bands need no locking. the outcomes are taken against the densities
+         *          before the phase, like the proposals of the agent engines
+         */
+        void move_phase(Occupy species) {
+            const int s = static_cast<int>(species);
+            const DirectionChances& chances = direction_chances[s];
+            const int heights[4] = {block, num_rows - (lattice_rows - 1) * block, block, num_rows - (lattice_rows - 1) * block};
+            const int widths[4] = {block, block, num_cols - (lattice_cols - 1) * block, num_cols - (lattice_cols - 1) * block};
+            for (int k = 0; k < 4; ++k) {
+                aims[k] = aim_of(chances, heights[k], widths[k]);
+                transports[k] = transport_of(chances, heights[k], widths[k]);
+            }
+
+            const int last_row_shape = shape(lattice_rows - 1, 0) & 1, last_col_shape = shape(0, lattice_cols - 1) & 2;
+
+            // pass 1: movers aiming at every block, and what they find there:
+            for_each_band([&](int row_begin, int row_end) {
+                for (int bi = row_begin; bi < row_end; ++bi) {
+                    const Neighbors rows = neighbors(bi, lattice_rows, last_row_shape);
+                    for (int bj = 0; bj < lattice_cols; ++bj) {
+                        const Neighbors cols = neighbors(bj, lattice_cols, last_col_shape);
+                        const std::size_t b = index(bi, bj);
+                        double aiming = 0.;
+                        for (int dr = -1; dr <= 1; ++dr) {
+                            for (int dc = -1; dc <= 1; ++dc) {
+                                // the source block that aims at this one with offset (dr, dc):
+                                const int si = rows.at[1 - dr], sj = cols.at[1 - dc];
+                                if (si >= 0 and sj >= 0) {
+                                    aiming += counts[s][index(si, sj)] * aims[rows.shape[1 - dr] + cols.shape[1 - dc]][(dr + 1) * 3 + dc + 1];
+                                }
+                            }
+                        }
+                        inflow[b] = aiming;
+                        // the movers aiming at one cell are about Poisson with mean per_cell, and only one of them gets in:
+                        const double cell_area = area(bi, bj);
+                        const double per_cell = std::min(aiming / cell_area, 8.);
+                        double missed = (1. - per_cell / 8.) * (1. - per_cell / 8.);
+                        missed *= missed;
+                        missed *= missed;
+                        admitted[b] = per_cell > 1e-12 ? (1. - missed) / per_cell : 1.;
+                        double empty = 1.;
+                        double moves = 0., dies = 0.;
+                        for (int existing = 0; existing < 3; ++existing) {
+                            const double chance = counts[existing][b] / cell_area;
+                            empty -= chance;
+                            const CollisionResult outcome = Ocean::collision_logics[s + 1][existing + 1];
+                            moves += outcome == CollisionResult::Move ? chance : 0.;
+                            dies += outcome == CollisionResult::Die ? chance : 0.;
+                        }
+                        moves += Ocean::collision_logics[s + 1][0] == CollisionResult::Move ? std::max(0., empty) : 0.;
+                        move_fraction[b] = admitted[b] * moves;
+                        die_fraction[b] = dies;
+                    }
+                }
+            });
+
+            // pass 2: movers die, the ones that got in are transported, and what they landed on is destroyed:
+            const double absorbed = boundary == Boundary::Absorbing ? 2. * block / (block + 1.) : 0.;
+            for_each_band([&](int row_begin, int row_end) {
+                for (int bi = row_begin; bi < row_end; ++bi) {
+                    const Neighbors rows = neighbors(bi, lattice_rows, last_row_shape);
+                    for (int bj = 0; bj < lattice_cols; ++bj) {
+                        const Neighbors cols = neighbors(bj, lattice_cols, last_col_shape);
+                        const std::size_t b = index(bi, bj);
+                        const double own = counts[s][b];
+                        const Transfer& aim = aims[rows.shape[1] + cols.shape[1]];
+                        const Transfer& transport = transports[rows.shape[1] + cols.shape[1]];
+                        double lost = own * aim[4] * die_fraction[b];
+                        for (int dr = -1; dr <= 1; ++dr) {
+                            for (int dc = -1; dc <= 1; ++dc) {
+                                const int k = (dr + 1) * 3 + dc + 1;
+                                if (k == 4) {
+                                    continue;
+                                }
+                                const int ti = rows.at[1 + dr], tj = cols.at[1 + dc];
+                                if (ti >= 0 and tj >= 0) {
+                                    // agents that die in the target block, and agents transported out of the block:
+                                    const std::size_t target = index(ti, tj);
+                                    lost += own * (aim[k] * die_fraction[target] + transport[k] * move_fraction[target]);
+                                } else {
+                                    // the ocean outside is empty, and its edge is half a block (plus half a cell) from the block's center:
+                                    lost += own * transport[k] * absorbed;
+                                }
+                                // agents transported in from the block on the other side:
+                                const int si = rows.at[1 - dr], sj = cols.at[1 - dc];
+                                if (si >= 0 and sj >= 0) {
+                                    lost -= counts[s][index(si, sj)] * transports[rows.shape[1 - dr] + cols.shape[1 - dc]][k] * move_fraction[b];
+                                }
+                            }
+                        }
+                        const double taken = inflow[b] * admitted[b];
+                        const double cell_area = area(bi, bj);
+                        for (int existing = 0; existing < 3; ++existing) {
+                            if (existing == s) {
+                                next[s][b] = std::max(0., own - lost);
+                            } else if (Ocean::collision_logics[s + 1][existing + 1] == CollisionResult::Move) {
+                                // every mover that got in destroys what its cell held:
+                                next[existing][b] = std::max(0., counts[existing][b] - taken * counts[existing][b] / cell_area);
+                            } else {
+                                next[existing][b] = counts[existing][b];
+                            }
+                        }
+                    }
+                }
+            });
+            std::swap(counts, next);
+        }
+};
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Metrics Export
+ * @section MetricsExport Metrics Export
+ * This section writes the step metrics of a run to a CSV file, or to a JSON Lines file with one object per row.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @class MetricsWriter
+ * @brief sums Ocean::step_metrics over a fixed number of steps and writes one row per interval
+ */
+class MetricsWriter {
+    public:
+        /**
+         * @brief opens the file, and writes the header row of a CSV file
+         * @param path output file, JSON Lines if it ends in .json or .jsonl, CSV otherwise
+         * @param _interval number of steps summed into one row, at least 1
+         * @throws std::runtime_error if the file can't be opened
+         */
+        MetricsWriter(const std::string& path, int _interval = 1) : file(path, std::ios::trunc), interval(std::max(1, _interval)) {
+            if (not file) {
+                throw std::runtime_error("MetricsWriter: can't open " + path);
+            }
+            json = path.ends_with(".json") or path.ends_with(".jsonl");
+            if (not json) {
+                file << "step,steps,turtles,trash,ships";
+                for (const char* phase : phase_names) {
+                    file << ',' << phase << "_seconds";
+                }
+                for (const char* species : species_names) {
+                    for (const char* counter : counter_names) {
+                        file << ',' << species << '_' << counter;
+                    }
+                }
+                file << '\n';
+            }
+        }
+
+        MetricsWriter(const MetricsWriter&) = delete;
+        MetricsWriter& operator=(const MetricsWriter&) = delete;
+
+        /**
+         * @brief writes the last, partial interval
+         */
+        ~MetricsWriter() {
+            if (pending.steps > 0) {
+                write_row();
+            }
+        }
+
+        /**
+         * @brief adds the metrics of the ocean's last step, and writes a row once the interval is full
+         * @param ocean the ocean after update_grid()
+         */
+        void record(const Ocean& ocean) {
+            pending += ocean.step_metrics;
+            total += ocean.step_metrics;
+            last_step = ocean.step;
+            population = {ocean.num_turtle, ocean.num_trash, ocean.num_ship};
+            if (pending.steps >= static_cast<std::uint64_t>(interval)) {
+                write_row();
+            }
+        }
+
+        /// @brief metrics summed over every recorded step
+        const Metrics& totals() const { return total; }
+
+    private:
+        /// @brief names of the species, indexed by Occupy
+        static constexpr const char* species_names[3] = {"turtle", "trash", "ship"};
+        /// @brief names of the SpeciesCounters members, in declaration order
+        static constexpr const char* counter_names[6] = {"idle", "out_of_bounds", "blocks", "deaths", "moves", "destroyed"};
+
+        /**
+         * @brief SpeciesCounters members in the order of counter_names
+         */
+        static std::array<std::uint64_t, 6> counter_values(const SpeciesCounters& counters) {
+            return {counters.idle, counters.out_of_bounds, counters.blocks, counters.deaths, counters.moves, counters.destroyed};
+        }
+
+        /**
+         * @brief writes the pending interval as one row and starts a new one
+         */
+        void write_row() {
+            if (json) {
+                file << "{\"step\":" << last_step << ",\"steps\":" << pending.steps
+                     << ",\"population\":{\"turtle\":" << population[0] << ",\"trash\":" << population[1] << ",\"ship\":" << population[2] << "},\"seconds\":{";
+                for (int phase = 0; phase < num_phases; ++phase) {
+                    file << (phase ? "," : "") << '"' << phase_names[phase] << "\":" << pending.phase_seconds[phase];
+                }
+                file << "},\"counters\":{";
+                for (int species = 0; species < 3; ++species) {
+                    file << (species ? "," : "") << '"' << species_names[species] << "\":{";
+                    std::array<std::uint64_t, 6> values = counter_values(pending.counters[species]);
+                    for (int counter = 0; counter < 6; ++counter) {
+                        file << (counter ? "," : "") << '"' << counter_names[counter] << "\":" << values[counter];
+                    }
+                    file << '}';
+                }
+                file << "}}\n";
+            } else {
+                file << last_step << ',' << pending.steps << ',' << population[0] << ',' << population[1] << ',' << population[2];
+                for (double seconds : pending.phase_seconds) {
+                    file << ',' << seconds;
+                }
+                for (const SpeciesCounters& counters : pending.counters) {
+                    for (std::uint64_t value : counter_values(counters)) {
+                        file << ',' << value;
+                    }
+                }
+                file << '\n';
+            }
+            pending = Metrics{};
+        }
+
+        std::ofstream file;
+        const int interval;
+        bool json{false}; ///< JSON Lines instead of CSV
+        Metrics pending; ///< metrics of the steps since the last row
+        Metrics total; ///< metrics of every recorded step
+        std::uint64_t last_step{0}; ///< Ocean::step of the last recorded step
+        std::array<int, 3> population{}; ///< populations after the last recorded step
+};
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Spatial Analytics
+ * @section SpatialAnalytics Spatial Analytics
+ * This section follows two spatial statistics of a running ocean: the clusters of trash, and the distance from every turtle to its nearest trash.
+ * Both are built from a full scan once and then only updated from Ocean::changed_cells, so a step costs in proportion to what it changed:
+ *   - trash clusters are the 8-connected components of the trash cells, kept in a union-find forest. new trash joins its neighbors' clusters,
+ *     removed trash relabels only the clusters it belonged to, which may have split.
+ *   - the distance field holds, for every cell, the number of moves to the nearest trash (Chebyshev distance, wrapped by the periodic boundary).
+ *     every cell also remembers the trash it is nearest to. removed trash clears the cells that were nearest to it and refills them from
+ *     the cells around them, new trash lowers the distances around it, both with the same wavefront.
+ * Turtle distances are kept in a histogram by distance, so the per-step summary doesn't visit the turtles either.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @struct AnalyticsSummary
+ * @brief the spatial statistics of one step
+ */
+struct AnalyticsSummary {
+    std::uint64_t step{0}; ///< Ocean::step the summary belongs to
+    int trash{0}; ///< trash cells
+    int clusters{0}; ///< 8-connected clusters of trash
+    int largest_cluster{0}; ///< cells in the largest trash cluster, 0 without trash
+    int turtles{0}; ///< turtle cells
+    int unreached{0}; ///< turtles no trash can reach, there is no trash or the boundary cuts it off
+    int adjacent{0}; ///< turtles one move away from trash
+    int min_distance{-1}; ///< fewest moves from a turtle to trash, -1 if no turtle is reached
+    double mean_distance{0.}; ///< mean moves from a reached turtle to its nearest trash
+
+    /// @brief mean cells per trash cluster
+    double mean_cluster() const { return clusters > 0 ? static_cast<double>(trash) / clusters : 0.; }
+};
+
+/**
+ * @class SpatialAnalytics
+ * @brief trash clusters and the turtle-to-trash distance field of an ocean, updated incrementally after every step
+ * @details keeps a copy of the cells it has seen, so it may be updated with several steps' worth of changed cells as long as no changed cell
+ *          is missed. costs about 25 bytes per cell.
+ */
+class SpatialAnalytics {
+    public:
+        /// @brief distance of a cell no trash can reach
+        static constexpr int unreachable = INT_MAX;
+
+        /**
+         * @brief builds the clusters and the distance field from the ocean's current grid
+         * @param ocean the ocean that will be followed. its change tracking is switched on
+         */
+        explicit SpatialAnalytics(Ocean& ocean) {
+            ocean.set_track_changes(true);
+            rebuild(ocean);
+        }
+
+        /**
+         * @brief builds everything from a full scan of the grid, e.g. after a checkpoint was loaded
+         */
+        void rebuild(const Ocean& ocean) {
+            const std::size_t num_cells = static_cast<std::size_t>(ocean.num_cells);
+            kind.assign(num_cells, static_cast<std::int8_t>(Ocean::Occupy::Empty));
+            parent.assign(num_cells, -1);
+            size.assign(num_cells, 0);
+            mark.assign(num_cells, 0);
+            distance.assign(num_cells, unreachable);
+            nearest.assign(num_cells, -1);
+            clusters_of_size.assign(num_cells + 1, 0);
+            num_clusters = 0;
+            largest = 0;
+            num_trash = 0;
+            stamp = 0;
+            // every distance is below the longer side of the grid, the last bucket counts the unreached turtles:
+            const std::size_t max_distance = static_cast<std::size_t>(std::max(ocean.num_rows, ocean.num_cols));
+            turtles_at.assign(max_distance + 1, 0);
+            buckets.resize(max_distance);
+
+            ocean.grid.visit([&](const auto& cells) {
+                for (std::size_t cell = 0; cell < num_cells; ++cell) {
+                    kind[cell] = static_cast<std::int8_t>(cells.get(cell));
+                }
+            });
+            // a trash cell joins the trash before it, like a step's new trash joins the trash that was there
+            for (int cell = 0; cell < ocean.num_cells; ++cell) {
+                if (kind[cell] == trash_value) {
+                    add_trash(ocean, cell);
+                }
+            }
+            rebuild_distances(ocean);
+        }
+
+        /**
+         * @brief brings the clusters and the distance field up to the ocean's grid, looking only at the cells its last step changed
+         * @param ocean the ocean after update_grid(), with track_changes on
+         */
+        void update(const Ocean& ocean) {
+            update(ocean, ocean.changed_cells);
+        }
+
+        /**
+         * @brief brings the clusters and the distance field up to the ocean's grid, looking only at the given cells
+         * @param ocean the ocean
+         * @param changed every cell written since the last update, e.g. Ocean::Frame::changed of a frame that skipped steps
+         */
+        void update(const Ocean& ocean, std::span<const int> changed) {
+            removed.clear();
+            added.clear();
+            changes.clear();
+            ocean.grid.visit([&](const auto& cells) {
+                for (int cell : changed) {
+                    const auto now = static_cast<std::int8_t>(cells.get(cell));
+                    if (now == kind[cell]) {
+                        continue;
+                    }
+                    if (kind[cell] == trash_value) {
+                        removed.push_back(cell);
+                    } else if (now == trash_value) {
+                        added.push_back(cell);
+                    }
+                    changes.push_back({cell, now});
+                }
+            });
+            // the removed trash is still in kind, which tells the remaining trash apart from it below:
+            for (int cell : removed) {
+                kind[cell] = static_cast<std::int8_t>(Ocean::Occupy::Empty);
+            }
+            remove_trash(ocean);
+            for (int cell : added) {
+                add_trash(ocean, cell);
+            }
+            update_distances(ocean);
+            // turtle moves last, the distance updates above counted the turtles where they were
+            for (const auto& [cell, now] : changes) {
+                if (kind[cell] == turtle_value) {
+                    remove_turtle(distance[cell]);
+                }
+                if (now == turtle_value) {
+                    add_turtle(distance[cell]);
+                }
+                kind[cell] = now;
+            }
+        }
+
+        /**
+         * @brief the statistics of the grid of the last update
+         * @param step Ocean::step to stamp the summary with
+         */
+        AnalyticsSummary summary(std::uint64_t step = 0) const {
+            AnalyticsSummary result;
+            result.step = step;
+            result.trash = num_trash;
+            result.clusters = num_clusters;
+            result.largest_cluster = largest;
+            result.turtles = num_turtles;
+            result.unreached = turtles_at.back();
+            result.adjacent = turtles_at.size() > 2 ? turtles_at[1] : 0;
+            for (std::size_t d = 1; d + 1 < turtles_at.size(); ++d) {
+                if (turtles_at[d] > 0) {
+                    result.min_distance = static_cast<int>(d);
+                    break;
+                }
+            }
+            result.mean_distance = reached > 0 ? static_cast<double>(distance_sum) / reached : 0.;
+            return result;
+        }
+
+        /// @brief moves from cell to its nearest trash, unreachable if no trash can be reached
+        int distance_at(int cell) const { return distance[cell]; }
+
+        /// @brief cells in the trash cluster of cell, 0 if cell isn't trash
+        int cluster_size(int cell) const {
+            if (parent[cell] < 0) {
+                return 0;
+            }
+            while (parent[cell] != cell) {
+                cell = parent[cell];
+            }
+            return size[cell];
+        }
+
+    private:
+        static constexpr std::int8_t trash_value = static_cast<std::int8_t>(Ocean::Occupy::Trash);
+        static constexpr std::int8_t turtle_value = static_cast<std::int8_t>(Ocean::Occupy::Turtle);
+        /// @brief the distance field is rebuilt once the raised cells pass this share of the grid
+        static constexpr std::size_t rebuild_share = 4;
+
+        /**
+         * @brief calls fn with every cell one move away from cell, skipping moves that leave the grid
+         */
+        template <class F>
+        static void for_each_neighbor(const Ocean& ocean, int cell, F&& fn) {
+            const int i = cell / ocean.num_cols;
+            const int j = cell % ocean.num_cols;
+            for (int dir = 1; dir < 9; ++dir) {
+                const int next = ocean.neighbor(i, j, Ocean::direction_rows[dir], Ocean::direction_cols[dir]);
+                if (next >= 0) {
+                    fn(next);
+                }
+            }
+        }
+
+        /**
+         * @brief root of the cluster of a trash cell, halving the path on the way
+         */
+        int find(int cell) {
+            while (parent[cell] != cell) {
+                parent[cell] = parent[parent[cell]];
+                cell = parent[cell];
+            }
+            return cell;
+        }
+
+        /// @brief counts a new cluster of the given size
+        void add_cluster(int cells) {
+            clusters_of_size[cells]++;
+            num_clusters++;
+            largest = std::max(largest, cells);
+        }
+
+        /// @brief forgets a cluster of the given size
+        void drop_cluster(int cells) {
+            clusters_of_size[cells]--;
+            num_clusters--;
+            while (largest > 0 and clusters_of_size[largest] == 0) {
+                largest--;
+            }
+        }
+
+        /**
+         * @brief makes cell a cluster of its own and merges it with the trash around it
+         */
+        void add_trash(const Ocean& ocean, int cell) {
+            parent[cell] = cell;
+            size[cell] = 1;
+            add_cluster(1);
+            num_trash++;
+            for_each_neighbor(ocean, cell, [&](int next) {
+                if (parent[next] < 0) {
+                    return;
+                }
+                int a = find(cell);
+                int b = find(next);
+                if (a == b) {
+                    return;
+                }
+                if (size[a] < size[b]) {
+                    std::swap(a, b);
+                }
+                drop_cluster(size[a]);
+                drop_cluster(size[b]);
+                parent[b] = a;
+                size[a] += size[b];
+                add_cluster(size[a]);
+            });
+        }
+
+        /**
+         * @brief takes the removed trash out of its clusters, and relabels the cells left in those clusters
+         * @details the clusters are collected through the forest as it was, their remaining cells are then flooded again
+         *          without the removed ones, which splits a cluster whose bridge was removed
+         */
+        void remove_trash(const Ocean& ocean) {
+            if (removed.empty()) {
+                return;
+            }
+            stamp++;
+            members.clear();
+            for (int cell : removed) {
+                if (mark[cell] == stamp) {
+                    continue;
+                }
+                drop_cluster(size[find(cell)]);
+                mark[cell] = stamp;
+                members.push_back(cell);
+                for (std::size_t head = members.size() - 1; head < members.size(); ++head) {
+                    for_each_neighbor(ocean, members[head], [&](int next) {
+                        if (parent[next] >= 0 and mark[next] != stamp) {
+                            mark[next] = stamp;
+                            members.push_back(next);
+                        }
+                    });
+                }
+            }
+            num_trash -= static_cast<int>(removed.size());
+            for (int cell : members) {
+                parent[cell] = -1;
+            }
+            for (int root : members) {
+                if (parent[root] >= 0 or kind[root] != trash_value) {
+                    continue;
+                }
+                // flood the remaining cells of the old cluster that hang together with root
+                parent[root] = root;
+                queue.clear();
+                queue.push_back(root);
+                for (std::size_t head = 0; head < queue.size(); ++head) {
+                    for_each_neighbor(ocean, queue[head], [&](int next) {
+                        if (mark[next] == stamp and parent[next] < 0 and kind[next] == trash_value) {
+                            parent[next] = root;
+                            queue.push_back(next);
+                        }
+                    });
+                }
+                size[root] = static_cast<int>(queue.size());
+                add_cluster(size[root]);
+            }
+        }
+
+        /// @brief counts a turtle at distance d
+        void add_turtle(int d) {
+            num_turtles++;
+            if (d == unreachable) {
+                turtles_at.back()++;
+                return;
+            }
+            turtles_at[d]++;
+            reached++;
+            distance_sum += d;
+        }
+
+        /// @brief forgets a turtle at distance d
+        void remove_turtle(int d) {
+            num_turtles--;
+            if (d == unreachable) {
+                turtles_at.back()--;
+                return;
+            }
+            turtles_at[d]--;
+            reached--;
+            distance_sum -= d;
+        }
+
+        /**
+         * @brief sets the distance of cell, moving a turtle on it to its new histogram bucket
+         */
+        void set_distance(int cell, int d, int source) {
+            if (kind[cell] == turtle_value) {
+                remove_turtle(distance[cell]);
+                add_turtle(d);
+            }
+            distance[cell] = d;
+            nearest[cell] = source;
+        }
+
+        /**
+         * @brief lowers distances from the cells in buckets, nearest first, until no distance drops
+         * @param top highest bucket holding a cell
+         */
+        void refill(const Ocean& ocean, int top) {
+            for (int d = 0; d <= top; ++d) {
+                for (std::size_t k = 0; k < buckets[d].size(); ++k) {
+                    const int cell = buckets[d][k];
+                    if (distance[cell] != d) {
+                        continue;
+                    }
+                    for_each_neighbor(ocean, cell, [&](int next) {
+                        if (d + 1 < distance[next]) {
+                            set_distance(next, d + 1, nearest[cell]);
+                            buckets[d + 1].push_back(next);
+                            top = std::max(top, d + 1);
+                        }
+                    });
+                }
+                buckets[d].clear();
+            }
+        }
+
+        /**
+         * @brief computes the distance field and the turtle histogram from scratch, from the trash in kind and in added
+         */
+        void rebuild_distances(const Ocean& ocean) {
+            std::fill(distance.begin(), distance.end(), unreachable);
+            std::fill(nearest.begin(), nearest.end(), -1);
+            for (int cell = 0; cell < ocean.num_cells; ++cell) {
+                if (kind[cell] == trash_value) {
+                    distance[cell] = 0;
+                    nearest[cell] = cell;
+                    buckets[0].push_back(cell);
+                }
+            }
+            for (int cell : added) {
+                distance[cell] = 0;
+                nearest[cell] = cell;
+                buckets[0].push_back(cell);
+            }
+            refill(ocean, 0);
+            // the refill moved turtles between buckets from distances that were wiped, count them again:
+            std::fill(turtles_at.begin(), turtles_at.end(), 0);
+            num_turtles = 0;
+            reached = 0;
+            distance_sum = 0;
+            for (int cell = 0; cell < ocean.num_cells; ++cell) {
+                if (kind[cell] == turtle_value) {
+                    add_turtle(distance[cell]);
+                }
+            }
+        }
+
+        /**
+         * @brief raises the distances the removed trash held down, then lowers distances from the cells around them and from the new trash
+         * @details every cell's nearest trash is reached through neighbors with the same nearest trash, so the cells of one removed trash
+         *          are found by a search from it. when so much trash moved that the raised cells cover a large share of the grid,
+         *          a fresh search from all trash is cheaper and replaces the update.
+         */
+        void update_distances(const Ocean& ocean) {
+            const std::size_t limit = static_cast<std::size_t>(ocean.num_cells) / rebuild_share;
+            cleared.clear();
+            for (int source : removed) {
+                const std::size_t first = cleared.size();
+                set_distance(source, unreachable, -1);
+                cleared.push_back(source);
+                for (std::size_t head = first; head < cleared.size(); ++head) {
+                    for_each_neighbor(ocean, cleared[head], [&](int next) {
+                        if (nearest[next] == source) {
+                            set_distance(next, unreachable, -1);
+                            cleared.push_back(next);
+                        }
+                    });
+                }
+                if (cleared.size() > limit) {
+                    rebuild_distances(ocean);
+                    return;
+                }
+            }
+            // the refill starts from the cells around the raised ones, and from the new trash:
+            int top = 0;
+            stamp++;
+            for (int cell : cleared) {
+                for_each_neighbor(ocean, cell, [&](int next) {
+                    if (distance[next] != unreachable and mark[next] != stamp) {
+                        mark[next] = stamp;
+                        buckets[distance[next]].push_back(next);
+                        top = std::max(top, distance[next]);
+                    }
+                });
+            }
+            for (int cell : added) {
+                set_distance(cell, 0, cell);
+                buckets[0].push_back(cell);
+            }
+            refill(ocean, top);
+        }
+
+        std::vector<std::int8_t> kind; ///< the cells as of the last update
+        std::vector<int> parent; ///< union-find parent of a trash cell, -1 for any other cell
+        std::vector<int> size; ///< cells in the cluster, valid at cluster roots
+        std::vector<std::uint32_t> mark; ///< stamp of the last search that visited the cell
+        std::vector<int> distance; ///< moves to the nearest trash
+        std::vector<int> nearest; ///< the trash cell distance is measured to, -1 if unreachable
+        std::vector<int> clusters_of_size; ///< number of clusters of every size
+        std::vector<int> turtles_at; ///< turtles at every distance, the last entry counts the unreached ones
+        int num_clusters{0};
+        int largest{0}; ///< size of the largest cluster
+        int num_trash{0};
+        int num_turtles{0};
+        int reached{0}; ///< turtles with a finite distance
+        std::int64_t distance_sum{0}; ///< summed distances of the reached turtles
+        std::uint32_t stamp{0}; ///< last stamp handed out to mark
+
+        // scratch of update(), kept to not allocate once it has grown
+        std::vector<int> removed; ///< cells that lost their trash
+        std::vector<int> added; ///< cells that gained trash
+        std::vector<std::pair<int, std::int8_t>> changes; ///< cells whose value changed, with the new value
+        std::vector<int> members; ///< cells of the clusters touched by removed trash
+        std::vector<int> queue;
+        std::vector<int> cleared; ///< cells whose distance was raised
+        std::vector<std::vector<int>> buckets; ///< cells waiting for the refill, by distance
+};
+
+/**
+ * @class AnalyticsWriter
+ * @brief updates SpatialAnalytics after every step and writes its summary as one row per step
+ */
+class AnalyticsWriter {
+    public:
+        /**
+         * @brief opens the file, writes the header row of a CSV file and builds the analytics of the ocean's current grid
+         * @param path output file, JSON Lines if it ends in .json or .jsonl, CSV otherwise
+         * @param ocean the ocean that will be recorded. its change tracking is switched on
+         * @throws std::runtime_error if the file can't be opened
+         */
+        AnalyticsWriter(const std::string& path, Ocean& ocean) : file(path, std::ios::trunc), analytics(ocean) {
+            if (not file) {
+                throw std::runtime_error("AnalyticsWriter: can't open " + path);
+            }
+            json = path.ends_with(".json") or path.ends_with(".jsonl");
+            if (not json) {
+                file << "step,trash,clusters,largest_cluster,mean_cluster,turtles,unreached,adjacent,min_distance,mean_distance\n";
+            }
+        }
+
+        AnalyticsWriter(const AnalyticsWriter&) = delete;
+        AnalyticsWriter& operator=(const AnalyticsWriter&) = delete;
+
+        /**
+         * @brief updates the analytics with the ocean's last step and writes its summary
+         * @param ocean the ocean after update_grid()
+         */
+        void record(const Ocean& ocean) {
+            analytics.update(ocean);
+            const AnalyticsSummary s = analytics.summary(ocean.step);
+            if (json) {
+                file << "{\"step\":" << s.step << ",\"trash\":{\"cells\":" << s.trash << ",\"clusters\":" << s.clusters << ",\"largest\":" << s.largest_cluster
+                     << ",\"mean\":" << s.mean_cluster() << "},\"turtles\":{\"count\":" << s.turtles << ",\"unreached\":" << s.unreached << ",\"adjacent\":" << s.adjacent
+                     << ",\"min_distance\":" << s.min_distance << ",\"mean_distance\":" << s.mean_distance << "}}\n";
+            } else {
+                file << s.step << ',' << s.trash << ',' << s.clusters << ',' << s.largest_cluster << ',' << s.mean_cluster() << ',' << s.turtles << ','
+                     << s.unreached << ',' << s.adjacent << ',' << s.min_distance << ',' << s.mean_distance << '\n';
+            }
+        }
+
+        /// @brief the analytics as of the last recorded step
+        const SpatialAnalytics& state() const { return analytics; }
+
+    private:
+        std::ofstream file;
+        bool json{false}; ///< JSON Lines instead of CSV
+        SpatialAnalytics analytics;
+};
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Ensemble Runs
+ * @section EnsembleRuns Ensemble Runs
+ * This section runs many independent replicas of the same ocean and aggregates their populations step by step.
+ * Every replica gets its own seed, derived from the ensemble seed and the replica number, for both the initial grid and the step loop.
+ * Populations are streamed into running mean and variance accumulators, so no replica trajectory is kept.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @brief running mean and variance of a stream of values (Welford's algorithm)
+ */
+struct OnlineStats {
+    std::uint64_t count{0}; ///< number of values added
+    double mean{0.}; ///< mean of the values
+    double m2{0.}; ///< sum of squared differences from the mean
+
+    /**
+     * @brief adds one value
+     */
+    void add(double value) {
+        count++;
+        double delta = value - mean;
+        mean += delta / static_cast<double>(count);
+        m2 += delta * (value - mean);
+    }
+
+    /**
+     * @brief adds all values of another accumulator (Chan et al. pairwise update)
+     */
+    void merge(const OnlineStats& other) {
+        if (other.count == 0) {
+            return;
+        }
+        std::uint64_t total = count + other.count;
+        double delta = other.mean - mean;
+        mean += delta * static_cast<double>(other.count) / static_cast<double>(total);
+        m2 += other.m2 + delta * delta * static_cast<double>(count) * static_cast<double>(other.count) / static_cast<double>(total);
+        count = total;
+    }
+
+    /**
+     * @brief sample variance, 0 for fewer than 2 values
+     */
+    double variance() const {
+        return count > 1 ? m2 / static_cast<double>(count - 1) : 0.;
+    }
+
+    /**
+     * @brief half width of the normal-approximation 95% confidence interval of the mean
+     */
+    double ci95() const {
+        return count > 0 ? 1.96 * std::sqrt(variance() / static_cast<double>(count)) : 0.;
+    }
+};
+
+/**
+ * @brief aggregated populations of all replicas at one step
+ */
+struct EnsembleStep {
+    OnlineStats turtles; ///< turtle population
+    OnlineStats trash; ///< trash population
+    OnlineStats ships; ///< ship population
+    OnlineStats turtle_survival; ///< 1 if the replica still has turtles, 0 otherwise - its mean is the survival probability
+
+    /**
+     * @brief adds the populations of one replica
+     */
+    void add(int num_turtle, int num_trash, int num_ship) {
+        turtles.add(num_turtle);
+        trash.add(num_trash);
+        ships.add(num_ship);
+        turtle_survival.add(num_turtle > 0 ? 1. : 0.);
+    }
+
+    /**
+     * @brief adds the replicas of another accumulator
+     */
+    void merge(const EnsembleStep& other) {
+        turtles.merge(other.turtles);
+        trash.merge(other.trash);
+        ships.merge(other.ships);
+        turtle_survival.merge(other.turtle_survival);
+    }
+};
+
+/**
+ * @brief setup shared by all replicas of an ensemble
+ */
+struct EnsembleConfig {
+    int rows{70}; ///< number of rows in the grid
+    int cols{70}; ///< number of columns in the grid
+    int turtles{40}; ///< turtle population
+    int trash{40}; ///< trash population
+    int ships{14}; ///< ship population
+    float turtle_idle_chance{1.f / 9.f}; ///< Ocean::turtle_idle_chance of every replica
+    float trash_idle_chance{0.5f}; ///< Ocean::trash_idle_chance of every replica
+    float ship_idle_chance{0.2f}; ///< Ocean::ship_idle_chance of every replica
+    optional<double> turtle_density{nullopt}; ///< fraction of the cells that start with a turtle, overrides turtles
+    optional<double> trash_density{nullopt}; ///< fraction of the cells that start with trash, overrides trash
+    optional<double> ship_density{nullopt}; ///< fraction of the cells that start with a ship, overrides ships
+    int steps{100}; ///< number of steps each replica runs
+    int replicas{100}; ///< number of replicas
+    std::uint64_t seed{0}; ///< ensemble seed, replica seeds are derived from it
+    Ocean::Engine engine{Ocean::Engine::Tiled}; ///< engine of every replica
+    Ocean::Boundary boundary{Ocean::Boundary::Reflecting}; ///< boundary policy of every replica
+    Ocean::Placement placement; ///< how the agents of every replica are spread
+    GridLayout layout{GridLayout::Byte}; ///< grid layout of every replica
+};
+
+/**
+ * @brief seed of one replica of an ensemble
+ * @param seed ensemble seed
+ * @param replica replica number
+ * @return a well mixed 64-bit seed (splitmix64 finalizer), different for every replica
+ */
+inline std::uint64_t replica_seed(std::uint64_t seed, std::uint64_t replica) {
+    std::uint64_t z = seed + (replica + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief runs config.replicas independent replicas across the pool
+ * @param config setup of the replicas
+ * @param pool threads that run the replicas, each replica runs on a single thread
+ * @return aggregated populations for steps 0 (initial grid) to config.steps
+ * @details replicas are grouped in fixed chunks of ensemble_chunk_size that are handed out to the threads one at a time, so threads that
+ *          finish early pick up the remaining chunks. every chunk has its own accumulators, and they are merged in chunk order,
+ *          so the statistics are the same for any number of threads.
+ */
+constexpr int ensemble_chunk_size = 16;
+
+inline std::vector<EnsembleStep> run_ensemble(const EnsembleConfig& config, ThreadPool& pool) {
+    const int num_chunks = (config.replicas + ensemble_chunk_size - 1) / ensemble_chunk_size;
+    std::vector<std::vector<EnsembleStep>> chunk_steps(num_chunks, std::vector<EnsembleStep>(config.steps + 1));
+
+    auto run_chunk = [&](int chunk) {
+        std::vector<EnsembleStep>& steps = chunk_steps[chunk];
+        const int end = std::min(config.replicas, (chunk + 1) * ensemble_chunk_size);
+        for (int replica = chunk * ensemble_chunk_size; replica < end; ++replica) {
+            const std::uint64_t seed = replica_seed(config.seed, static_cast<std::uint64_t>(replica));
+            seed_random(static_cast<unsigned int>(seed));
+            Ocean ocean(config.rows, config.cols, config.turtles, config.trash, config.ships);
+            ocean.turtle_idle_chance = config.turtle_idle_chance;
+            ocean.trash_idle_chance = config.trash_idle_chance;
+            ocean.ship_idle_chance = config.ship_idle_chance;
+            if (config.turtle_density) ocean.num_turtle = ocean.cells_for_density(*config.turtle_density);
+            if (config.trash_density) ocean.num_trash = ocean.cells_for_density(*config.trash_density);
+            if (config.ship_density) ocean.num_ship = ocean.cells_for_density(*config.ship_density);
+            ocean.placement = config.placement;
+            ocean.set_boundary(config.boundary);
+            ocean.set_dummy_grid();
+            ocean.seed(seed);
+            ocean.set_engine(config.engine);
+            ocean.set_grid_layout(config.layout);
+
+            steps[0].add(ocean.num_turtle, ocean.num_trash, ocean.num_ship);
+            for (int t = 1; t <= config.steps; ++t) {
+                ocean.update_grid();
+                steps[t].add(ocean.num_turtle, ocean.num_trash, ocean.num_ship);
+            }
+        }
+    };
+    pool.parallel_for(num_chunks, run_chunk);
+
+    std::vector<EnsembleStep> result(config.steps + 1);
+    for (const std::vector<EnsembleStep>& steps : chunk_steps) {
+        for (int t = 0; t <= config.steps; ++t) {
+            result[t].merge(steps[t]);
+        }
+    }
+    return result;
+}
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Parameter Sweeps
+ * @section ParameterSweeps Parameter Sweeps
+ * This section runs the ocean over a grid of model parameters (idle chances and initial densities) for phase-diagram studies.
+ * Every combination of the parameter values is a sweep point, and every point runs the same number of replicas.
+ * A run stops early once its outcome can't change any more:
+ *  - extinct: no turtles left
+ *  - safe: no trash and no ships left, so no turtle can die any more
+ *  - steady: populations haven't changed for steady_window steps
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @brief model parameters of one sweep point
+ */
+struct SweepPoint {
+    float turtle_idle_chance{1.f / 9.f}; ///< Ocean::turtle_idle_chance
+    float trash_idle_chance{0.5f}; ///< Ocean::trash_idle_chance
+    float ship_idle_chance{0.2f}; ///< Ocean::ship_idle_chance
+    double turtle_density{0.0025}; ///< fraction of the cells that start with a turtle
+    double trash_density{0.005}; ///< fraction of the cells that start with trash
+    double ship_density{0.0002}; ///< fraction of the cells that start with a ship
+};
+
+/**
+ * @brief the values to sweep for every parameter, an empty list keeps the SweepPoint default
+ */
+struct SweepConfig {
+    int rows{70}; ///< number of rows in the grid
+    int cols{70}; ///< number of columns in the grid
+    int steps{1000}; ///< most steps of a run
+    int replicas{10}; ///< runs per sweep point
+    int steady_window{100}; ///< stop a run once its populations haven't changed for this many steps, 0 never
+    std::uint64_t seed{0}; ///< sweep seed, replica seeds are derived from it
+    Ocean::Engine engine{Ocean::Engine::Tiled}; ///< engine of every run
+    Ocean::Boundary boundary{Ocean::Boundary::Reflecting}; ///< boundary policy of every run
+    GridLayout layout{GridLayout::Byte}; ///< grid layout of every run
+    std::vector<float> turtle_idle_chances; ///< values of Ocean::turtle_idle_chance
+    std::vector<float> trash_idle_chances; ///< values of Ocean::trash_idle_chance
+    std::vector<float> ship_idle_chances; ///< values of Ocean::ship_idle_chance
+    std::vector<double> turtle_densities; ///< values of SweepPoint::turtle_density
+    std::vector<double> trash_densities; ///< values of SweepPoint::trash_density
+    std::vector<double> ship_densities; ///< values of SweepPoint::ship_density
+    Ocean::Placement placement; ///< how the agents of every run are spread
+
+    /**
+     * @brief every combination of the parameter values, the last parameter varies fastest
+     */
+    std::vector<SweepPoint> points() const {
+        const SweepPoint defaults;
+        auto values = [](const auto& list, auto fallback) {
+            return list.empty() ? std::vector<decltype(fallback)>{fallback} : list;
+        };
+        std::vector<SweepPoint> result;
+        for (float turtle_idle : values(turtle_idle_chances, defaults.turtle_idle_chance))
+        for (float trash_idle : values(trash_idle_chances, defaults.trash_idle_chance))
+        for (float ship_idle : values(ship_idle_chances, defaults.ship_idle_chance))
+        for (double turtle_density : values(turtle_densities, defaults.turtle_density))
+        for (double trash_density : values(trash_densities, defaults.trash_density))
+        for (double ship_density : values(ship_densities, defaults.ship_density)) {
+            result.push_back({turtle_idle, trash_idle, ship_idle, turtle_density, trash_density, ship_density});
+        }
+        return result;
+    }
+};
+
+/**
+ * @brief how a single sweep run ended
+ */
+enum class RunEnd : std::uint8_t { Extinct, Safe, Steady, Limit };
+
+/**
+ * @brief summary of one sweep run
+ */
+struct SweepRun {
+    RunEnd end{RunEnd::Limit}; ///< why the run stopped, Limit if it ran all steps
+    int steps{0}; ///< steps simulated
+    int initial_turtles{0}; ///< turtles placed at the start
+    int final_turtles{0}; ///< turtles left at the end
+};
+
+/**
+ * @brief aggregated runs of one sweep point
+ */
+struct SweepResult {
+    SweepPoint point; ///< parameters of the point
+    int replicas{0}; ///< runs of the point
+    int extinct{0}; ///< runs that ended without turtles
+    int safe{0}; ///< runs that ended without trash and ships
+    int steady{0}; ///< runs that ended in a steady state
+    OnlineStats steps; ///< steps simulated per run
+    OnlineStats extinction_step; ///< step of extinction, over the extinct runs
+    OnlineStats turtle_survival; ///< final turtles / initial turtles, over the runs that started with turtles
+};
+
+/**
+ * @brief runs a single sweep run until it ends early or reaches config.steps
+ * @param config sweep setup
+ * @param point parameters of the run
+ * @param seed seed of the initial grid and the step loop
+ */
+inline SweepRun run_sweep_point(const SweepConfig& config, const SweepPoint& point, std::uint64_t seed) {
+    seed_random(static_cast<unsigned int>(seed));
+    // the densities alone decide the initial populations:
+    Ocean ocean(config.rows, config.cols, 0, 0, 0);
+    ocean.turtle_idle_chance = point.turtle_idle_chance;
+    ocean.trash_idle_chance = point.trash_idle_chance;
+    ocean.ship_idle_chance = point.ship_idle_chance;
+    ocean.num_turtle = ocean.cells_for_density(point.turtle_density);
+    ocean.num_trash = ocean.cells_for_density(point.trash_density);
+    ocean.num_ship = ocean.cells_for_density(point.ship_density);
+    ocean.placement = config.placement;
+    ocean.set_boundary(config.boundary);
+    ocean.set_dummy_grid();
+    ocean.seed(seed);
+    ocean.set_engine(config.engine);
+    ocean.set_grid_layout(config.layout);
+
+    SweepRun run;
+    run.initial_turtles = ocean.num_turtle;
+    std::array<int, 3> last_population{ocean.num_turtle, ocean.num_trash, ocean.num_ship};
+    int unchanged = 0;
+    while (true) {
+        if (ocean.num_turtle == 0) {
+            run.end = RunEnd::Extinct;
+            break;
+        }
+        if (ocean.num_trash == 0 and ocean.num_ship == 0) {
+            run.end = RunEnd::Safe;
+            break;
+        }
+        if (config.steady_window > 0 and unchanged >= config.steady_window) {
+            run.end = RunEnd::Steady;
+            break;
+        }
+        if (run.steps == config.steps) {
+            break;
+        }
+        ocean.update_grid();
+        run.steps++;
+        std::array<int, 3> population{ocean.num_turtle, ocean.num_trash, ocean.num_ship};
+        unchanged = population == last_population ? unchanged + 1 : 0;
+        last_population = population;
+    }
+    run.final_turtles = ocean.num_turtle;
+    return run;
+}
+
+/**
+ * @brief runs every sweep point config.replicas times across the pool
+ * @param config sweep setup
+ * @param pool threads that run the sweep, each run is on a single thread
+ * @return one result per sweep point, in the order of SweepConfig::points()
+ * @details runs are handed out one at a time, so the many runs that stop early leave their threads free for the long ones.
+ *          replica r of every point uses the same seed, so points are compared on the same random numbers where possible.
+ *          the results don't depend on the number of threads.
+ */
+inline std::vector<SweepResult> run_sweep(const SweepConfig& config, ThreadPool& pool) {
+    const std::vector<SweepPoint> points = config.points();
+    std::vector<SweepRun> runs(points.size() * static_cast<std::size_t>(config.replicas));
+
+    auto run_one = [&](int index) {
+        const std::size_t point = static_cast<std::size_t>(index) / config.replicas;
+        const int replica = index % config.replicas;
+        runs[index] = run_sweep_point(config, points[point], replica_seed(config.seed, static_cast<std::uint64_t>(replica)));
+    };
+    pool.parallel_for(static_cast<int>(runs.size()), run_one);
+
+    std::vector<SweepResult> results(points.size());
+    for (std::size_t point = 0; point < points.size(); ++point) {
+        SweepResult& result = results[point];
+        result.point = points[point];
+        for (int replica = 0; replica < config.replicas; ++replica) {
+            const SweepRun& run = runs[point * config.replicas + replica];
+            result.replicas++;
+            result.steps.add(run.steps);
+            switch (run.end) {
+                case RunEnd::Extinct:
+                    result.extinct++;
+                    result.extinction_step.add(run.steps);
+                    break;
+                case RunEnd::Safe: result.safe++; break;
+                case RunEnd::Steady: result.steady++; break;
+                case RunEnd::Limit: break;
+            }
+            if (run.initial_turtles > 0) {
+                result.turtle_survival.add(static_cast<double>(run.final_turtles) / run.initial_turtles);
+            }
+        }
+    }
+    return results;
+}
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Trajectory Output
+ * @section TrajectoryOutput Trajectory Output
+ * This section contains a binary trajectory format for offline analysis and the background thread that writes it.
+ * A trajectory file is a 32-byte TrajectoryHeader followed by one frame per recorded step. Each frame is a 40-byte TrajectoryFrameHeader
+ * followed by its payload:
+ *  - key frame: every cell as one int8_t Occupy value
+ *  - delta frame: varint number of changed cells, then for each changed cell the varint gap to the previous changed cell and its int8_t value
+ * Payloads are optionally compressed with PackBits run-length encoding, per frame and only when that makes the frame smaller.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @brief PackBits run-length encoding of a block of bytes
+ * @param input bytes to compress
+ * @param size number of bytes
+ * @param output compressed bytes are appended here
+ * @details runs of 3 to 128 equal bytes become (1 - length, byte), everything else is copied in literal blocks of up to 128 bytes as (length - 1, bytes...)
+ */
+inline void packbits_compress(const std::uint8_t* input, std::size_t size, std::vector<std::uint8_t>& output) {
+    std::size_t i = 0;
+    while (i < size) {
+        // length of the run starting at i:
+        std::size_t run = 1;
+        while (i + run < size and run < 128 and input[i + run] == input[i]) {
+            run++;
+        }
+        if (run >= 3) {
+            output.push_back(static_cast<std::uint8_t>(1 - static_cast<int>(run)));
+            output.push_back(input[i]);
+            i += run;
+            continue;
+        }
+        // literal block up to the next run of 3 or more:
+        std::size_t start = i;
+        while (i < size and i - start < 128) {
+            if (i + 2 < size and input[i] == input[i + 1] and input[i] == input[i + 2]) {
+                break;
+            }
+            i++;
+        }
+        output.push_back(static_cast<std::uint8_t>(i - start - 1));
+        output.insert(output.end(), input + start, input + i);
+    }
+}
+
+/**
+ * @brief decodes PackBits data written by packbits_compress
+ * @param input compressed bytes
+ * @param size number of compressed bytes
+ * @param output decoded bytes are appended here
+ * @throws std::runtime_error if the data ends in the middle of a block
+ */
+inline void packbits_decompress(const std::uint8_t* input, std::size_t size, std::vector<std::uint8_t>& output) {
+    std::size_t i = 0;
+    while (i < size) {
+        int header = static_cast<std::int8_t>(input[i++]);
+        if (header >= 0) {
+            std::size_t length = static_cast<std::size_t>(header) + 1;
+            if (i + length > size) {
+                throw std::runtime_error("packbits_decompress: truncated literal block");
+            }
+            output.insert(output.end(), input + i, input + i + length);
+            i += length;
+        } else if (header != -128) {
+            if (i >= size) {
+                throw std::runtime_error("packbits_decompress: truncated run");
+            }
+            output.insert(output.end(), static_cast<std::size_t>(1 - header), input[i++]);
+        }
+    }
+}
+
+/**
+ * @brief appends an unsigned LEB128 varint
+ */
+inline void put_varint(std::vector<std::uint8_t>& output, std::uint64_t value) {
+    while (value >= 0x80) {
+        output.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    output.push_back(static_cast<std::uint8_t>(value));
+}
+
+/**
+ * @brief reads an unsigned LEB128 varint
+ * @param input data
+ * @param size size of the data
+ * @param position read position, advanced past the varint
+ * @throws std::runtime_error if the varint runs past the end of the data
+ */
+inline std::uint64_t get_varint(const std::uint8_t* input, std::size_t size, std::size_t& position) {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (position >= size) {
+            throw std::runtime_error("get_varint: truncated varint");
+        }
+        std::uint8_t byte = input[position++];
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("get_varint: varint too long");
+}
+
+/**
+ * @brief header at the start of every trajectory file
+ */
+struct TrajectoryHeader {
+    char magic[8]; ///< "OCEANTRJ"
+    std::uint32_t version; ///< format version, 1
+    std::uint32_t byte_order; ///< 0x01020304 as written by the saving machine
+    std::int32_t num_rows; ///< grid rows
+    std::int32_t num_cols; ///< grid columns
+    std::uint32_t keyframe_interval; ///< a key frame is written every this many frames
+    std::uint32_t flags; ///< bit 0: frames may be PackBits compressed
+};
+static_assert(sizeof(TrajectoryHeader) == 32, "trajectory header must stay 32 bytes");
+
+/**
+ * @brief header in front of every frame of a trajectory file
+ */
+struct TrajectoryFrameHeader {
+    std::uint32_t type; ///< 0 for a key frame, 1 for a delta frame
+    std::uint32_t encoding; ///< 0 for raw payload, 1 for PackBits
+    std::uint64_t step; ///< Ocean::step after the frame's update
+    std::int32_t num_turtle; ///< turtle population
+    std::int32_t num_trash; ///< trash population
+    std::int32_t num_ship; ///< ship population
+    std::uint32_t raw_size; ///< payload size before compression
+    std::uint32_t stored_size; ///< payload size in the file
+    std::uint32_t reserved; ///< zero, padding to 40 bytes
+};
+static_assert(sizeof(TrajectoryFrameHeader) == 40, "trajectory frame header must stay 40 bytes");
+
+/**
+ * @class TrajectoryWriter
+ * @brief writes frames of an Ocean to a trajectory file on a background thread
+ * @details the simulation thread only copies the changed cells (or the whole grid for key frames) into a free frame slot.
+ *          encoding, compression and disk writes happen on the writer thread. slots are preallocated and recycled,
+ *          so recording doesn't allocate once the slots have grown to their working size.
+ *          when all slots are in flight, record() drops the frame instead of waiting, and the next recorded frame is a key frame,
+ *          so the simulation thread never blocks on disk I/O and the file always decodes to the correct grid.
+ *          the writer thread checks the stream after every frame, close() reports a failed write.
+ */
+class TrajectoryWriter {
+    public:
+        /**
+         * @brief opens the file, writes its header and starts the writer thread
+         * @param path trajectory file to write
+         * @param ocean the ocean that will be recorded, for the dimensions. its change tracking is switched on
+         * @param _keyframe_interval write a key frame every this many frames, at least 1
+         * @param _compress PackBits-compress frames when that makes them smaller
+         * @param queue_capacity number of frames that may wait for the writer thread
+         * @throws std::runtime_error if the file can't be opened or its header can't be written
+         */
+        TrajectoryWriter(const std::string& path, Ocean& ocean, int _keyframe_interval = 100, bool _compress = false, int queue_capacity = 16)
+            : file(path, std::ios::binary | std::ios::trunc), file_path(path), keyframe_interval(std::max(1, _keyframe_interval)), compress(_compress), slots(std::max(1, queue_capacity)) {
+            if (not file) {
+                throw std::runtime_error("TrajectoryWriter: can't open " + path);
+            }
+            TrajectoryHeader header{};
+            std::memcpy(header.magic, "OCEANTRJ", 8);
+            header.version = 1;
+            header.byte_order = 0x01020304;
+            header.num_rows = ocean.num_rows;
+            header.num_cols = ocean.num_cols;
+            header.keyframe_interval = static_cast<std::uint32_t>(keyframe_interval);
+            header.flags = compress ? 1u : 0u;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            if (not file) {
+                throw std::runtime_error("TrajectoryWriter: can't write " + path);
+            }
+
+            ocean.set_track_changes(true);
+            // size every buffer for the worst case up front, recording and writing never allocate afterwards:
+            const std::size_t num_cells = static_cast<std::size_t>(ocean.num_cells);
+            for (Frame& slot : slots) {
+                slot.cells.reserve(num_cells);
+                slot.values.reserve(num_cells);
+                free_slots.push_back(&slot);
+            }
+            free_slots.reserve(slots.size());
+            queued.resize(slots.size());
+            // a delta frame holds at most every cell, with varint gaps adding up to num_cells:
+            raw.reserve(2 * num_cells + 16);
+            packed.reserve(raw.capacity() + raw.capacity() / 128 + 16);
+            writer = std::thread([this] { write_loop(); });
+        }
+
+        TrajectoryWriter(const TrajectoryWriter&) = delete;
+        TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+        /**
+         * @brief writes all queued frames, stops the writer thread and closes the file, ignoring write errors. call close() to see them
+         */
+        ~TrajectoryWriter() {
+            stop();
+        }
+
+        /**
+         * @brief writes all queued frames, stops the writer thread and closes the file. record() must not be called afterwards
+         * @throws std::runtime_error if a frame or the end of the file couldn't be written, again on every later call
+         */
+        void close() {
+            stop();
+            if (file.is_open()) {
+                file.close();
+                write_failed = write_failed or not file;
+            }
+            if (write_failed) {
+                throw std::runtime_error("TrajectoryWriter: can't write " + file_path);
+            }
+        }
+
+        /**
+         * @brief records the ocean's current state as the next frame
+         * @param ocean the ocean after update_grid(), with track_changes on
+         * @return false if the frame was dropped because the writer thread is behind
+         */
+        bool record(const Ocean& ocean) {
+            Frame* frame = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (not free_slots.empty()) {
+                    frame = free_slots.back();
+                    free_slots.pop_back();
+                }
+            }
+            if (frame == nullptr) {
+                // no free slot - drop the frame and resynchronize with a key frame
+                dropped_frames++;
+                need_keyframe = true;
+                return false;
+            }
+
+            frame->key = need_keyframe or frames_recorded % keyframe_interval == 0;
+            frame->step = ocean.step;
+            frame->population = {ocean.num_turtle, ocean.num_trash, ocean.num_ship};
+            frame->cells.clear();
+            frame->values.clear();
+            ocean.grid.visit([&](const auto& cells) {
+                if (frame->key) {
+                    frame->values.resize(cells.size());
+                    for (std::size_t cell = 0; cell < cells.size(); ++cell) {
+                        frame->values[cell] = static_cast<std::int8_t>(cells.get(cell));
+                    }
+                } else {
+                    frame->cells.assign(ocean.changed_cells.begin(), ocean.changed_cells.end());
+                    for (int cell : ocean.changed_cells) {
+                        frame->values.push_back(static_cast<std::int8_t>(cells.get(cell)));
+                    }
+                }
+            });
+            need_keyframe = false;
+            frames_recorded++;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queued[(queue_head + queue_size) % queued.size()] = frame;
+                queue_size++;
+            }
+            ready.notify_one();
+            return true;
+        }
+
+        /// @brief number of frames dropped so far because the writer thread was behind
+        std::size_t dropped() const { return dropped_frames; }
+
+        /// @brief number of frames handed to the writer thread so far
+        std::size_t recorded() const { return frames_recorded; }
+
+    private:
+        /**
+         * @brief lets the writer thread drain the queue and joins it, once
+         */
+        void stop() {
+            if (not writer.joinable()) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            ready.notify_one();
+            writer.join();
+        }
+
+        /**
+         * @brief one recorded step, reused across steps
+         */
+        struct Frame {
+            bool key{false}; ///< key frame with every cell, or delta frame with the changed cells
+            std::uint64_t step{0}; ///< Ocean::step of the frame
+            std::array<int, 3> population{}; ///< turtles, trash, ships
+            std::vector<int> cells; ///< changed cells of a delta frame, sorted
+            std::vector<std::int8_t> values; ///< values of the changed cells, or of every cell for a key frame
+        };
+
+        /**
+         * @brief writer thread body: encode and write frames until stopped and drained
+         */
+        void write_loop() {
+            while (true) {
+                Frame* frame = nullptr;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait(lock, [this] { return stopping or queue_size > 0; });
+                    if (queue_size == 0) {
+                        return; // stopping and drained
+                    }
+                    frame = queued[queue_head];
+                    queue_head = (queue_head + 1) % queued.size();
+                    queue_size--;
+                }
+                const bool written = write_frame(*frame);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    free_slots.push_back(frame);
+                    write_failed = write_failed or not written;
+                }
+            }
+        }
+
+        /**
+         * @brief encodes one frame and writes it to the file
+         * @return false if the stream has failed, on this frame or an earlier one
+         */
+        bool write_frame(const Frame& frame) {
+            raw.clear();
+            if (frame.key) {
+                const std::uint8_t* values = reinterpret_cast<const std::uint8_t*>(frame.values.data());
+                raw.assign(values, values + frame.values.size());
+            } else {
+                put_varint(raw, frame.cells.size());
+                int previous = 0;
+                for (std::size_t k = 0; k < frame.cells.size(); ++k) {
+                    put_varint(raw, static_cast<std::uint64_t>(frame.cells[k] - previous));
+                    raw.push_back(static_cast<std::uint8_t>(frame.values[k]));
+                    previous = frame.cells[k];
+                }
+            }
+
+            TrajectoryFrameHeader header{};
+            header.type = frame.key ? 0 : 1;
+            header.step = frame.step;
+            header.num_turtle = frame.population[0];
+            header.num_trash = frame.population[1];
+            header.num_ship = frame.population[2];
+            header.raw_size = static_cast<std::uint32_t>(raw.size());
+
+            const std::vector<std::uint8_t>* payload = &raw;
+            if (compress) {
+                packed.clear();
+                packbits_compress(raw.data(), raw.size(), packed);
+                if (packed.size() < raw.size()) {
+                    payload = &packed;
+                    header.encoding = 1;
+                }
+            }
+            header.stored_size = static_cast<std::uint32_t>(payload->size());
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(payload->data()), static_cast<std::streamsize>(payload->size()));
+            return static_cast<bool>(file);
+        }
+
+        std::ofstream file;
+        const std::string file_path; ///< for error messages
+        const int keyframe_interval;
+        const bool compress;
+
+        // owned by the simulation thread:
+        std::size_t frames_recorded{0};
+        std::size_t dropped_frames{0};
+        bool need_keyframe{true};
+
+        // owned by the writer thread:
+        std::vector<std::uint8_t> raw; ///< encoded payload of the current frame
+        std::vector<std::uint8_t> packed; ///< compressed payload of the current frame
+
+        // shared, guarded by mutex:
+        std::vector<Frame> slots; ///< all frame slots, never resized after construction
+        std::vector<Frame*> free_slots;
+        std::vector<Frame*> queued; ///< ring buffer of frames waiting for the writer thread, one entry per slot
+        std::size_t queue_head{0};
+        std::size_t queue_size{0};
+        bool stopping{false};
+        bool write_failed{false}; ///< a write to the file failed, set by the writer thread
+        std::mutex mutex;
+        std::condition_variable ready; ///< signals queued frames or a stop request to the writer thread
+        std::thread writer;
+};
+
+/**
+ * @class TrajectoryReader
+ * @brief reads a trajectory file frame by frame and rebuilds the grid of every frame
+ */
+class TrajectoryReader {
+    public:
+        /**
+         * @brief opens a trajectory file and reads its header
+         * @param path file written by TrajectoryWriter
+         * @throws std::runtime_error if the file can't be opened or isn't a trajectory
+         */
+        explicit TrajectoryReader(const std::string& path) : file(path, std::ios::binary) {
+            if (not file.read(reinterpret_cast<char*>(&header), sizeof(header)) or std::memcmp(header.magic, "OCEANTRJ", 8) != 0) {
+                throw std::runtime_error("TrajectoryReader: " + path + " is not an ocean trajectory");
+            }
+            if (header.version != 1 or header.byte_order != 0x01020304) {
+                throw std::runtime_error("TrajectoryReader: " + path + " has an unsupported version or byte order");
+            }
+        }
+
+        /**
+         * @brief reads the next frame and applies it to grid
+         * @param frame receives the header of the frame
+         * @return false at the end of the file
+         * @throws std::runtime_error if the frame is corrupt, or if the file starts with a delta frame
+         */
+        bool next(TrajectoryFrameHeader& frame) {
+            if (not file.read(reinterpret_cast<char*>(&frame), sizeof(frame))) {
+                return false;
+            }
+            stored.resize(frame.stored_size);
+            if (not file.read(reinterpret_cast<char*>(stored.data()), frame.stored_size)) {
+                throw std::runtime_error("TrajectoryReader: truncated frame");
+            }
+            raw.clear();
+            if (frame.encoding == 1) {
+                packbits_decompress(stored.data(), stored.size(), raw);
+            } else {
+                raw = stored;
+            }
+            if (raw.size() != frame.raw_size) {
+                throw std::runtime_error("TrajectoryReader: frame has the wrong size");
+            }
+
+            const std::size_t num_cells = static_cast<std::size_t>(header.num_rows) * static_cast<std::size_t>(header.num_cols);
+            if (frame.type == 0) {
+                if (raw.size() != num_cells) {
+                    throw std::runtime_error("TrajectoryReader: key frame has the wrong size");
+                }
+                grid.assign(raw.begin(), raw.end());
+                return true;
+            }
+            if (grid.empty()) {
+                throw std::runtime_error("TrajectoryReader: delta frame before the first key frame");
+            }
+            std::size_t position = 0;
+            std::uint64_t count = get_varint(raw.data(), raw.size(), position);
+            std::uint64_t cell = 0;
+            for (std::uint64_t k = 0; k < count; ++k) {
+                cell += get_varint(raw.data(), raw.size(), position);
+                if (cell >= num_cells or position >= raw.size()) {
+                    throw std::runtime_error("TrajectoryReader: delta frame is corrupt");
+                }
+                grid[cell] = static_cast<std::int8_t>(raw[position++]);
+            }
+            return true;
+        }
+
+        TrajectoryHeader header{}; ///< header of the file
+        std::vector<std::int8_t> grid; ///< every cell after the last frame read, as Occupy values
+
+    private:
+        std::ifstream file;
+        std::vector<std::uint8_t> stored;
+        std::vector<std::uint8_t> raw;
+};
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Domain Decomposition
+ * @section DomainDecomposition Domain Decomposition
+ * This section runs one ocean on several local processes, so that each of them streams its own part of the grid through its own memory.
+ * The grid is cut into strips of whole rows, one per process (StripPartition). A process keeps its strip and halo_rows rows of each
+ * neighbor strip (Subdomain), and runs the tiled engine's rules on them. Directions are keyed on global cell indices, and the lowest
+ * global source cell wins a contested target, so the result is bit-identical to Ocean for the same seed.
+ * A phase reads the cell next to a mover and settles a contested cell from the proposals around it, so a cell comes out exact when the grid
+ * was exact up to 3 rows away. Each phase thus uses up 3 halo rows per side. With 9 halo rows a whole step runs on local data, and the
+ * processes exchange halos once per step: every process sends its first and last 9 rows to its neighbors. An agent that crosses into a
+ * neighbor's strip is moved by both processes, which compute the same move, and arrives there with the halo.
+ * The halos go through a HaloTransport. ShmTransport passes them through single-producer single-consumer ring buffers in a POSIX
+ * shared-memory segment (ShmDomain). A Subdomain only sends to and receives from its upper and lower neighbor, so a message-passing
+ * transport can take its place, e.g. MPI_Sendrecv with the neighbor ranks of the StripPartition.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @struct StripPartition
+ * @brief splits the rows of a grid into parts strips of nearly equal height, and names the neighbors of every strip
+ */
+struct StripPartition {
+    /// @brief halo rows on each side of a strip: 3 per phase, for the 3 phases of a step
+    static constexpr int halo_rows = 9;
+
+    int num_rows{0}; ///< rows of the grid
+    int num_cols{0}; ///< columns of the grid
+    int parts{1}; ///< number of strips
+    bool periodic{false}; ///< the first and last strip are neighbors
+
+    /**
+     * @brief partitions a grid
+     * @throws std::invalid_argument if there are no parts, or a strip with a neighbor would be lower than halo_rows
+     */
+    StripPartition(int _num_rows, int _num_cols, int _parts, bool _periodic) : num_rows(_num_rows), num_cols(_num_cols), parts(_parts), periodic(_periodic) {
+        if (parts < 1 or num_rows < 1 or num_cols < 1) {
+            throw std::invalid_argument("StripPartition: the grid and the number of parts must be positive");
+        }
+        if ((parts > 1 or periodic) and num_rows / parts < halo_rows) {
+            throw std::invalid_argument("StripPartition: every strip needs at least " + std::to_string(halo_rows) + " rows");
+        }
+    }
+
+    /// @brief first row of strip part
+    int row_begin(int part) const { return static_cast<int>(static_cast<long long>(num_rows) * part / parts); }
+    /// @brief one past the last row of strip part
+    int row_end(int part) const { return row_begin(part + 1); }
+    /// @brief the strip above part, -1 if there is none
+    int upper(int part) const { return part > 0 ? part - 1 : periodic ? parts - 1 : -1; }
+    /// @brief the strip below part, -1 if there is none
+    int lower(int part) const { return part < parts - 1 ? part + 1 : periodic ? 0 : -1; }
+};
+
+/**
+ * @class HaloTransport
+ * @brief moves halo rows between a strip and its upper and lower neighbor
+ * @details every step a strip sends one message to each neighbor and receives one from each, in that order. receive() blocks until the
+ *          message has arrived, send() may block while the neighbor hasn't taken earlier messages.
+ */
+class HaloTransport {
+    public:
+        /// @brief the neighbor a message goes to or comes from
+        enum class Side { Up, Down };
+
+        virtual ~HaloTransport() = default;
+
+        /**
+         * @brief sends rows to the neighbor on side
+         */
+        virtual void send(Side side, std::span<const std::int8_t> rows) = 0;
+
+        /**
+         * @brief receives the rows the neighbor on side sent last, rows.size() bytes
+         */
+        virtual void receive(Side side, std::span<std::int8_t> rows) = 0;
+};
+
+/**
+ * @class Subdomain
+ * @brief one strip of a decomposed ocean with its halos, stepped with the tiled engine's rules
+ * @details the cells of local row r are those of global row row_begin - halo_rows + r, wrapped around under the periodic boundary.
+ *          rows beyond the edges of a non-periodic grid exist locally but stay empty. populations count the strip's own rows only.
+ */
+class Subdomain {
+    public:
+        using Occupy = Ocean::Occupy;
+        using CollisionResult = Ocean::CollisionResult;
+        static constexpr int halo_rows = StripPartition::halo_rows;
+
+        int num_turtle{0}; ///< turtles in the strip
+        int num_trash{0}; ///< trash in the strip
+        int num_ship{0}; ///< ships in the strip
+        std::uint64_t step{0}; ///< number of steps simulated so far, like Ocean::step
+
+        /**
+         * @brief copies strip part and its halos out of an ocean, along with its idle chances, seed, step and boundary
+         * @param partition the partition of the ocean's grid
+         * @param _part the strip this subdomain holds
+         * @param ocean the whole ocean, in any layout
+         */
+        Subdomain(const StripPartition& partition, int _part, const Ocean& ocean)
+            : step(ocean.step), part(_part), upper(partition.upper(_part)), lower(partition.lower(_part)), num_rows(partition.num_rows),
+              num_cols(partition.num_cols), row_begin(partition.row_begin(_part)), row_end(partition.row_end(_part)),
+              local_rows(row_end - row_begin + 2 * halo_rows), periodic(ocean.boundary == Ocean::Boundary::Periodic),
+              absorbing(ocean.boundary == Ocean::Boundary::Absorbing), idle_chances{ocean.turtle_idle_chance, ocean.trash_idle_chance, ocean.ship_idle_chance},
+              rng(ocean.rng) {
+            const std::size_t local_cells = static_cast<std::size_t>(local_rows) * num_cols;
+            cells.assign(local_cells, static_cast<std::int8_t>(Occupy::Empty));
+            proposals.assign(local_cells, 0);
+            movers.reserve(local_cells);
+            keys.reserve(local_cells);
+            directions.reserve(local_cells);
+            for (int r = 0; r < local_rows; ++r) {
+                const int row = global_row(r);
+                if (row < 0) {
+                    continue;
+                }
+                for (int j = 0; j < num_cols; ++j) {
+                    cells[static_cast<std::size_t>(r) * num_cols + j] = static_cast<std::int8_t>(ocean.grid.get(static_cast<std::size_t>(row) * num_cols + j));
+                }
+            }
+            for (int cell = halo_rows * num_cols; cell < (local_rows - halo_rows) * num_cols; ++cell) {
+                num_turtle += cells[cell] == static_cast<std::int8_t>(Occupy::Turtle);
+                num_trash += cells[cell] == static_cast<std::int8_t>(Occupy::Trash);
+                num_ship += cells[cell] == static_cast<std::int8_t>(Occupy::Ship);
+            }
+        }
+
+        /**
+         * @brief updates the strip by one step, ships, then turtles, then trash, and exchanges the halos for the next one
+         * @param transport the halo transport of this strip
+         */
+        void update_grid(HaloTransport& transport) {
+            move_phase<Occupy::Ship>(0);
+            move_phase<Occupy::Turtle>(1);
+            move_phase<Occupy::Trash>(2);
+            step++;
+            exchange_halos(transport);
+        }
+
+        /**
+         * @brief copies the strip's own rows into a whole grid
+         * @param grid num_rows x num_cols cells, row-major
+         */
+        void copy_rows(std::int8_t* grid) const {
+            std::memcpy(grid + static_cast<std::size_t>(row_begin) * num_cols, cells.data() + static_cast<std::size_t>(halo_rows) * num_cols,
+                        static_cast<std::size_t>(row_end - row_begin) * num_cols);
+        }
+
+    private:
+        /**
+         * @brief the strip as Ocean's rules see it, see Ocean::propose_rule(): local cells, ordered by their global index
+         * @tparam Self Subdomain, const for the propose and winner rules
+         */
+        template <class Self>
+        struct View {
+            Self& domain; ///< the strip viewed
+
+            int target(int cell, int dir) const {
+                return domain.neighbor(cell / domain.num_cols, cell % domain.num_cols, Ocean::direction_rows[dir], Ocean::direction_cols[dir]);
+            }
+            int winner(int target) const { return domain.move_winner(target); }
+            int object(int cell) const { return domain.cells[cell]; }
+            void set(int cell, int value) const { domain.cells[cell] = static_cast<std::int8_t>(value); }
+            bool absorbing() const { return domain.absorbing; }
+            std::int8_t proposal(int cell) const { return domain.proposals[cell]; }
+            int key(int cell) const { return domain.global_cell(cell); }
+        };
+
+        /**
+         * @brief the global row of local row r, -1 beyond the edges of a non-periodic grid
+         */
+        int global_row(int r) const {
+            int row = row_begin - halo_rows + r;
+            if (periodic) {
+                return (row % num_rows + num_rows) % num_rows;
+            }
+            return row >= 0 and row < num_rows ? row : -1;
+        }
+
+        /**
+         * @brief global index of a local cell, which keys its random numbers and orders it in move_winner()
+         */
+        int global_cell(int cell) const {
+            return global_row(cell / num_cols) * num_cols + cell % num_cols;
+        }
+
+        /**
+         * @brief the local cell a move from local (r, j) lands on, -1 if it leaves the grid, see Ocean::neighbor()
+         * @details only called for rows at least one row inside the local grid
+         */
+        int neighbor(int r, int j, int row_offset, int col_offset) const {
+            const int row = row_begin - halo_rows + r + row_offset;
+            if (not periodic and (row < 0 or row >= num_rows)) {
+                return -1;
+            }
+            int new_j = j + col_offset;
+            if (new_j < 0 or new_j >= num_cols) {
+                if (not periodic) {
+                    return -1;
+                }
+                new_j = new_j < 0 ? num_cols - 1 : 0;
+            }
+            return (r + row_offset) * num_cols + new_j;
+        }
+
+        /**
+         * @brief proposal of one agent, Ocean::propose_rule() on the strip
+         */
+        template <Occupy Species>
+        std::int8_t propose_move(int cell, int dir) const {
+            return Ocean::propose_rule<Species>(View<const Subdomain>{*this}, dir, [&](int d) {
+                return neighbor(cell / num_cols, cell % num_cols, Ocean::direction_rows[d], Ocean::direction_cols[d]);
+            });
+        }
+
+        /**
+         * @brief the local source with the lowest global index proposing a Move into target, -1 if there is none, Ocean::winner_rule() on the strip
+         */
+        int move_winner(int target) const {
+            const int r = target / num_cols;
+            const int j = target % num_cols;
+            return Ocean::winner_rule(View<const Subdomain>{*this}, [&](int dir) { return neighbor(r, j, -Ocean::direction_rows[dir], -Ocean::direction_cols[dir]); });
+        }
+
+        /**
+         * @brief moves every agent of one species, see Tiled Grid Update
+         * @param phase 0, 1 or 2: the local rows that are still exact shrink by 3 per side with every phase
+         * @details agents are proposed one row inside the exact rows, and resolved two rows inside, so the cells three rows inside come out exact
+         */
+        template <Occupy Species>
+        void move_phase(int phase) {
+            constexpr std::int8_t species = static_cast<std::int8_t>(Species);
+            const int exact_begin = 3 * phase;
+            const int exact_end = local_rows - 3 * phase;
+            movers.clear();
+            keys.clear();
+            for (int r = exact_begin + 1; r < exact_end - 1; ++r) {
+                // rows beyond the edges of the grid hold no agents:
+                const int key_offset = (global_row(r) - r) * num_cols;
+                for (int cell = r * num_cols; cell < (r + 1) * num_cols; ++cell) {
+                    if (cells[cell] == species) {
+                        movers.push_back(cell);
+                        keys.push_back(cell + key_offset);
+                    }
+                }
+            }
+            directions.resize(movers.size());
+            rng.fill_directions(step, static_cast<std::uint32_t>(Species), keys.data(), keys.size(), idle_chances[static_cast<int>(Species)], directions.data());
+            for (std::size_t k = 0; k < movers.size(); ++k) {
+                proposals[movers[k]] = propose_move<Species>(movers[k], directions[k]);
+            }
+
+            const int own_begin = halo_rows * num_cols;
+            const int own_end = (local_rows - halo_rows) * num_cols;
+            const View<Subdomain> view{*this};
+            int removed[3]{0, 0, 0};
+            for (int cell : movers) {
+                const std::int8_t code = proposals[cell];
+                if (code == 0 or cell < (exact_begin + 2) * num_cols or cell >= (exact_end - 2) * num_cols) {
+                    continue;
+                }
+                const Ocean::Resolution<int> resolved = Ocean::resolve_rule<Species>(view, cell, code);
+                if (resolved.outcome == CollisionResult::Die) {
+                    removed[static_cast<int>(Species)] += cell >= own_begin and cell < own_end;
+                } else if (resolved.outcome == CollisionResult::Move and resolved.replaced != static_cast<int>(Occupy::Empty)) {
+                    removed[resolved.replaced] += resolved.target >= own_begin and resolved.target < own_end;
+                }
+            }
+            for (int cell : movers) {
+                proposals[cell] = 0;
+            }
+            num_turtle -= removed[static_cast<int>(Occupy::Turtle)];
+            num_trash -= removed[static_cast<int>(Occupy::Trash)];
+            num_ship -= removed[static_cast<int>(Occupy::Ship)];
+        }
+
+        /**
+         * @brief sends the first and last halo_rows own rows to the neighbors, and replaces the halos with theirs
+         */
+        void exchange_halos(HaloTransport& transport) {
+            const std::size_t halo_cells = static_cast<std::size_t>(halo_rows) * num_cols;
+            std::int8_t* local = cells.data();
+            if (upper >= 0) {
+                transport.send(HaloTransport::Side::Up, {local + halo_cells, halo_cells});
+            }
+            if (lower >= 0) {
+                transport.send(HaloTransport::Side::Down, {local + cells.size() - 2 * halo_cells, halo_cells});
+            }
+            if (upper >= 0) {
+                transport.receive(HaloTransport::Side::Up, {local, halo_cells});
+            }
+            if (lower >= 0) {
+                transport.receive(HaloTransport::Side::Down, {local + cells.size() - halo_cells, halo_cells});
+            }
+        }
+
+        int part; ///< the strip of the partition
+        int upper; ///< strip above, -1 if none
+        int lower; ///< strip below, -1 if none
+        int num_rows; ///< rows of the whole grid
+        int num_cols; ///< columns of the grid and the strip
+        int row_begin; ///< first own row, global
+        int row_end; ///< one past the last own row, global
+        int local_rows; ///< own rows and halo rows
+        bool periodic;
+        bool absorbing;
+        std::array<float, 3> idle_chances; ///< idle chances indexed by Occupy
+        CounterRng rng; ///< random numbers, keyed like Ocean::rng
+        std::vector<std::int8_t> cells; ///< own and halo cells, row-major
+        std::vector<std::int8_t> proposals; ///< pending move of every local cell in the current phase
+        std::vector<int> movers; ///< local cells of the moving species
+        std::vector<int> keys; ///< global cells of the movers
+        std::vector<std::int8_t> directions; ///< direction drawn for each of the movers
+};
+
+/**
+ * @class ShmDomain
+ * @brief a POSIX shared-memory segment with the halo ring buffers of every strip and room for the gathered grid
+ * @details the segment is unlinked as soon as it is mapped, so it is only shared with processes forked afterwards and goes away with them.
+ *          every strip has a ring towards each neighbor, with slots messages of halo_rows rows, so a strip can run slots steps ahead of
+ *          a slow neighbor before send() waits. a process that fails calls fail(), which makes every wait in the other processes throw.
+ */
+class ShmDomain {
+    public:
+        /**
+         * @brief what a strip reports back after its run
+         */
+        struct PartResult {
+            int population[3]{0, 0, 0}; ///< turtles, trash and ships in the strip, indexed by Occupy
+            double seconds{0.}; ///< time of the step loop
+        };
+
+        /**
+         * @brief creates and maps the segment
+         * @param _partition the partition whose strips exchange halos through the segment
+         * @param _slots messages a ring holds, at least 1
+         * @throws std::runtime_error if the segment can't be created or mapped
+         */
+        explicit ShmDomain(const StripPartition& _partition, int _slots = 4)
+            : partition(_partition), slots(std::max(1, _slots)),
+              message_bytes(round_up(static_cast<std::size_t>(StripPartition::halo_rows) * partition.num_cols)) {
+            static_assert(std::atomic<std::uint64_t>::is_always_lock_free and std::atomic<int>::is_always_lock_free, "shared memory needs lock-free atomics");
+            ring_bytes = sizeof(Ring) + slots * message_bytes;
+            rings_offset = round_up(sizeof(Control));
+            grid_offset = rings_offset + 2 * static_cast<std::size_t>(partition.parts) * ring_bytes;
+            results_offset = round_up(grid_offset + static_cast<std::size_t>(partition.num_rows) * partition.num_cols);
+            size = results_offset + partition.parts * sizeof(PartResult);
+
+            const std::string name = "/ocean-" + std::to_string(::getpid()) + "-" + std::to_string(reinterpret_cast<std::uintptr_t>(this));
+            const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd < 0) {
+                throw std::runtime_error("ShmDomain: can't create " + name + ": " + std::strerror(errno));
+            }
+            ::shm_unlink(name.c_str());
+            if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                const int error = errno;
+                ::close(fd);
+                throw std::runtime_error("ShmDomain: can't size the segment: " + std::string(std::strerror(error)));
+            }
+            void* mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (mapped == MAP_FAILED) {
+                throw std::runtime_error("ShmDomain: can't map the segment: " + std::string(std::strerror(errno)));
+            }
+            base = static_cast<std::byte*>(mapped);
+            // the segment starts out zeroed, the atomics are constructed in place:
+            new (base) Control{};
+            for (int ring = 0; ring < 2 * partition.parts; ++ring) {
+                new (base + rings_offset + ring * ring_bytes) Ring{};
+            }
+            for (int p = 0; p < partition.parts; ++p) {
+                new (base + results_offset + p * sizeof(PartResult)) PartResult{};
+            }
+        }
+
+        ShmDomain(const ShmDomain&) = delete;
+        ShmDomain& operator=(const ShmDomain&) = delete;
+
+        ~ShmDomain() {
+            ::munmap(base, size);
+        }
+
+        /**
+         * @brief writes a message to the ring of strip part towards side, waiting while the ring is full
+         */
+        void push(int part, HaloTransport::Side side, std::span<const std::int8_t> message) {
+            Ring& queue = ring(part, side);
+            const std::uint64_t head = queue.head.load(std::memory_order_relaxed);
+            wait([&] { return head - queue.tail.load(std::memory_order_acquire) < slots; });
+            std::memcpy(data(queue) + (head % slots) * message_bytes, message.data(), std::min(message.size(), message_bytes));
+            queue.head.store(head + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief takes the oldest message off the ring of strip part towards side, waiting while the ring is empty
+         */
+        void pop(int part, HaloTransport::Side side, std::span<std::int8_t> message) {
+            Ring& queue = ring(part, side);
+            const std::uint64_t tail = queue.tail.load(std::memory_order_relaxed);
+            wait([&] { return queue.head.load(std::memory_order_acquire) != tail; });
+            std::memcpy(message.data(), data(queue) + (tail % slots) * message_bytes, std::min(message.size(), message_bytes));
+            queue.tail.store(tail + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief waits until every strip has called arrive(), so the step loops start together
+         */
+        void arrive() {
+            control().arrived.fetch_add(1, std::memory_order_acq_rel);
+            wait([&] { return control().arrived.load(std::memory_order_acquire) >= partition.parts; });
+        }
+
+        /// @brief makes every current and later wait throw
+        void fail() { control().failed.store(1, std::memory_order_release); }
+
+        /// @brief the gathered grid, num_rows x num_cols cells
+        std::int8_t* grid() { return reinterpret_cast<std::int8_t*>(base + grid_offset); }
+
+        /// @brief the report of strip part
+        PartResult& result(int part) { return *reinterpret_cast<PartResult*>(base + results_offset + part * sizeof(PartResult)); }
+
+        const StripPartition partition;
+
+    private:
+        struct Control {
+            std::atomic<int> arrived{0}; ///< strips that reached the start of the step loop
+            std::atomic<int> failed{0}; ///< set by a failed process
+        };
+
+        /// @brief head and tail of a ring on separate cache lines, followed by its message slots
+        struct Ring {
+            alignas(64) std::atomic<std::uint64_t> head{0}; ///< messages written, only the sender writes it
+            alignas(64) std::atomic<std::uint64_t> tail{0}; ///< messages read, only the receiver writes it
+        };
+
+        static std::size_t round_up(std::size_t bytes) { return (bytes + 63) / 64 * 64; }
+
+        Control& control() { return *reinterpret_cast<Control*>(base); }
+
+        Ring& ring(int part, HaloTransport::Side side) {
+            return *reinterpret_cast<Ring*>(base + rings_offset + (2 * static_cast<std::size_t>(part) + static_cast<int>(side)) * ring_bytes);
+        }
+
+        std::byte* data(Ring& queue) { return reinterpret_cast<std::byte*>(&queue) + sizeof(Ring); }
+
+        /**
+         * @brief spins, then yields, until ready() holds
+         * @throws std::runtime_error if another process failed
+         */
+        template <class Ready>
+        void wait(Ready&& ready) {
+            for (int spin = 0; not ready(); ++spin) {
+                if (control().failed.load(std::memory_order_acquire)) {
+                    throw std::runtime_error("ShmDomain: another process failed");
+                }
+                if (spin > 64) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        const std::size_t slots;
+        const std::size_t message_bytes; ///< one halo, rounded up to a cache line
+        std::size_t ring_bytes{0};
+        std::size_t rings_offset{0};
+        std::size_t grid_offset{0};
+        std::size_t results_offset{0};
+        std::size_t size{0};
+        std::byte* base{nullptr};
+};
+
+/**
+ * @class ShmTransport
+ * @brief the HaloTransport of one strip over the rings of a ShmDomain
+ * @details a strip sends on its own rings, and receives on the ring its upper neighbor sends down and the ring its lower neighbor sends up
+ */
+class ShmTransport : public HaloTransport {
+    public:
+        ShmTransport(ShmDomain& _domain, int _part) : domain(_domain), part(_part) {}
+
+        void send(Side side, std::span<const std::int8_t> rows) override {
+            domain.push(part, side, rows);
+        }
+
+        void receive(Side side, std::span<std::int8_t> rows) override {
+            if (side == Side::Up) {
+                domain.pop(domain.partition.upper(part), Side::Down, rows);
+            } else {
+                domain.pop(domain.partition.lower(part), Side::Up, rows);
+            }
+        }
+
+    private:
+        ShmDomain& domain;
+        int part;
+};
+
+/**
+ * @struct DecomposedRun
+ * @brief the outcome of run_decomposed()
+ */
+struct DecomposedRun {
+    std::vector<std::int8_t> grid; ///< every cell after the run, row-major
+    std::array<int, 3> population{}; ///< turtles, trash and ships after the run
+    double seconds{0.}; ///< step loop time of the slowest process
+};
+
+/**
+ * @brief runs an ocean for a number of steps on processes forked processes, one strip each, and gathers the grid
+ * @param ocean the ocean to start from, left as it is. its boundary, idle chances, seed and step carry over
+ * @param processes number of processes and strips
+ * @param steps number of steps
+ * @return the gathered grid and populations, bit-identical to stepping ocean itself
+ * @throws std::invalid_argument if the grid is too low for processes strips, std::runtime_error if a process fails
+ * @details the processes are forked from the caller, so they start with its memory and only touch their own strip afterwards,
+ *          which puts the strips' pages on the nodes the processes run on. they write their rows and populations into the segment and exit.
+ */
+inline DecomposedRun run_decomposed(const Ocean& ocean, int processes, int steps) {
+    StripPartition partition(ocean.num_rows, ocean.num_cols, processes, ocean.boundary == Ocean::Boundary::Periodic);
+    ShmDomain domain(partition);
+    // what the caller buffered would be written again by every child:
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector<pid_t> children;
+    for (int part = 0; part < processes; ++part) {
+        const pid_t child = ::fork();
+        if (child == 0) {
+            int status = EXIT_SUCCESS;
+            try {
+                Subdomain strip(partition, part, ocean);
+                ShmTransport transport(domain, part);
+                domain.arrive();
+                const auto start = std::chrono::steady_clock::now();
+                for (int t = 0; t < steps; ++t) {
+                    strip.update_grid(transport);
+                }
+                ShmDomain::PartResult& result = domain.result(part);
+                result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                result.population[static_cast<int>(Ocean::Occupy::Turtle)] = strip.num_turtle;
+                result.population[static_cast<int>(Ocean::Occupy::Trash)] = strip.num_trash;
+                result.population[static_cast<int>(Ocean::Occupy::Ship)] = strip.num_ship;
+                strip.copy_rows(domain.grid());
+            } catch (const std::exception& error) {
+                std::fprintf(stderr, "strip %d: %s\n", part, error.what());
+                domain.fail();
+                status = EXIT_FAILURE;
+            }
+            // skip the caller's exit handlers and destructors, they belong to the parent:
+            ::_exit(status);
+        }
+        if (child < 0) {
+            domain.fail();
+            break;
+        }
+        children.push_back(child);
+    }
+    bool failed = static_cast<int>(children.size()) < processes;
+    for (std::size_t reaped = 0; reaped < children.size(); ++reaped) {
+        int status = 0;
+        if (::waitpid(-1, &status, 0) < 0 or not WIFEXITED(status) or WEXITSTATUS(status) != EXIT_SUCCESS) {
+            // unblock the others, they would wait for this one forever:
+            domain.fail();
+            failed = true;
+        }
+    }
+    if (failed) {
+        throw std::runtime_error("run_decomposed: a process failed");
+    }
+
+    DecomposedRun run;
+    run.grid.assign(domain.grid(), domain.grid() + static_cast<std::size_t>(ocean.num_rows) * ocean.num_cols);
+    for (int part = 0; part < processes; ++part) {
+        for (int species = 0; species < 3; ++species) {
+            run.population[species] += domain.result(part).population[species];
+        }
+        run.seconds = std::max(run.seconds, domain.result(part).seconds);
+    }
+    return run;
+}
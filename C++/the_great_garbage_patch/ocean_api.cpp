@@ -0,0 +1,146 @@
+/**
+ * @authors Jiwoong "Alex" Choi
+ * @date 2024.12.11
+ * @file ocean_api.cpp
+ * @brief libocean: the C API of ocean_api.h over the Ocean class
+ */
+#include "ocean_api.h"
+#include "ocean.hpp"
+
+/**
+ * @brief one simulation behind an ocean_t handle
+ * @details the pool is declared first so it outlives the ocean that runs on it
+ */
+struct ocean {
+    ThreadPool pool; ///< threads that place and update the grid
+    Ocean simulation; ///< the simulation, always in the Byte layout so ocean_grid() can hand out its cells
+    int turtles; ///< initial populations, placed again by every ocean_seed()
+    int trash;
+    int ships;
+
+    ocean(int rows, int cols, int _turtles, int _trash, int _ships, int threads)
+        : pool(threads), simulation(rows, cols, _turtles, _trash, _ships, GridLayout::Byte), turtles(_turtles), trash(_trash), ships(_ships) {
+        simulation.set_thread_pool(&pool);
+    }
+};
+
+namespace {
+
+/// @brief message of the last failure on this thread, see ocean_last_error()
+thread_local std::string last_error;
+
+/**
+ * @brief runs body, turning exceptions into ocean_status codes and remembering their message
+ */
+template <class F>
+int guarded(F&& body) {
+    try {
+        body();
+        last_error.clear();
+        return OCEAN_OK;
+    } catch (const std::invalid_argument& error) {
+        last_error = error.what();
+        return OCEAN_INVALID_ARGUMENT;
+    } catch (const std::exception& error) {
+        last_error = error.what();
+        return OCEAN_ERROR;
+    } catch (...) {
+        last_error = "unknown error";
+        return OCEAN_ERROR;
+    }
+}
+
+/// @brief throws std::invalid_argument for a null handle
+void require(const ocean_t* ocean) {
+    if (ocean == nullptr) {
+        throw std::invalid_argument("ocean handle is null");
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+int ocean_api_version(void) {
+    return OCEAN_API_VERSION;
+}
+
+const char* ocean_last_error(void) {
+    return last_error.c_str();
+}
+
+ocean_t* ocean_create(int rows, int cols, int turtles, int trash, int ships, int threads) {
+    ocean_t* created = nullptr;
+    guarded([&] {
+        if (rows <= 0 or cols <= 0 or static_cast<long long>(rows) * cols > INT_MAX) {
+            throw std::invalid_argument("rows and cols must be positive and rows * cols must fit an int");
+        }
+        if (turtles < 0 or trash < 0 or ships < 0 or threads <= 0) {
+            throw std::invalid_argument("populations must be non-negative and threads positive");
+        }
+        created = new ocean(rows, cols, turtles, trash, ships, threads);
+        // no agents until ocean_seed():
+        created->simulation.num_turtle = 0;
+        created->simulation.num_trash = 0;
+        created->simulation.num_ship = 0;
+    });
+    return created;
+}
+
+int ocean_seed(ocean_t* ocean, uint64_t seed) {
+    return guarded([&] {
+        require(ocean);
+        Ocean& simulation = ocean->simulation;
+        simulation.num_turtle = ocean->turtles;
+        simulation.num_trash = ocean->trash;
+        simulation.num_ship = ocean->ships;
+        // the command line seeds the shared engine before the Ocean constructor draws from it, skip that draw to place the same grid:
+        seed_random(static_cast<unsigned int>(seed));
+        random_engine().discard(1);
+        simulation.set_dummy_grid();
+        simulation.seed(seed);
+        simulation.step = 0;
+    });
+}
+
+int ocean_step(ocean_t* ocean, int steps) {
+    return guarded([&] {
+        require(ocean);
+        if (steps < 0) {
+            throw std::invalid_argument("steps must be non-negative");
+        }
+        for (int t = 0; t < steps; ++t) {
+            ocean->simulation.update_grid();
+        }
+    });
+}
+
+int ocean_population(const ocean_t* ocean, int* turtles, int* trash, int* ships) {
+    return guarded([&] {
+        require(ocean);
+        if (turtles != nullptr) *turtles = ocean->simulation.num_turtle;
+        if (trash != nullptr) *trash = ocean->simulation.num_trash;
+        if (ships != nullptr) *ships = ocean->simulation.num_ship;
+    });
+}
+
+uint64_t ocean_steps(const ocean_t* ocean) {
+    return ocean != nullptr ? ocean->simulation.step : 0;
+}
+
+const int8_t* ocean_grid(const ocean_t* ocean, int* rows, int* cols) {
+    const int8_t* cells = nullptr;
+    guarded([&] {
+        require(ocean);
+        if (rows != nullptr) *rows = ocean->simulation.num_rows;
+        if (cols != nullptr) *cols = ocean->simulation.num_cols;
+        cells = std::get<ByteGrid>(ocean->simulation.grid.cells).cells.data();
+    });
+    return cells;
+}
+
+void ocean_destroy(ocean_t* ocean) {
+    delete ocean;
+}
+
+}
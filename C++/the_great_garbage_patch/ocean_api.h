@@ -0,0 +1,106 @@
+/**
+ * @authors Jiwoong "Alex" Choi
+ * @date 2024.12.11
+ * @file ocean_api.h
+ * @brief C API of libocean, the ocean simulation as an embeddable library
+ * @details a stable C interface over the Ocean class of ocean.hpp, for hosts that can't use C++ directly, such as Python through ctypes.
+ *          every function catches the C++ exceptions it may raise and reports them through its return value and ocean_last_error().
+ *          an ocean handle may be used from one thread at a time; different handles are independent.
+ */
+#ifndef OCEAN_API_H
+#define OCEAN_API_H
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define OCEAN_API __declspec(dllexport)
+#else
+#define OCEAN_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief version of this interface, bumped on every incompatible change
+#define OCEAN_API_VERSION 1
+
+/// @brief opaque handle of one simulation and the threads that update it
+typedef struct ocean ocean_t;
+
+/// @brief return codes, negative on failure
+enum ocean_status {
+    OCEAN_OK = 0, ///< success
+    OCEAN_INVALID_ARGUMENT = -1, ///< a null handle or an argument out of range
+    OCEAN_ERROR = -2 ///< any other failure, such as running out of memory
+};
+
+/// @brief cell values of the grid returned by ocean_grid()
+enum ocean_cell {
+    OCEAN_EMPTY = -1,
+    OCEAN_TURTLE = 0,
+    OCEAN_TRASH = 1,
+    OCEAN_SHIP = 2
+};
+
+/**
+ * @brief version of the interface the library was built with, compare with OCEAN_API_VERSION
+ */
+OCEAN_API int ocean_api_version(void);
+
+/**
+ * @brief message of the last failure on the calling thread, empty if there was none
+ * @return a string owned by the library, valid until the next call on the same thread
+ */
+OCEAN_API const char* ocean_last_error(void);
+
+/**
+ * @brief creates an ocean of rows x cols cells with an empty grid, call ocean_seed() to place the agents
+ * @param turtles, trash, ships initial populations, clamped to the number of cells
+ * @param threads threads that update the grid, 1 runs everything on the calling thread
+ * @return the handle, or NULL on failure
+ */
+OCEAN_API ocean_t* ocean_create(int rows, int cols, int turtles, int trash, int ships, int threads);
+
+/**
+ * @brief places a fresh initial grid and restarts the step loop at step 0
+ * @param seed the same seed gives the same run as `ocean --seed` with the same sizes and populations
+ * @return OCEAN_OK or a negative ocean_status
+ */
+OCEAN_API int ocean_seed(ocean_t* ocean, uint64_t seed);
+
+/**
+ * @brief simulates steps steps
+ * @return OCEAN_OK or a negative ocean_status
+ */
+OCEAN_API int ocean_step(ocean_t* ocean, int steps);
+
+/**
+ * @brief current populations, any of the pointers may be NULL
+ * @return OCEAN_OK or a negative ocean_status
+ */
+OCEAN_API int ocean_population(const ocean_t* ocean, int* turtles, int* trash, int* ships);
+
+/**
+ * @brief number of steps simulated since the last ocean_seed()
+ */
+OCEAN_API uint64_t ocean_steps(const ocean_t* ocean);
+
+/**
+ * @brief the grid as rows x cols row-major int8_t cells holding ocean_cell values
+ * @param rows, cols receive the grid size, may be NULL
+ * @return pointer to the cells, or NULL on failure. it stays valid and is updated in place until ocean_destroy()
+ * @details the cells must not be written, the engines keep state derived from them
+ */
+OCEAN_API const int8_t* ocean_grid(const ocean_t* ocean, int* rows, int* cols);
+
+/**
+ * @brief destroys an ocean and joins its threads, NULL is ignored
+ */
+OCEAN_API void ocean_destroy(ocean_t* ocean);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,582 @@
+/**
+ * @authors Jiwoong "Alex" Choi
+ * @date 2024.12.11
+ * @file ocean_bench.cpp
+ * @brief microbenchmarks of the ocean kernels: update_grid, move/collision and population
+ * @details every benchmark runs over a grid of cases (grid size x occupancy density x species mix x engine x layout)
+ *          and prints one machine-readable row per case, as CSV or JSON Lines, so runs of different builds can be compared.
+ */
+#include "ocean.hpp"
+
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Benchmark Cases
+ * @section BenchmarkCases Benchmark Cases
+ * This section contains the setup of one benchmark case and the oceans it runs on.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @brief relative amounts of turtles, trash and ships among the occupied cells, e.g. 12:25:1
+ */
+struct SpeciesMix {
+    double turtle{12.}; ///< share of turtles
+    double trash{25.}; ///< share of trash
+    double ship{1.}; ///< share of ships
+    std::string name{"12:25:1"}; ///< the mix as given on the command line
+};
+
+/**
+ * @brief one benchmark case
+ */
+struct BenchCase {
+    int size{64}; ///< edge length of the square grid
+    double density{0.01}; ///< fraction of occupied cells
+    SpeciesMix mix; ///< species of the occupied cells
+    Ocean::Engine engine{Ocean::Engine::Tiled}; ///< engine of update_grid
+    GridLayout layout{GridLayout::Byte}; ///< grid layout
+    SimdLevel simd{supported_simd_level()}; ///< vector kernel of the tiled engine
+};
+
+/**
+ * @brief result of one benchmark run
+ */
+struct BenchResult {
+    std::string benchmark; ///< name of the benchmark
+    BenchCase setup; ///< case that was run
+    int threads{1}; ///< threads of the pool
+    long long agents{0}; ///< agents on the grid at the start
+    long long iterations{0}; ///< timed steps or kernel passes
+    double seconds{0.}; ///< wall-clock time of the timed iterations
+    double ns_per_agent_move{-1.}; ///< nanoseconds per agent move, negative if the benchmark has no moves
+    double cells_per_sec{-1.}; ///< cells processed per second, negative if the benchmark doesn't scan cells
+    double allocations_per_step{0.}; ///< heap allocations per timed iteration
+};
+
+/**
+ * @brief builds the ocean of a case: every cell is occupied with chance density, by a species drawn from the mix
+ * @param setup the case
+ * @param seed seed of the grid and the step loop
+ */
+Ocean make_ocean(const BenchCase& setup, std::uint64_t seed) {
+    seed_random(static_cast<unsigned int>(seed));
+    Ocean ocean(setup.size, setup.size, 0, 0, 0);
+    const double total = setup.mix.turtle + setup.mix.trash + setup.mix.ship;
+    const double turtle_share = setup.density * setup.mix.turtle / total;
+    const double trash_share = setup.density * (setup.mix.turtle + setup.mix.trash) / total;
+    ocean.grid.visit([&](auto& cells) {
+        for (int cell = 0; cell < ocean.num_cells; ++cell) {
+            double r = random_float();
+            Ocean::Occupy object = r < turtle_share ? Ocean::Occupy::Turtle
+                                 : r < trash_share ? Ocean::Occupy::Trash
+                                 : r < setup.density ? Ocean::Occupy::Ship
+                                 : Ocean::Occupy::Empty;
+            cells.set(cell, static_cast<int>(object));
+        }
+    });
+    ocean.invalidate_agents();
+    auto [turtles, trash, ships] = ocean.population(ocean.grid);
+    ocean.num_turtle = turtles;
+    ocean.num_trash = trash;
+    ocean.num_ship = ships;
+    ocean.seed(seed);
+    ocean.set_engine(setup.engine);
+    ocean.set_simd(setup.simd);
+    ocean.set_grid_layout(setup.layout);
+    return ocean;
+}
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Benchmarks
+ * @section Benchmarks Benchmarks
+ * Every benchmark runs one untimed warm-up iteration, then times iterations until min_seconds have passed or max_iterations are done.
+ * ***********************************************************************************************************************************************************************
+ */
+/// @brief results of the timed kernels are written here, so the compiler can't drop the calls
+volatile long long benchmark_sink = 0;
+
+/**
+ * @brief limits of the timed loop of every benchmark
+ */
+struct BenchLimits {
+    double min_seconds{0.2}; ///< stop after this much time
+    long long max_iterations{1000}; ///< or after this many iterations
+};
+
+/**
+ * @brief the timed loop of every benchmark: runs pass until limits are reached
+ * @param limits time and iteration limits
+ * @param pass one timed iteration, the warm-up is up to the caller
+ * @param result gets iterations, seconds and allocations_per_step
+ */
+template <typename Pass>
+void time_iterations(const BenchLimits& limits, Pass&& pass, BenchResult& result) {
+    const std::size_t allocations_before = allocation_count();
+    const auto start = std::chrono::steady_clock::now();
+    do {
+        pass();
+        result.iterations++;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (result.seconds < limits.min_seconds and result.iterations < limits.max_iterations);
+    const std::size_t allocations = allocation_count() - allocations_before;
+    result.allocations_per_step = static_cast<double>(allocations) / static_cast<double>(result.iterations);
+}
+
+/**
+ * @brief times update_grid(): ns per agent move, cells per second and allocations per step
+ */
+BenchResult bench_update_grid(const BenchCase& setup, ThreadPool& pool, const BenchLimits& limits, std::uint64_t seed) {
+    Ocean ocean = make_ocean(setup, seed);
+    ocean.set_thread_pool(&pool);
+    BenchResult result{"update_grid", setup, pool.size()};
+    result.agents = static_cast<long long>(ocean.num_turtle) + ocean.num_trash + ocean.num_ship;
+
+    // warm-up step, sizes the scratch buffers:
+    ocean.update_grid();
+
+    long long agent_moves = 0;
+    time_iterations(limits, [&] {
+        // every agent on the grid at the start of the step makes one move:
+        agent_moves += static_cast<long long>(ocean.num_turtle) + ocean.num_trash + ocean.num_ship;
+        ocean.update_grid();
+    }, result);
+
+    result.ns_per_agent_move = agent_moves > 0 ? result.seconds * 1e9 / static_cast<double>(agent_moves) : 0.;
+    result.cells_per_sec = static_cast<double>(result.iterations) * ocean.num_cells / result.seconds;
+    return result;
+}
+
+/**
+ * @brief times FixedOcean<Size, Size>::update_grid(), the compile-time-sized counterpart of update_grid with the tiled engine on one thread
+ */
+template <int Size>
+BenchResult bench_fixed_size(const BenchCase& setup, const BenchLimits& limits, std::uint64_t seed) {
+    auto ocean = std::make_unique<FixedOcean<Size, Size>>(make_ocean(setup, seed));
+    BenchResult result{"update_grid_fixed", setup, 1};
+    result.agents = static_cast<long long>(ocean->num_turtle) + ocean->num_trash + ocean->num_ship;
+    ocean->update_grid();
+
+    long long agent_moves = 0;
+    time_iterations(limits, [&] {
+        agent_moves += static_cast<long long>(ocean->num_turtle) + ocean->num_trash + ocean->num_ship;
+        ocean->update_grid();
+    }, result);
+
+    result.ns_per_agent_move = agent_moves > 0 ? result.seconds * 1e9 / static_cast<double>(agent_moves) : 0.;
+    result.cells_per_sec = static_cast<double>(result.iterations) * Size * Size / result.seconds;
+    benchmark_sink = ocean->cells[0];
+    return result;
+}
+
+/**
+ * @brief update_grid_fixed for the grid sizes compiled in: 64, 256, 1024 and 4096
+ * @return the result, or nullopt for any other size
+ */
+optional<BenchResult> bench_update_grid_fixed(const BenchCase& setup, const BenchLimits& limits, std::uint64_t seed) {
+    switch (setup.size) {
+        case 64: return bench_fixed_size<64>(setup, limits, seed);
+        case 256: return bench_fixed_size<256>(setup, limits, seed);
+        case 1024: return bench_fixed_size<1024>(setup, limits, seed);
+        case 4096: return bench_fixed_size<4096>(setup, limits, seed);
+        default: return nullopt;
+    }
+}
+
+/**
+ * @brief times Ocean::move() and with it collision(): one call per agent with a fixed, pre-drawn direction
+ */
+BenchResult bench_move(const BenchCase& setup, const BenchLimits& limits, std::uint64_t seed) {
+    Ocean ocean = make_ocean(setup, seed);
+    BenchResult result{"move", setup, 1};
+
+    std::vector<int> agents;
+    std::vector<Ocean::Direction> directions;
+    for (int cell = 0; cell < ocean.num_cells; ++cell) {
+        if (ocean.grid.get(cell) != static_cast<int>(Ocean::Occupy::Empty)) {
+            agents.push_back(cell);
+            directions.push_back(static_cast<Ocean::Direction>(random_int(0, 8)));
+        }
+    }
+    result.agents = static_cast<long long>(agents.size());
+
+    long long checksum = 0;
+    auto pass = [&] {
+        for (std::size_t k = 0; k < agents.size(); ++k) {
+            int i = agents[k] / ocean.num_cols;
+            int j = agents[k] % ocean.num_cols;
+            Ocean::MoveResult moved = ocean.move(i, j, static_cast<Ocean::Occupy>(ocean.grid.get(agents[k])), directions[k]);
+            checksum += moved.new_i * 3 + moved.new_j + static_cast<int>(moved.new_obj);
+        }
+    };
+    pass();
+
+    time_iterations(limits, pass, result);
+
+    const double calls = static_cast<double>(result.iterations) * static_cast<double>(agents.size());
+    result.ns_per_agent_move = calls > 0 ? result.seconds * 1e9 / calls : 0.;
+    benchmark_sink = checksum;
+    return result;
+}
+
+/**
+ * @brief times a full recount with Ocean::population()
+ */
+BenchResult bench_population(const BenchCase& setup, const BenchLimits& limits, std::uint64_t seed) {
+    Ocean ocean = make_ocean(setup, seed);
+    BenchResult result{"population", setup, 1};
+    result.agents = static_cast<long long>(ocean.num_turtle) + ocean.num_trash + ocean.num_ship;
+
+    long long checksum = 0;
+    auto pass = [&] {
+        auto [turtles, trash, ships] = ocean.population(ocean.grid);
+        checksum += turtles + trash + ships;
+    };
+    pass();
+
+    time_iterations(limits, pass, result);
+
+    result.cells_per_sec = static_cast<double>(result.iterations) * ocean.num_cells / result.seconds;
+    benchmark_sink = checksum;
+    return result;
+}
+
+/**
+ * @brief times set_dummy_grid(): exact-count placement of the case's populations on an empty grid
+ */
+BenchResult bench_placement(const BenchCase& setup, ThreadPool& pool, const BenchLimits& limits, std::uint64_t seed) {
+    seed_random(static_cast<unsigned int>(seed));
+    const double total = setup.mix.turtle + setup.mix.trash + setup.mix.ship;
+    const double cells = static_cast<double>(setup.size) * setup.size * setup.density / total;
+    Ocean ocean(setup.size, setup.size, static_cast<int>(cells * setup.mix.turtle), static_cast<int>(cells * setup.mix.trash),
+                static_cast<int>(cells * setup.mix.ship), setup.layout);
+    ocean.set_thread_pool(&pool);
+    BenchResult result{"placement", setup, pool.size()};
+    result.agents = static_cast<long long>(ocean.num_turtle) + ocean.num_trash + ocean.num_ship;
+    ocean.set_dummy_grid();
+
+    time_iterations(limits, [&] { ocean.set_dummy_grid(); }, result);
+
+    result.cells_per_sec = static_cast<double>(result.iterations) * ocean.num_cells / result.seconds;
+    benchmark_sink = ocean.num_turtle + ocean.num_trash + ocean.num_ship;
+    return result;
+}
+
+/**
+ * @brief times DensityOcean::update_grid() on the coarse-grained grid of the case: cells/sec and ns per agent move of the ocean it stands for
+ */
+BenchResult bench_mean_field(const BenchCase& setup, ThreadPool& pool, const BenchLimits& limits, std::uint64_t seed, int block) {
+    const Ocean agents = make_ocean(setup, seed);
+    DensityOcean fields(agents, block);
+    fields.pool = &pool;
+    BenchResult result{"mean_field", setup, pool.size()};
+    result.agents = static_cast<long long>(agents.num_turtle) + agents.num_trash + agents.num_ship;
+    fields.update_grid();
+
+    double agent_moves = 0.;
+    time_iterations(limits, [&] {
+        agent_moves += fields.population(Ocean::Occupy::Turtle) + fields.population(Ocean::Occupy::Trash) + fields.population(Ocean::Occupy::Ship);
+        fields.update_grid();
+    }, result);
+
+    result.ns_per_agent_move = agent_moves > 0. ? result.seconds * 1e9 / agent_moves : 0.;
+    result.cells_per_sec = static_cast<double>(result.iterations) * agents.num_cells / result.seconds;
+    benchmark_sink = static_cast<long long>(fields.population(Ocean::Occupy::Trash));
+    return result;
+}
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - Output
+ * @section BenchOutput Output
+ * Results are printed as CSV with a header row, or as JSON Lines with one object per result. Metrics that don't apply are empty / null.
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @brief name of an engine for the output
+ */
+const char* engine_name(Ocean::Engine engine) {
+    switch (engine) {
+        case Ocean::Engine::Sparse: return "sparse";
+        case Ocean::Engine::Kinetic: return "kinetic";
+        default: return "tiled";
+    }
+}
+
+/**
+ * @brief name of a layout for the output
+ */
+const char* layout_name(GridLayout layout) {
+    switch (layout) {
+        case GridLayout::Int: return "int";
+        case GridLayout::Bitboard: return "bitboard";
+        case GridLayout::Chunked: return "chunked";
+        default: return "byte";
+    }
+}
+
+/**
+ * @brief prints the CSV header row
+ */
+void print_csv_header() {
+    std::cout << "benchmark,engine,layout,threads,rows,cols,density,mix,agents,iterations,seconds,ns_per_agent_move,cells_per_sec,allocs_per_step,simd\n";
+}
+
+/**
+ * @brief prints one result as a CSV row or a JSON object
+ */
+void print_result(const BenchResult& result, bool json) {
+    const BenchCase& setup = result.setup;
+    // metrics that don't apply to a benchmark are negative:
+    auto metric = [&](double value) {
+        if (value >= 0.) {
+            std::cout << value;
+        } else if (json) {
+            std::cout << "null";
+        }
+    };
+    // only update_grid runs an engine:
+    const bool has_engine = result.benchmark == "update_grid";
+    // and only its tiled engine on a byte grid has vector kernels:
+    const bool has_simd = has_engine and setup.engine == Ocean::Engine::Tiled and setup.layout == GridLayout::Byte;
+    if (json) {
+        std::cout << "{\"benchmark\":\"" << result.benchmark << "\",\"engine\":";
+        if (has_engine) {
+            std::cout << '"' << engine_name(setup.engine) << '"';
+        } else {
+            std::cout << "null";
+        }
+        std::cout << ",\"layout\":\"" << layout_name(setup.layout) << "\",\"threads\":" << result.threads << ",\"rows\":" << setup.size << ",\"cols\":" << setup.size << ",\"density\":" << setup.density
+                  << ",\"mix\":\"" << setup.mix.name << "\",\"agents\":" << result.agents << ",\"iterations\":" << result.iterations
+                  << ",\"seconds\":" << result.seconds << ",\"ns_per_agent_move\":";
+        metric(result.ns_per_agent_move);
+        std::cout << ",\"cells_per_sec\":";
+        metric(result.cells_per_sec);
+        std::cout << ",\"allocs_per_step\":" << result.allocations_per_step << ",\"simd\":";
+        if (has_simd) {
+            std::cout << '"' << simd_level_name(setup.simd) << '"';
+        } else {
+            std::cout << "null";
+        }
+        std::cout << "}\n";
+    } else {
+        std::cout << result.benchmark << ',' << (has_engine ? engine_name(setup.engine) : "") << ',' << layout_name(setup.layout) << ',' << result.threads << ','
+                  << setup.size << ',' << setup.size << ',' << setup.density << ',' << setup.mix.name << ',' << result.agents << ','
+                  << result.iterations << ',' << result.seconds << ',';
+        metric(result.ns_per_agent_move);
+        std::cout << ',';
+        metric(result.cells_per_sec);
+        std::cout << ',' << result.allocations_per_step << ',' << (has_simd ? simd_level_name(setup.simd) : "") << '\n';
+    }
+    std::cout.flush();
+}
+
+/**
+ * ***********************************************************************************************************************************************************************
+ * SECTION - main
+ * @section BenchMain main
+ * ***********************************************************************************************************************************************************************
+ */
+/**
+ * @brief command line options of ocean_bench
+ */
+struct BenchOptions {
+    std::vector<int> sizes{64, 256, 1024, 4096, 8192}; ///< grid edge lengths
+    std::vector<double> densities{0.01, 0.1}; ///< occupied fractions
+    std::vector<SpeciesMix> mixes{SpeciesMix{}, SpeciesMix{1., 1., 1., "1:1:1"}}; ///< species mixes
+    std::vector<Ocean::Engine> engines{Ocean::Engine::Tiled, Ocean::Engine::Sparse}; ///< engines of update_grid
+    std::vector<GridLayout> layouts{GridLayout::Byte}; ///< grid layouts
+    std::vector<SimdLevel> simds{supported_simd_level()}; ///< vector kernels of the tiled engine on a byte grid
+    std::vector<std::string> benchmarks{"update_grid", "update_grid_fixed", "move", "population"}; ///< benchmarks to run
+    int threads{1}; ///< threads of the pool used by update_grid
+    int block{16}; ///< block size of mean_field
+    BenchLimits limits; ///< timed loop limits
+    std::uint64_t seed{1}; ///< seed of every case
+    bool json{false}; ///< JSON Lines instead of CSV
+};
+
+/**
+ * @brief splits a comma separated list
+ */
+std::vector<std::string> split_list(const std::string& value) {
+    std::vector<std::string> items;
+    std::size_t begin = 0;
+    while (begin <= value.size()) {
+        std::size_t end = value.find(',', begin);
+        if (end == std::string::npos) {
+            end = value.size();
+        }
+        items.push_back(value.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return items;
+}
+
+/**
+ * @brief parses a species mix such as "12:25:1"
+ * @throws std::invalid_argument if it isn't three non-negative numbers separated by ':' with a positive sum
+ */
+SpeciesMix parse_mix(const std::string& value) {
+    SpeciesMix mix;
+    mix.name = value;
+    std::size_t first = value.find(':');
+    std::size_t second = value.find(':', first + 1);
+    if (first == std::string::npos or second == std::string::npos) {
+        throw std::invalid_argument("species mix must look like turtle:trash:ship");
+    }
+    mix.turtle = std::stod(value.substr(0, first));
+    mix.trash = std::stod(value.substr(first + 1, second - first - 1));
+    mix.ship = std::stod(value.substr(second + 1));
+    if (mix.turtle < 0. or mix.trash < 0. or mix.ship < 0. or mix.turtle + mix.trash + mix.ship <= 0.) {
+        throw std::invalid_argument("species mix must have non-negative shares with a positive sum");
+    }
+    return mix;
+}
+
+void print_usage(const char* program) {
+    std::cerr << "usage: " << program << " [--sizes 64,256,...] [--densities 0.01,0.1] [--mixes 12:25:1,1:1:1] [--engines tiled,sparse,kinetic]"
+              << " [--layouts int,byte,bitboard,chunked] [--simd scalar,avx2,avx512] [--benchmarks update_grid,update_grid_fixed,move,population,placement,mean_field] [--block N] [--threads N] [--min-time S] [--max-iterations N]"
+              << " [--seed S] [--format csv|json]\n";
+}
+
+/**
+ * @brief parses the command line into BenchOptions
+ * @return the options, or nullopt if an option is unknown or has a bad value
+ */
+optional<BenchOptions> parse_options(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int a = 1; a < argc; ++a) {
+        std::string arg = argv[a];
+        if (a + 1 >= argc) {
+            return nullopt;
+        }
+        std::string value = argv[++a];
+        try {
+            if (arg == "--sizes") {
+                options.sizes.clear();
+                for (const std::string& item : split_list(value)) options.sizes.push_back(std::stoi(item));
+            } else if (arg == "--densities") {
+                options.densities.clear();
+                for (const std::string& item : split_list(value)) options.densities.push_back(std::stod(item));
+            } else if (arg == "--mixes") {
+                options.mixes.clear();
+                for (const std::string& item : split_list(value)) options.mixes.push_back(parse_mix(item));
+            } else if (arg == "--engines") {
+                options.engines.clear();
+                for (const std::string& item : split_list(value)) {
+                    if (item == "tiled") options.engines.push_back(Ocean::Engine::Tiled);
+                    else if (item == "sparse") options.engines.push_back(Ocean::Engine::Sparse);
+                    else if (item == "kinetic") options.engines.push_back(Ocean::Engine::Kinetic);
+                    else return nullopt;
+                }
+            } else if (arg == "--layouts") {
+                options.layouts.clear();
+                for (const std::string& item : split_list(value)) {
+                    if (item == "int") options.layouts.push_back(GridLayout::Int);
+                    else if (item == "byte") options.layouts.push_back(GridLayout::Byte);
+                    else if (item == "bitboard") options.layouts.push_back(GridLayout::Bitboard);
+                    else if (item == "chunked") options.layouts.push_back(GridLayout::Chunked);
+                    else return nullopt;
+                }
+            } else if (arg == "--simd") {
+                options.simds.clear();
+                for (const std::string& item : split_list(value)) {
+                    if (item == "auto") options.simds.push_back(supported_simd_level());
+                    else if (item == "scalar") options.simds.push_back(SimdLevel::Scalar);
+                    else if (item == "avx2") options.simds.push_back(SimdLevel::Avx2);
+                    else if (item == "avx512") options.simds.push_back(SimdLevel::Avx512);
+                    else return nullopt;
+                }
+            } else if (arg == "--benchmarks") {
+                options.benchmarks = split_list(value);
+                for (const std::string& item : options.benchmarks) {
+                    if (item != "update_grid" and item != "update_grid_fixed" and item != "move" and item != "population" and item != "placement" and item != "mean_field") return nullopt;
+                }
+            }
+            else if (arg == "--threads") options.threads = std::stoi(value);
+            else if (arg == "--block") options.block = std::stoi(value);
+            else if (arg == "--min-time") options.limits.min_seconds = std::stod(value);
+            else if (arg == "--max-iterations") options.limits.max_iterations = std::stoll(value);
+            else if (arg == "--seed") options.seed = std::stoull(value);
+            else if (arg == "--format" and (value == "csv" or value == "json")) options.json = value == "json";
+            else return nullopt;
+        } catch (const std::exception&) {
+            return nullopt;
+        }
+    }
+    if (options.threads <= 0 or options.block <= 0 or options.limits.max_iterations <= 0
+        or std::any_of(options.sizes.begin(), options.sizes.end(), [](int size) { return size <= 0; })
+        or std::any_of(options.densities.begin(), options.densities.end(), [](double density) { return density < 0. or density > 1.; })) {
+        return nullopt;
+    }
+    return options;
+}
+
+int main(int argc, char* argv[]) {
+    optional<BenchOptions> options = parse_options(argc, argv);
+    if (not options) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool pool(options->threads);
+    if (not options->json) {
+        print_csv_header();
+    }
+    for (const std::string& benchmark : options->benchmarks) {
+        for (int size : options->sizes) {
+            for (double density : options->densities) {
+                for (const SpeciesMix& mix : options->mixes) {
+                    for (GridLayout layout : options->layouts) {
+                        BenchCase setup{size, density, mix, Ocean::Engine::Tiled, layout};
+                        // only update_grid depends on the engine:
+                        if (benchmark == "move") {
+                            print_result(bench_move(setup, options->limits, options->seed), options->json);
+                            continue;
+                        }
+                        if (benchmark == "population") {
+                            print_result(bench_population(setup, options->limits, options->seed), options->json);
+                            continue;
+                        }
+                        if (benchmark == "update_grid_fixed") {
+                            // one layout, and only the compiled sizes:
+                            optional<BenchResult> result = layout == GridLayout::Byte ? bench_update_grid_fixed(setup, options->limits, options->seed) : nullopt;
+                            if (result) {
+                                print_result(*result, options->json);
+                            }
+                            continue;
+                        }
+                        if (benchmark == "placement") {
+                            print_result(bench_placement(setup, pool, options->limits, options->seed), options->json);
+                            continue;
+                        }
+                        if (benchmark == "mean_field") {
+                            // the fields don't depend on the layout of the grid they were seeded from:
+                            if (layout == GridLayout::Byte) {
+                                print_result(bench_mean_field(setup, pool, options->limits, options->seed, options->block), options->json);
+                            }
+                            continue;
+                        }
+                        for (Ocean::Engine engine : options->engines) {
+                            // the chunked layout only runs with the tiled engine:
+                            if (layout == GridLayout::Chunked and engine != Ocean::Engine::Tiled) {
+                                continue;
+                            }
+                            setup.engine = engine;
+                            if (engine != Ocean::Engine::Tiled or layout != GridLayout::Byte) {
+                                print_result(bench_update_grid(setup, pool, options->limits, options->seed), options->json);
+                                continue;
+                            }
+                            // the vector kernels, reported as the level the CPU actually runs:
+                            for (SimdLevel simd : options->simds) {
+                                setup.simd = std::min(simd, supported_simd_level());
+                                print_result(bench_update_grid(setup, pool, options->limits, options->seed), options->json);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
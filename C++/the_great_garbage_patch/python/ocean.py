@@ -0,0 +1,126 @@
+"""
+Python binding of libocean, the ocean simulation as a library (see ocean_api.h).
+
+The binding loads libocean through ctypes, so nothing has to be compiled for Python. The grid is a NumPy view of the
+simulation's own cells: reading it copies nothing, and it follows the simulation as it steps.
+
+    from ocean import Ocean
+    ocean = Ocean(1000, 1000, turtles=2000, trash=8000, ships=50, threads=4)
+    ocean.seed(42)
+    ocean.step(10_000)
+    print(ocean.population, (ocean.grid == Ocean.TRASH).sum())
+
+The library is looked up in $OCEAN_LIBRARY, next to this file, and in ../build.
+"""
+import ctypes
+import os
+from pathlib import Path
+
+import numpy as np
+
+API_VERSION = 1
+
+
+def _load_library():
+    """loads libocean and declares the signatures of the C API"""
+    here = Path(__file__).resolve().parent
+    names = ["libocean.so", "libocean.dylib", "ocean.dll"]
+    candidates = [Path(os.environ["OCEAN_LIBRARY"])] if "OCEAN_LIBRARY" in os.environ else []
+    for directory in (here, here.parent / "build"):
+        candidates += [directory / name for name in names]
+    for candidate in candidates:
+        if candidate.is_file():
+            library = ctypes.CDLL(str(candidate))
+            break
+    else:
+        raise OSError("libocean not found, build it with cmake or set OCEAN_LIBRARY")
+
+    handle = ctypes.c_void_p
+    library.ocean_api_version.restype = ctypes.c_int
+    library.ocean_api_version.argtypes = []
+    library.ocean_last_error.restype = ctypes.c_char_p
+    library.ocean_last_error.argtypes = []
+    library.ocean_create.restype = handle
+    library.ocean_create.argtypes = [ctypes.c_int] * 6
+    library.ocean_seed.restype = ctypes.c_int
+    library.ocean_seed.argtypes = [handle, ctypes.c_uint64]
+    library.ocean_step.restype = ctypes.c_int
+    library.ocean_step.argtypes = [handle, ctypes.c_int]
+    library.ocean_population.restype = ctypes.c_int
+    library.ocean_population.argtypes = [handle] + [ctypes.POINTER(ctypes.c_int)] * 3
+    library.ocean_steps.restype = ctypes.c_uint64
+    library.ocean_steps.argtypes = [handle]
+    library.ocean_grid.restype = ctypes.POINTER(ctypes.c_int8)
+    library.ocean_grid.argtypes = [handle, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
+    library.ocean_destroy.restype = None
+    library.ocean_destroy.argtypes = [handle]
+
+    if library.ocean_api_version() != API_VERSION:
+        raise OSError(f"libocean has API version {library.ocean_api_version()}, this binding needs {API_VERSION}")
+    return library
+
+
+_library = _load_library()
+
+
+def _check(status):
+    """raises the library's last error for a negative status"""
+    if status < 0:
+        message = _library.ocean_last_error().decode()
+        raise (ValueError if status == -1 else RuntimeError)(message)
+
+
+class _Handle:
+    """owns an ocean_t, destroys it when the last Ocean or grid view referring to it is gone"""
+
+    def __init__(self, value):
+        self.value = value
+
+    def __del__(self):
+        _library.ocean_destroy(self.value)
+
+
+class Ocean:
+    """one simulation, with its own threads. the cells hold EMPTY, TURTLE, TRASH or SHIP"""
+
+    EMPTY, TURTLE, TRASH, SHIP = -1, 0, 1, 2
+
+    def __init__(self, rows, cols, turtles=40, trash=40, ships=14, threads=1):
+        created = _library.ocean_create(rows, cols, turtles, trash, ships, threads)
+        if not created:
+            raise ValueError(_library.ocean_last_error().decode())
+        self._owner = _Handle(created)
+        self._handle = created
+        rows_out, cols_out = ctypes.c_int(), ctypes.c_int()
+        cells = _library.ocean_grid(self._handle, ctypes.byref(rows_out), ctypes.byref(cols_out))
+        # the buffer keeps the handle alive, so the view can't outlive the cells it points at:
+        buffer = (ctypes.c_int8 * (rows_out.value * cols_out.value)).from_address(ctypes.addressof(cells.contents))
+        buffer._owner = self._owner
+        self._grid = np.frombuffer(buffer, dtype=np.int8).reshape(rows_out.value, cols_out.value)
+        # the engines keep state derived from the cells, writes would corrupt it:
+        self._grid.flags.writeable = False
+
+    def seed(self, seed):
+        """places a fresh initial grid and restarts at step 0, the same seed gives the same run as `ocean --seed`"""
+        _check(_library.ocean_seed(self._handle, seed))
+
+    def step(self, steps=1):
+        """simulates steps steps"""
+        _check(_library.ocean_step(self._handle, steps))
+
+    @property
+    def population(self):
+        """(turtles, trash, ships)"""
+        turtles, trash, ships = ctypes.c_int(), ctypes.c_int(), ctypes.c_int()
+        _check(_library.ocean_population(self._handle, ctypes.byref(turtles), ctypes.byref(trash), ctypes.byref(ships)))
+        return turtles.value, trash.value, ships.value
+
+    @property
+    def steps(self):
+        """steps simulated since the last seed()"""
+        return _library.ocean_steps(self._handle)
+
+    @property
+    def grid(self):
+        """read-only rows x cols int8 view of the cells, updated in place by step() and seed()"""
+        return self._grid
@@ -0,0 +1,29 @@
+# a run interrupted by a checkpoint and resumed without any options but the engine and layout must end in the same checkpoint as the uninterrupted run.
+# the idle chances differ from the defaults, so they have to come back from the checkpoint.
+# usage: cmake -D OCEAN=<path to ocean> -D WORK_DIR=<scratch directory> -P checkpoint_resume.cmake
+
+set( run_options --headless --rows 101 --cols 97 --seed 3 --turtle-idle 0.6 --trash-idle 0.9 --ship-idle 0.35 )
+file( MAKE_DIRECTORY ${WORK_DIR} )
+
+function( run_ocean )
+    execute_process( COMMAND ${OCEAN} ${ARGN} RESULT_VARIABLE result OUTPUT_QUIET )
+    if( NOT result EQUAL 0 )
+        message( FATAL_ERROR "ocean ${ARGN} failed: ${result}" )
+    endif()
+endfunction()
+
+# engine:layout, the kinetic engine redraws its pending attempts at every step, so it resumes exactly as well:
+foreach( run tiled:byte tiled:bitboard kinetic:byte )
+    string( REPLACE ":" ";" run_parts ${run} )
+    list( GET run_parts 0 engine )
+    list( GET run_parts 1 layout )
+    set( name ${engine}_${layout} )
+    run_ocean( ${run_options} --engine ${engine} --layout ${layout} --steps 40 --save-checkpoint ${WORK_DIR}/${name}_full.ck )
+    run_ocean( ${run_options} --engine ${engine} --layout ${layout} --steps 20 --save-checkpoint ${WORK_DIR}/${name}_half.ck )
+    run_ocean( --headless --engine ${engine} --layout ${layout} --steps 20 --load-checkpoint ${WORK_DIR}/${name}_half.ck --save-checkpoint ${WORK_DIR}/${name}_resumed.ck )
+    execute_process( COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK_DIR}/${name}_full.ck ${WORK_DIR}/${name}_resumed.ck
+                     RESULT_VARIABLE different )
+    if( different )
+        message( FATAL_ERROR "${engine}, ${layout}: the resumed run differs from the uninterrupted run" )
+    endif()
+endforeach()
@@ -0,0 +1,7 @@
+# a run that can't write its output has to report it and exit with EXIT_FAILURE, not crash and not succeed.
+# usage: cmake -D COMMAND=<ocean and its arguments, ;-separated> -P expect_failure.cmake
+
+execute_process( COMMAND ${COMMAND} RESULT_VARIABLE result OUTPUT_QUIET ERROR_VARIABLE errors )
+if( NOT result STREQUAL "1" )
+    message( FATAL_ERROR "expected exit code 1, got ${result}: ${errors}" )
+endif()
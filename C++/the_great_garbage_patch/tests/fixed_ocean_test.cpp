@@ -0,0 +1,52 @@
+/**
+ * @authors Jiwoong "Alex" Choi
+ * @date 2024.12.11
+ * @file fixed_ocean_test.cpp
+ * @brief checks that FixedOcean steps bit-identically to Ocean, for every boundary, on sizes with and without a multiple of 8 cells
+ * @details prints the first case that differs and exits with EXIT_FAILURE, run by ctest
+ */
+#include "ocean.hpp"
+
+/**
+ * @brief runs an Ocean and a FixedOcean copied from it side by side
+ * @tparam Rows rows of the grid
+ * @tparam Cols columns of the grid
+ * @tparam Bound boundary of both
+ * @param steps steps to run
+ * @param seed seed of the initial grid and the step loop
+ * @return true if the grids and populations agree after every step
+ */
+template <int Rows, int Cols, Ocean::Boundary Bound>
+bool matches(int steps, std::uint64_t seed) {
+    seed_random(static_cast<unsigned int>(seed));
+    Ocean ocean(Rows, Cols, Rows * Cols / 20, Rows * Cols / 10, Rows * Cols / 100);
+    ocean.set_boundary(Bound);
+    ocean.set_dummy_grid();
+    ocean.seed(seed);
+    ocean.set_tile_size(16, 16);
+    auto fixed = std::make_unique<FixedOcean<Rows, Cols, Bound>>(ocean);
+
+    for (int t = 1; t <= steps; ++t) {
+        ocean.update_grid();
+        fixed->update_grid();
+        for (int cell = 0; cell < Rows * Cols; ++cell) {
+            if (ocean.grid.get(cell) != fixed->cells[cell]) {
+                std::cerr << Rows << " x " << Cols << ", boundary " << static_cast<int>(Bound) << ": cell " << cell << " differs after step " << t << '\n';
+                return false;
+            }
+        }
+        if (ocean.num_turtle != fixed->num_turtle or ocean.num_trash != fixed->num_trash or ocean.num_ship != fixed->num_ship) {
+            std::cerr << Rows << " x " << Cols << ", boundary " << static_cast<int>(Bound) << ": populations differ after step " << t << '\n';
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    using Boundary = Ocean::Boundary;
+    const bool passed = matches<64, 48, Boundary::Reflecting>(60, 1) and matches<64, 48, Boundary::Periodic>(60, 2)
+                    and matches<64, 48, Boundary::Absorbing>(60, 3) and matches<37, 53, Boundary::Reflecting>(60, 4)
+                    and matches<37, 53, Boundary::Periodic>(60, 5) and matches<37, 53, Boundary::Absorbing>(60, 6);
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}